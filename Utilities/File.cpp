@@ -978,6 +978,34 @@ bool fs::copy_file(const std::string& from, const std::string& to, bool overwrit
 #endif
 }
 
+bool fs::create_hard_link(const std::string& from, const std::string& to)
+{
+	const auto device = get_virtual_device(from);
+
+	if (device != get_virtual_device(to) || device) // TODO
+	{
+		fmt::throw_exception("fs::create_hard_link() for virtual devices not implemented.\nFrom: %s\nTo: %s", from, to);
+	}
+
+#ifdef _WIN32
+	if (!CreateHardLinkW(to_wchar(to).get(), to_wchar(from).get(), nullptr))
+	{
+		g_tls_error = to_error(GetLastError());
+		return false;
+	}
+
+	return true;
+#else
+	if (::link(from.c_str(), to.c_str()) != 0)
+	{
+		g_tls_error = to_error(errno);
+		return false;
+	}
+
+	return true;
+#endif
+}
+
 bool fs::remove_file(const std::string& path)
 {
 	if (auto device = get_virtual_device(path))
@@ -215,6 +215,9 @@ namespace fs
 	// Copy file contents
 	bool copy_file(const std::string& from, const std::string& to, bool overwrite);
 
+	// Create hard link to an existing file (target must not exist)
+	bool create_hard_link(const std::string& from, const std::string& to);
+
 	// Delete file
 	bool remove_file(const std::string& path);
 
@@ -39,9 +39,11 @@
 #include <array>
 #include <functional>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 #include <util/v128.hpp>
 
 #if defined(ARCH_X64)
@@ -52,13 +54,30 @@ using native_asm = asmjit::a64::Assembler;
 using native_args = std::array<asmjit::a64::Gp, 4>;
 #endif
 
+// Host code offset -> guest address entry (line table for profilers)
+struct jit_line_info
+{
+	u32 offset; // Offset from the function start
+	u32 addr; // Guest instruction address
+};
+
+// Check if perf jitdump is being recorded (line tables are only needed in this case)
+bool jit_dump_enabled();
+
 void jit_announce(uptr func, usz size, std::string_view name);
 
+void jit_announce(uptr func, usz size, std::string_view name, std::string_view source, std::span<const jit_line_info> lines);
+
 void jit_announce(auto* func, usz size, std::string_view name)
 {
 	jit_announce(uptr(func), size, name);
 }
 
+void jit_announce(auto* func, usz size, std::string_view name, std::string_view source, std::span<const jit_line_info> lines)
+{
+	jit_announce(uptr(func), size, name, source, lines);
+}
+
 enum class jit_class
 {
 	ppu_code,
@@ -80,6 +99,22 @@ struct jit_runtime_base
 	virtual uchar* _alloc(usz size, usz align) noexcept = 0;
 };
 
+// Code heap occupancy and reclamation counters
+struct jit_code_stats
+{
+	u64 code_used; // Permanent code bytes (including reclaimable segments)
+	u64 code_limit;
+	u32 segments; // Reclaimable segments
+	u32 free_segments;
+	u32 pending_segments; // Fully retired, waiting for collect()
+	u32 pinned_segments; // Recycled for permanent code
+	u64 live_bytes; // Reclaimable bytes not retired
+	u64 retired_bytes; // Total retired
+	u64 collected_segments; // Total recycled
+	u64 collections;
+	u64 deferred_collections; // Skipped because a reclaim_guard was alive
+};
+
 // ASMJIT runtime for emitting code in a single 2G region
 struct jit_runtime final : jit_runtime_base
 {
@@ -92,6 +127,34 @@ struct jit_runtime final : jit_runtime_base
 	// Allocate memory
 	static u8* alloc(usz size, usz align, bool exec = true) noexcept;
 
+	// Allocate executable memory in a reclaimable segment (falls back to alloc() if none is available)
+	static u8* alloc_reclaimable(usz size, usz align) noexcept;
+
+	// Return memory from alloc_reclaimable() once it's unreachable (ignores other pointers), returns needs_collect()
+	static bool retire(const void* ptr) noexcept;
+
+	// Check if enough code segments are fully retired to be worth a collect()
+	static bool needs_collect() noexcept;
+
+	// Recycle fully retired segments, must be called when no thread can be executing retired code
+	// Does nothing while a reclaim_guard is alive
+	static usz collect() noexcept;
+
+	// Keeps collect() from recycling segments, for code which compares or publishes pointers to reclaimable code
+	// Without it, a retired pointer could be recycled and handed out again between loading and using it (ABA)
+	struct reclaim_guard
+	{
+		reclaim_guard() noexcept;
+		reclaim_guard(const reclaim_guard&) = delete;
+		reclaim_guard& operator=(const reclaim_guard&) = delete;
+		~reclaim_guard();
+	};
+
+	static jit_code_stats get_code_stats() noexcept;
+
+	// Log code heap occupancy and reclamation counters
+	static void report_code_stats() noexcept;
+
 	// Should be called at least once after global initialization
 	static void initialize();
 
@@ -508,7 +571,11 @@ class jit_compiler final
 	// Arch
 	std::string m_cpu{};
 
+	// Constructor flags
+	u32 m_flags = 0;
+
 public:
+	// Flags: 0x1 = auxiliary (object writing), 0x2 = large code model, 0x4 = write objects uncompressed
 	jit_compiler(const std::unordered_map<std::string, u64>& _link, const std::string& _cpu, u32 flags = 0);
 	~jit_compiler();
 
@@ -532,6 +599,12 @@ public:
 	// Add object (path to obj file)
 	void add(const std::string& path);
 
+	// Add object loaded with load_object() (path is only used for diagnostics), returns false if it's damaged
+	bool add(std::vector<u8> object, const std::string& path);
+
+	// Read and decompress object file, can be used from any thread (empty on failure)
+	static std::vector<u8> load_object(const std::string& path);
+
 	// Update global mapping for a single value
 	void update_global_mapping(const std::string& name, u64 addr);
 
@@ -4,18 +4,233 @@
 #include "StrFmt.h"
 #include "File.h"
 #include "util/logs.hpp"
+#include "mutex.h"
 #include "util/vm.hpp"
 #include "util/asm.hpp"
 #include "util/v128.hpp"
 #include "util/simd.hpp"
 
 #ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+
 #define CAN_OVERCOMMIT
 #endif
 
 LOG_CHANNEL(jit_log, "JIT");
 
+#ifdef __linux__
+// Writer of perf jitdump file (jit-<pid>.dump), enabled if directory JITDUMP exists in cache
+// Usage: perf record -k mono ...; perf inject --jit -i perf.data -o perf.jit.data
+struct jit_dump_file
+{
+	enum : u32
+	{
+		code_load = 0,
+		code_debug_info = 2,
+	};
+
+	struct header_t
+	{
+		u32 magic;
+		u32 version;
+		u32 total_size;
+		u32 elf_mach;
+		u32 pad1;
+		u32 pid;
+		u64 timestamp;
+		u64 flags;
+	};
+
+	struct record_t
+	{
+		u32 id;
+		u32 total_size;
+		u64 timestamp;
+	};
+
+	struct code_load_t
+	{
+		record_t rec;
+		u32 pid;
+		u32 tid;
+		u64 vma;
+		u64 code_addr;
+		u64 code_size;
+		u64 code_index;
+	};
+
+	struct debug_info_t
+	{
+		record_t rec;
+		u64 code_addr;
+		u64 nr_entry;
+	};
+
+	struct debug_entry_t
+	{
+		u64 code_addr;
+		u32 line;
+		u32 discrim;
+	};
+
+	fs::file file;
+	void* marker = nullptr;
+	u64 code_index = 0;
+	shared_mutex mutex;
+
+	static u64 timestamp()
+	{
+		// Must match perf clock (CLOCK_MONOTONIC with -k mono)
+		timespec ts{};
+		::clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec * 1'000'000'000ull + ts.tv_nsec;
+	}
+
+	jit_dump_file()
+	{
+		const std::string dir = fs::get_cache_dir() + "JITDUMP/";
+
+		if (!fs::is_dir(dir))
+		{
+			return;
+		}
+
+		const std::string path = fmt::format("%sjit-%d.dump", dir, getpid());
+
+		if (!file.open(path, fs::read + fs::rewrite))
+		{
+			jit_log.error("Failed to create %s (%s)", path, fs::g_tls_error);
+			return;
+		}
+
+		header_t header{};
+		header.magic = 0x4A695444;
+		header.version = 1;
+		header.total_size = sizeof(header_t);
+#if defined(ARCH_X64)
+		header.elf_mach = 62; // EM_X86_64
+#elif defined(ARCH_ARM64)
+		header.elf_mach = 183; // EM_AARCH64
+#endif
+		header.pid = getpid();
+		header.timestamp = timestamp();
+		file.write(header);
+
+		// perf discovers the file by its executable mapping
+		marker = ::mmap(nullptr, utils::c_page_size, PROT_READ | PROT_EXEC, MAP_PRIVATE, file.get_handle(), 0);
+
+		if (marker == MAP_FAILED)
+		{
+			jit_log.error("Failed to map %s (errno=%d)", path, errno);
+			marker = nullptr;
+			file.close();
+			return;
+		}
+
+		jit_log.notice("Writing perf jitdump to %s", path);
+	}
+
+	jit_dump_file(const jit_dump_file&) = delete;
+
+	jit_dump_file& operator=(const jit_dump_file&) = delete;
+
+	~jit_dump_file()
+	{
+		if (marker)
+		{
+			::munmap(marker, utils::c_page_size);
+		}
+	}
+
+	void write(uptr func, usz size, std::string_view name, std::string_view source, std::span<const jit_line_info> lines)
+	{
+		const u32 tid = static_cast<u32>(::syscall(SYS_gettid));
+
+		std::string data;
+
+		if (!lines.empty() && !source.empty())
+		{
+			// Debug info must precede the code load record
+			debug_info_t info{};
+			info.rec.id = code_debug_info;
+			info.code_addr = func;
+			info.nr_entry = lines.size();
+
+			data.append(reinterpret_cast<const char*>(&info), sizeof(info));
+
+			for (const jit_line_info& line : lines)
+			{
+				const debug_entry_t entry{func + line.offset, line.addr, 0};
+				data.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+				data.append(source.data(), source.size());
+				data += '\0';
+			}
+
+			// Records are padded to 8 bytes
+			data.resize(utils::align(data.size(), 8));
+
+			record_t& rec = *reinterpret_cast<record_t*>(data.data());
+			rec.total_size = ::size32(data);
+		}
+
+		const usz load_pos = data.size();
+
+		code_load_t load{};
+		load.rec.id = code_load;
+		load.rec.total_size = ::narrow<u32>(sizeof(load) + name.size() + 1 + size);
+		load.pid = getpid();
+		load.tid = tid;
+		load.vma = func;
+		load.code_addr = func;
+		load.code_size = size;
+
+		data.append(reinterpret_cast<const char*>(&load), sizeof(load));
+		data.append(name.data(), name.size());
+		data += '\0';
+		data.append(reinterpret_cast<const char*>(func), size);
+
+		std::lock_guard lock(mutex);
+
+		// Set index and timestamps in order
+		const u64 stamp = timestamp();
+
+		if (load_pos)
+		{
+			reinterpret_cast<record_t*>(data.data())->timestamp = stamp;
+		}
+
+		reinterpret_cast<code_load_t*>(data.data() + load_pos)->rec.timestamp = stamp;
+		reinterpret_cast<code_load_t*>(data.data() + load_pos)->code_index = code_index++;
+
+		file.write(data);
+	}
+};
+
+static jit_dump_file& get_jit_dump()
+{
+	static jit_dump_file s_dump;
+	return s_dump;
+}
+#endif
+
+bool jit_dump_enabled()
+{
+#ifdef __linux__
+	return get_jit_dump().marker != nullptr;
+#else
+	return false;
+#endif
+}
+
 void jit_announce(uptr func, usz size, std::string_view name)
+{
+	jit_announce(func, size, name, {}, {});
+}
+
+void jit_announce(uptr func, usz size, std::string_view name, std::string_view source, std::span<const jit_line_info> lines)
 {
 #ifdef __linux__
 	static const struct tmp_perf_map
@@ -51,6 +266,13 @@ void jit_announce(uptr func, usz size, std::string_view name)
 		return;
 	}
 
+#ifdef __linux__
+	if (auto& dump = get_jit_dump(); dump.marker && !name.empty())
+	{
+		dump.write(func, size, name, source, lines);
+	}
+#endif
+
 	// If directory ASMJIT doesn't exist, nothing will be written
 	static constexpr u64 c_dump_size = 0x1'0000'0000;
 	static constexpr u64 c_index_size = c_dump_size / 16;
@@ -201,6 +423,87 @@ static u8* add_jit_memory(usz size, usz align)
 	return pointer + pos;
 }
 
+// Reclaimable code is allocated in fixed size segments carved from the code subrange
+static constexpr u64 c_code_segment_size = 0x100'0000;
+
+// Number of fully retired segments which makes collect() worthwhile
+static constexpr u32 c_code_collect_threshold = 4;
+
+// Allocation header preceding reclaimable code (holds allocation size, 0 if retired)
+static constexpr u64 c_code_header_size = 16;
+
+struct jit_code_segment
+{
+	enum class state : u8
+	{
+		open, // Used for reclaimable allocations
+		sealed, // Full, waiting for allocations to be retired
+		pending, // Fully retired, waiting for collect()
+		free,
+		pinned, // Recycled for permanent allocations
+	};
+
+	u8* base;
+	u64 used;
+	u64 live;
+	state st;
+};
+
+struct jit_code_heap
+{
+	shared_mutex mutex;
+
+	// Ordered by base address (new segments are taken from the bump allocator)
+	std::vector<jit_code_segment> segments;
+
+	usz current = umax;
+	usz pinned = umax;
+
+	atomic_t<u32> pending = 0;
+
+	// Number of alive reclaim_guard objects
+	atomic_t<u32> guards = 0;
+
+	u64 retired_bytes = 0;
+	u64 collected_segments = 0;
+	u64 collections = 0;
+	u64 deferred_collections = 0;
+
+	// Find segment in given state
+	usz find(jit_code_segment::state st) const
+	{
+		for (usz i = 0; i < segments.size(); i++)
+		{
+			if (segments[i].st == st)
+			{
+				return i;
+			}
+		}
+
+		return umax;
+	}
+
+	// Allocate from segment, returns nullptr if it doesn't fit
+	static u8* bump(jit_code_segment& seg, usz size, usz align, u64 header)
+	{
+		const u64 pos = utils::align(seg.used + header, align) - header;
+
+		if (pos + header + size > c_code_segment_size)
+		{
+			return nullptr;
+		}
+
+		seg.used = pos + header + size;
+		return seg.base + pos;
+	}
+};
+
+static jit_code_heap& get_code_heap()
+{
+	static jit_code_heap s_heap;
+	return s_heap;
+}
+
 const asmjit::Environment& jit_runtime_base::environment() const noexcept
 {
 	static const asmjit::Environment g_env = asmjit::Environment::host();
@@ -252,7 +555,47 @@ u8* jit_runtime::alloc(usz size, usz align, bool exec) noexcept
 {
 	if (exec)
 	{
-		return add_jit_memory<s_code_pos, 0x0, utils::protection::wx>(size, align);
+		if ((s_code_pos & 0xffff'ffff) < 0x40000000 || (!size && !align))
+		{
+			if (u8* ptr = add_jit_memory<s_code_pos, 0x0, utils::protection::wx>(size, align))
+			{
+				return ptr;
+			}
+		}
+
+		// Code subrange is exhausted, continue in recycled segments
+		if (size > c_code_segment_size || align > c_code_segment_size)
+		{
+			return nullptr;
+		}
+
+		auto& heap = get_code_heap();
+
+		std::lock_guard lock(heap.mutex);
+
+		if (heap.pinned != umax)
+		{
+			if (u8* ptr = heap.bump(heap.segments[heap.pinned], size, align, 0))
+			{
+				return ptr;
+			}
+		}
+
+		heap.pinned = heap.find(jit_code_segment::state::free);
+
+		if (heap.pinned == umax)
+		{
+			return nullptr;
+		}
+
+		auto& seg = heap.segments[heap.pinned];
+		seg.st = jit_code_segment::state::pinned;
+		seg.used = 0;
+		seg.live = 0;
+
+		jit_log.notice("Recycled code segment at %p for permanent code", seg.base);
+
+		return heap.bump(seg, size, align, 0);
 	}
 	else
 	{
@@ -260,6 +603,213 @@ u8* jit_runtime::alloc(usz size, usz align, bool exec) noexcept
 	}
 }
 
+u8* jit_runtime::alloc_reclaimable(usz size, usz align) noexcept
+{
+	align = std::max<usz>(align, 16);
+
+	if (size + c_code_header_size + align > c_code_segment_size)
+	{
+		return alloc(size, align, true);
+	}
+
+	auto& heap = get_code_heap();
+
+	std::unique_lock lock(heap.mutex);
+
+	while (true)
+	{
+		if (heap.current != umax)
+		{
+			auto& seg = heap.segments[heap.current];
+
+			if (u8* ptr = heap.bump(seg, size, align, c_code_header_size))
+			{
+				seg.live += c_code_header_size + size;
+				write_to_ptr<u64>(ptr, c_code_header_size + size);
+				return ptr + c_code_header_size;
+			}
+
+			seg.st = seg.live ? jit_code_segment::state::sealed : jit_code_segment::state::pending;
+
+			if (!seg.live)
+			{
+				heap.pending++;
+			}
+
+			heap.current = umax;
+		}
+
+		// Reuse a free segment or take a new one
+		usz index = heap.find(jit_code_segment::state::free);
+
+		if (index == umax)
+		{
+			u8* base = nullptr;
+
+			if ((s_code_pos & 0xffff'ffff) + c_code_segment_size * 2 <= 0x40000000)
+			{
+				base = add_jit_memory<s_code_pos, 0x0, utils::protection::wx>(c_code_segment_size, 0x10000);
+			}
+
+			if (!base)
+			{
+				lock.unlock();
+				return alloc(size, align, true);
+			}
+
+			index = heap.segments.size();
+			heap.segments.emplace_back(jit_code_segment{base, 0, 0, jit_code_segment::state::free});
+		}
+
+		auto& seg = heap.segments[index];
+		seg.st = jit_code_segment::state::open;
+		seg.used = 0;
+		seg.live = 0;
+		heap.current = index;
+	}
+}
+
+bool jit_runtime::retire(const void* ptr) noexcept
+{
+	if (!ptr)
+	{
+		return false;
+	}
+
+	auto& heap = get_code_heap();
+
+	std::lock_guard lock(heap.mutex);
+
+	const auto found = std::upper_bound(heap.segments.begin(), heap.segments.end(), ptr, [](const void* p, const jit_code_segment& seg)
+	{
+		return p < seg.base;
+	});
+
+	if (found == heap.segments.begin())
+	{
+		return false;
+	}
+
+	auto& seg = *std::prev(found);
+
+	if (ptr >= seg.base + c_code_segment_size || (seg.st != jit_code_segment::state::open && seg.st != jit_code_segment::state::sealed))
+	{
+		// Permanent code
+		return false;
+	}
+
+	u8* const header = static_cast<u8*>(const_cast<void*>(ptr)) - c_code_header_size;
+	const u64 size = read_from_ptr<u64>(header);
+
+	if (!size || size > seg.live)
+	{
+		jit_log.error("Invalid or repeated retire() of %p", ptr);
+		return false;
+	}
+
+	write_to_ptr<u64>(header, 0);
+
+	seg.live -= size;
+	heap.retired_bytes += size;
+
+	if (!seg.live && seg.st == jit_code_segment::state::sealed)
+	{
+		seg.st = jit_code_segment::state::pending;
+		heap.pending++;
+	}
+
+	return heap.pending >= c_code_collect_threshold;
+}
+
+bool jit_runtime::needs_collect() noexcept
+{
+	auto& heap = get_code_heap();
+	return heap.pending >= c_code_collect_threshold && !heap.guards;
+}
+
+jit_runtime::reclaim_guard::reclaim_guard() noexcept
+{
+	// A pointer loaded after this point can't be recycled by a collect() which already checked the guards:
+	// it wasn't retired yet, and retire() has to wait for the heap mutex held by collect()
+	get_code_heap().guards++;
+}
+
+jit_runtime::reclaim_guard::~reclaim_guard()
+{
+	get_code_heap().guards--;
+}
+
+usz jit_runtime::collect() noexcept
+{
+	auto& heap = get_code_heap();
+
+	std::lock_guard lock(heap.mutex);
+
+	if (heap.guards)
+	{
+		// Retry on the next collect()
+		heap.deferred_collections++;
+		return 0;
+	}
+
+	usz count = 0;
+
+	for (usz i = 0; i < heap.segments.size(); i++)
+	{
+		auto& seg = heap.segments[i];
+
+		if (seg.st == jit_code_segment::state::pending || (seg.st == jit_code_segment::state::open && !seg.live && seg.used))
+		{
+			if (i == heap.current)
+			{
+				heap.current = umax;
+			}
+
+			seg.st = jit_code_segment::state::free;
+			seg.used = 0;
+			count++;
+		}
+	}
+
+	heap.pending = 0;
+	heap.collected_segments += count;
+	heap.collections++;
+
+	jit_log.notice("Recycled %u code segments (%u total in %u collections)", count, heap.collected_segments, heap.collections);
+	return count;
+}
+
+jit_code_stats jit_runtime::get_code_stats() noexcept
+{
+	auto& heap = get_code_heap();
+
+	reader_lock lock(heap.mutex);
+
+	jit_code_stats stats{};
+	stats.code_used = std::min<u64>(s_code_pos & 0xffff'ffff, 0x40000000);
+	stats.code_limit = 0x40000000;
+	stats.segments = ::size32(heap.segments);
+	stats.retired_bytes = heap.retired_bytes;
+	stats.collected_segments = heap.collected_segments;
+	stats.collections = heap.collections;
+	stats.deferred_collections = heap.deferred_collections;
+
+	for (const auto& seg : heap.segments)
+	{
+		switch (seg.st)
+		{
+		case jit_code_segment::state::free: stats.free_segments++; break;
+		case jit_code_segment::state::pending: stats.pending_segments++; break;
+		case jit_code_segment::state::pinned: stats.pinned_segments++; break;
+		default: break;
+		}
+
+		stats.live_bytes += seg.live;
+	}
+
+	return stats;
+}
+
 void jit_runtime::initialize()
 {
 	if (!s_code_init.empty() || !s_data_init.empty())
@@ -274,6 +824,16 @@ void jit_runtime::initialize()
 	std::memcpy(s_data_init.data(), alloc(0, 0, false), s_data_init.size());
 }
 
+void jit_runtime::report_code_stats() noexcept
+{
+	if (const auto stats = get_code_stats(); stats.segments)
+	{
+		jit_log.notice("Code heap: %u/%u MiB used, %u segments (%u free, %u pending, %u pinned), %u KiB live, %u MiB retired, %u segments recycled in %u collections (%u deferred)",
+			stats.code_used >> 20, stats.code_limit >> 20, stats.segments, stats.free_segments, stats.pending_segments, stats.pinned_segments, stats.live_bytes >> 10, stats.retired_bytes >> 20,
+			stats.collected_segments, stats.collections, stats.deferred_collections);
+	}
+}
+
 void jit_runtime::finalize() noexcept
 {
 #ifdef __APPLE__
@@ -287,6 +847,19 @@ void jit_runtime::finalize() noexcept
 	utils::memory_decommit(get_jit_memory(), 0x80000000);
 #endif
 
+	// Reclaimable segments are gone with the rest of the code
+	report_code_stats();
+
+	{
+		auto& heap = get_code_heap();
+
+		std::lock_guard lock(heap.mutex);
+		heap.segments.clear();
+		heap.current = umax;
+		heap.pinned = umax;
+		heap.pending = 0;
+	}
+
 	s_code_pos = 0;
 	s_data_pos = 0;
 
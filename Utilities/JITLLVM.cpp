@@ -38,6 +38,9 @@ LOG_CHANNEL(jit_log, "JIT");
 #include "llvm/ExecutionEngine/JITEventListener.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Object/SymbolSize.h"
+#ifdef __linux__
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#endif
 #ifdef _MSC_VER
 #pragma warning(pop)
 #else
@@ -147,6 +150,19 @@ struct JITAnnouncer : llvm::JITEventListener
 
 		const object::ObjectFile& debug_obj = *debug_obj_.getBinary();
 
+#ifdef __linux__
+		// Guest address line tables (present if the translator emitted debug info)
+		std::unique_ptr<DWARFContext> dwarf;
+
+		if (jit_dump_enabled())
+		{
+			dwarf = DWARFContext::create(debug_obj);
+		}
+
+		std::vector<jit_line_info> lines;
+		std::string source;
+#endif
+
 		for (const auto& [sym, size] : computeSymbolSizes(debug_obj))
 		{
 			Expected<object::SymbolRef::Type> type_ = sym.getType();
@@ -161,6 +177,39 @@ struct JITAnnouncer : llvm::JITEventListener
 			if (!addr)
 				continue;
 
+#ifdef __linux__
+			if (dwarf)
+			{
+				u64 section = object::SectionedAddress::UndefSection;
+
+				if (auto sec = sym.getSection(); sec && *sec != debug_obj.section_end())
+				{
+					section = sec.get()->getIndex();
+				}
+
+				lines.clear();
+				source.clear();
+
+				for (const auto& [line_addr, info] : dwarf->getLineInfoForAddressRange({*addr, section}, size))
+				{
+					if (!info.Line || (!lines.empty() && lines.back().addr == info.Line))
+					{
+						continue;
+					}
+
+					if (source.empty())
+					{
+						source = info.FileName;
+					}
+
+					lines.push_back({static_cast<u32>(line_addr - *addr), info.Line});
+				}
+
+				jit_announce(*addr, size, {name->data(), name->size()}, source, lines);
+				continue;
+			}
+#endif
+
 			jit_announce(*addr, size, {name->data(), name->size()});
 		}
 	}
@@ -315,14 +364,35 @@ struct MemoryManager2 : llvm::RTDyldMemoryManager
 	}
 };
 
+// Memory buffer owning decompressed object data
+class VectorMemoryBuffer final : public llvm::MemoryBuffer
+{
+	std::vector<u8> m_data;
+
+public:
+	VectorMemoryBuffer(std::vector<u8> data)
+		: m_data(std::move(data))
+	{
+		const auto ptr = reinterpret_cast<const char*>(m_data.data());
+		init(ptr, ptr + m_data.size(), false);
+	}
+
+	BufferKind getBufferKind() const override
+	{
+		return MemoryBuffer_Malloc;
+	}
+};
+
 // Helper class
 class ObjectCache final : public llvm::ObjectCache
 {
 	const std::string& m_path;
+	const bool m_compress;
 
 public:
-	ObjectCache(const std::string& path)
+	ObjectCache(const std::string& path, bool compress)
 		: m_path(path)
+		, m_compress(compress)
 	{
 	}
 
@@ -332,7 +402,25 @@ public:
 	{
 		std::string name = m_path;
 		name.append(_module->getName().data());
-		//fs::file(name, fs::rewrite).write(obj.getBufferStart(), obj.getBufferSize());
+
+		if (!m_compress)
+		{
+			// Stored as is, which makes loading it a plain read
+			fs::pending_file module_file(name);
+
+			if (!module_file.file || module_file.file.write(obj.getBufferStart(), obj.getBufferSize()) != obj.getBufferSize() || !module_file.commit())
+			{
+				jit_log.error("LLVM: Failed to create module file: %s (%s)", name, fs::g_tls_error);
+				return;
+			}
+
+			// Compressed objects take precedence when loading
+			fs::remove_file(name + ".gz");
+
+			jit_log.notice("LLVM: Created module: %s", _module->getName().data());
+			return;
+		}
+
 		name.append(".gz");
 
 		fs::file module_file(name, fs::rewrite);
@@ -356,41 +444,14 @@ public:
 
 	static std::unique_ptr<llvm::MemoryBuffer> load(const std::string& path)
 	{
-		if (fs::file cached{path + ".gz", fs::read})
-		{
-			const std::vector<u8> cached_data = cached.to_vector<u8>();
+		std::vector<u8> data = jit_compiler::load_object(path);
 
-			if (cached_data.empty()) [[unlikely]]
-			{
-				return nullptr;
-			}
-
-			const std::vector<u8> out = unzip(cached_data);
-
-			if (out.empty())
-			{
-				jit_log.error("LLVM: Failed to unzip module: '%s'", path);
-				return nullptr;
-			}
-
-			auto buf = llvm::WritableMemoryBuffer::getNewUninitMemBuffer(out.size());
-			std::memcpy(buf->getBufferStart(), out.data(), out.size());
-			return buf;
-		}
-
-		if (fs::file cached{path, fs::read})
+		if (data.empty())
 		{
-			if (cached.size() == 0) [[unlikely]]
-			{
-				return nullptr;
-			}
-
-			auto buf = llvm::WritableMemoryBuffer::getNewUninitMemBuffer(cached.size());
-			cached.read(buf->getBufferStart(), buf->getBufferSize());
-			return buf;
+			return nullptr;
 		}
 
-		return nullptr;
+		return std::make_unique<VectorMemoryBuffer>(std::move(data));
 	}
 
 	std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* _module) override
@@ -408,6 +469,35 @@ public:
 	}
 };
 
+std::vector<u8> jit_compiler::load_object(const std::string& path)
+{
+	if (fs::file cached{path + ".gz", fs::read})
+	{
+		const std::vector<u8> cached_data = cached.to_vector<u8>();
+
+		if (cached_data.empty()) [[unlikely]]
+		{
+			return {};
+		}
+
+		std::vector<u8> out = unzip(cached_data);
+
+		if (out.empty())
+		{
+			jit_log.error("LLVM: Failed to unzip module: '%s'", path);
+		}
+
+		return out;
+	}
+
+	if (fs::file cached{path, fs::read})
+	{
+		return cached.to_vector<u8>();
+	}
+
+	return {};
+}
+
 std::string jit_compiler::cpu(const std::string& _cpu)
 {
 	std::string m_cpu = _cpu;
@@ -511,6 +601,7 @@ std::string jit_compiler::triple2()
 jit_compiler::jit_compiler(const std::unordered_map<std::string, u64>& _link, const std::string& _cpu, u32 flags)
 	: m_context(new llvm::LLVMContext)
 	, m_cpu(cpu(_cpu))
+	, m_flags(flags)
 {
 	std::string result;
 
@@ -578,7 +669,7 @@ jit_compiler::~jit_compiler()
 
 void jit_compiler::add(std::unique_ptr<llvm::Module> _module, const std::string& path)
 {
-	ObjectCache cache{path};
+	ObjectCache cache{path, !(m_flags & 0x4)};
 	m_engine->setObjectCache(&cache);
 
 	const auto ptr = _module.get();
@@ -608,16 +699,29 @@ void jit_compiler::add(std::unique_ptr<llvm::Module> _module)
 
 void jit_compiler::add(const std::string& path)
 {
-	auto cache = ObjectCache::load(path);
+	add(load_object(path), path);
+}
 
-	if (auto object_file = llvm::object::ObjectFile::createObjectFile(*cache))
+bool jit_compiler::add(std::vector<u8> object, const std::string& path)
+{
+	if (object.empty())
 	{
-		m_engine->addObjectFile(llvm::object::OwningBinary<llvm::object::ObjectFile>(std::move(*object_file), std::move(cache)));
+		jit_log.error("ObjectCache: Adding failed (missing object): %s", path);
+		return false;
 	}
-	else
+
+	std::unique_ptr<llvm::MemoryBuffer> cache = std::make_unique<VectorMemoryBuffer>(std::move(object));
+
+	auto object_file = llvm::object::ObjectFile::createObjectFile(*cache);
+
+	if (!object_file)
 	{
-		jit_log.error("ObjectCache: Adding failed: %s", path);
+		jit_log.error("ObjectCache: Adding failed: %s (%s)", path, llvm::toString(object_file.takeError()));
+		return false;
 	}
+
+	m_engine->addObjectFile(llvm::object::OwningBinary<llvm::object::ObjectFile>(std::move(*object_file), std::move(cache)));
+	return true;
 }
 
 bool jit_compiler::check(const std::string& path)
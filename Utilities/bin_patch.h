@@ -220,6 +220,12 @@ public:
 	// Deallocate memory used by patches
 	void unload(const std::string& name);
 
+	// Check if any patch (enabled or not) exists for the specified hash
+	bool has_patches(const std::string& name) const
+	{
+		return m_map.contains(name);
+	}
+
 private:
 	// Database
 	patch_map m_map{};
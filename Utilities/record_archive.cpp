@@ -0,0 +1,576 @@
+#include "stdafx.h"
+#include "record_archive.h"
+
+#include "util/endian.hpp"
+#include "util/vm.hpp"
+
+#include <zlib.h>
+
+LOG_CHANNEL(arc_log, "ARC");
+
+namespace
+{
+	struct archive_header
+	{
+		le_t<u64> magic;
+		le_t<u32> version;
+		le_t<u32> header_size;
+		le_t<u64> index_pos; // Position of the latest index chunk (0 if none)
+		le_t<u64> index_end; // File size covered by the index
+	};
+
+	// Record chunk, followed by payload
+	struct archive_record
+	{
+		le_t<u32> tag;
+		le_t<u32> type;
+		le_t<u32> size; // Payload size in bytes
+		le_t<u32> crc; // CRC32 of payload
+		le_t<u64> key;
+	};
+
+	// Index chunk, followed by entries in file order
+	// Each chunk only covers the changes since the previous chunk of the chain
+	struct archive_index
+	{
+		le_t<u32> tag;
+		le_t<u32> count;
+		le_t<u32> crc; // CRC32 of entries
+		le_t<u32> reserved;
+		le_t<u64> prev; // Position of the previous index chunk (0 if none)
+	};
+
+	// Entry with zero pos removes the record (sorted before the records added by the same chunk)
+	struct archive_index_entry
+	{
+		le_t<u64> key;
+		le_t<u64> pos;
+		le_t<u32> type;
+		le_t<u32> size;
+	};
+}
+
+record_archive::~record_archive()
+{
+	close();
+}
+
+bool record_archive::open(const std::string& path)
+{
+	close();
+
+	std::lock_guard lock(m_mutex);
+
+	if (!m_file.open(path, fs::read + fs::write + fs::create))
+	{
+		return false;
+	}
+
+	const auto is_valid_header = [&](const archive_header& header, u64 file_size)
+	{
+		return header.magic == m_format.magic && header.version == m_format.version && header.header_size >= sizeof(archive_header) && header.header_size <= file_size;
+	};
+
+	if (archive_header header{}; m_file.size() >= sizeof(archive_header) && m_file.read(header) && !is_valid_header(header, m_file.size()))
+	{
+		// Keep the data of an unknown (possibly newer) version instead of destroying it
+		arc_log.error("%s: Unrecognized file format (version=%u), moving %s aside", m_name, header.version, path);
+
+		m_file.close();
+
+		if (!fs::rename(path, path + ".bak", true))
+		{
+			arc_log.error("%s: Failed to rename %s (%s)", m_name, path, fs::g_tls_error);
+			return false;
+		}
+
+		if (!m_file.open(path, fs::read + fs::write + fs::create + fs::trunc))
+		{
+			return false;
+		}
+	}
+
+	u64 file_size = m_file.size();
+
+	if (file_size < sizeof(archive_header))
+	{
+		// Initialize new file
+		archive_header header{};
+		header.magic = m_format.magic;
+		header.version = m_format.version;
+		header.header_size = sizeof(archive_header);
+
+		m_file.seek(0);
+
+		if (!m_file.trunc(0) || m_file.write(&header, sizeof(header)) != sizeof(header))
+		{
+			m_file.close();
+			return false;
+		}
+
+		file_size = sizeof(header);
+	}
+
+	// Map the whole file, payloads are only verified and copied out when requested
+	if (void* ptr = utils::memory_map_fd(m_file.get_handle(), file_size, utils::protection::ro))
+	{
+		m_view = static_cast<const u8*>(ptr);
+		m_view_mapped = true;
+	}
+	else
+	{
+		m_file.seek(0);
+		m_view_copy = m_file.to_vector<u8>();
+		m_view = m_view_copy.data();
+	}
+
+	m_view_size = file_size;
+
+	const auto header = read_from_ptr<archive_header>(m_view);
+
+	const auto register_record = [&](u64 pos, u32 type, u32 size, u64 key)
+	{
+		// A later record with the same key replaces one which was invalidated
+		m_entries.insert_or_assign(std::pair{type, key}, record_info{pos, key, type, size});
+	};
+
+	u64 scan_pos = header.header_size;
+	usz indexed_count = 0;
+
+	m_index_pos = 0;
+	m_index_end = header.header_size;
+
+	// Read the index chain (newest chunk first)
+	if (header.index_pos)
+	{
+		std::vector<u64> chain;
+		bool valid = header.index_end <= file_size;
+
+		for (u64 index_pos = header.index_pos, limit = header.index_end; valid && index_pos;)
+		{
+			if (index_pos < header.header_size || index_pos + sizeof(archive_index) > limit)
+			{
+				valid = false;
+				break;
+			}
+
+			const auto index = read_from_ptr<archive_index>(m_view, index_pos);
+			const u64 table_size = u64{index.count} * sizeof(archive_index_entry);
+			const u8* table = m_view + index_pos + sizeof(archive_index);
+
+			if (index.tag != m_format.index_tag || index_pos + sizeof(archive_index) + table_size > limit || index.prev >= index_pos ||
+				static_cast<u32>(crc32(0, table, ::narrow<uInt>(table_size))) != index.crc)
+			{
+				valid = false;
+				break;
+			}
+
+			chain.emplace_back(index_pos);
+			limit = index_pos;
+			index_pos = index.prev;
+		}
+
+		if (valid)
+		{
+			// Apply chunks in file order
+			for (auto it = chain.rbegin(); it != chain.rend(); it++)
+			{
+				const u64 index_pos = *it;
+				const auto index = read_from_ptr<archive_index>(m_view, index_pos);
+				const u8* table = m_view + index_pos + sizeof(archive_index);
+
+				for (u32 i = 0; i < index.count; i++)
+				{
+					const auto entry = read_from_ptr<archive_index_entry>(table, i * sizeof(archive_index_entry));
+
+					if (!entry.pos)
+					{
+						m_entries.erase(std::pair<u32, u64>{entry.type, entry.key});
+					}
+					else if (entry.pos >= header.header_size && entry.pos + sizeof(archive_record) + entry.size <= index_pos)
+					{
+						register_record(entry.pos, entry.type, entry.size, entry.key);
+					}
+				}
+			}
+
+			indexed_count = m_entries.size();
+			scan_pos = header.index_end;
+			m_index_pos = header.index_pos;
+			m_index_end = header.index_end;
+		}
+		else
+		{
+			arc_log.error("%s: Index is corrupted (0x%x), scanning all records", m_name, header.index_pos);
+			m_entries.clear();
+		}
+	}
+
+	// Scan records which were appended after the index was written
+	u64 pos = scan_pos;
+	usz scanned_count = 0;
+
+	while (pos + sizeof(u32) <= file_size)
+	{
+		const u32 tag = read_from_ptr<le_t<u32>>(m_view, pos);
+
+		if (tag == m_format.record_tag && pos + sizeof(archive_record) <= file_size)
+		{
+			const auto rec = read_from_ptr<archive_record>(m_view, pos);
+			const u64 next = pos + sizeof(archive_record) + rec.size;
+
+			if (!rec.size || rec.size > m_format.max_record_size || next > file_size ||
+				static_cast<u32>(crc32(0, m_view + pos + sizeof(archive_record), rec.size)) != rec.crc)
+			{
+				break;
+			}
+
+			register_record(pos, rec.type, rec.size, rec.key);
+			scanned_count++;
+			pos = next;
+			continue;
+		}
+
+		if (tag == m_format.index_tag && pos + sizeof(archive_index) <= file_size)
+		{
+			// Skip outdated index
+			const auto index = read_from_ptr<archive_index>(m_view, pos);
+			const u64 next = pos + sizeof(archive_index) + u64{index.count} * sizeof(archive_index_entry);
+
+			if (next > file_size)
+			{
+				break;
+			}
+
+			pos = next;
+			continue;
+		}
+
+		break;
+	}
+
+	if (pos < file_size)
+	{
+		// Likely an interrupted write, drop the tail so new records remain reachable
+		arc_log.error("%s: Discarding 0x%x bytes of invalid data at 0x%x", m_name, file_size - pos, pos);
+		m_file.trunc(pos);
+	}
+
+	m_loaded.reserve(m_entries.size());
+
+	for (const auto& [map_key, info] : m_entries)
+	{
+		m_loaded.emplace_back(info);
+	}
+
+	std::sort(m_loaded.begin(), m_loaded.end(), [](const record_info& a, const record_info& b) { return a.pos < b.pos; });
+
+	// Extend the index if it doesn't cover all records
+	m_dirty = scanned_count != 0;
+
+	arc_log.notice("%s: Loaded %u records from %s (%u indexed)", m_name, m_entries.size(), path, indexed_count);
+	return true;
+}
+
+void record_archive::unmap_locked()
+{
+	if (m_view_mapped)
+	{
+		utils::memory_release(const_cast<u8*>(m_view), m_view_size);
+	}
+
+	m_view = nullptr;
+	m_view_size = 0;
+	m_view_mapped = false;
+	m_view_copy = {};
+	m_loaded = {};
+}
+
+void record_archive::unmap()
+{
+	std::lock_guard lock(m_mutex);
+	unmap_locked();
+}
+
+void record_archive::close()
+{
+	seal();
+
+	std::lock_guard lock(m_mutex);
+	unmap_locked();
+	m_entries.clear();
+	m_removed.clear();
+	m_dirty = false;
+	m_index_pos = 0;
+	m_index_end = 0;
+	m_file.close();
+}
+
+bool record_archive::seal()
+{
+	std::lock_guard lock(m_mutex);
+
+	if (!m_file)
+	{
+		return false;
+	}
+
+	if (!m_dirty)
+	{
+		return true;
+	}
+
+	// Only store the changes since the previous index chunk
+	std::vector<archive_index_entry> table;
+	table.reserve(m_removed.size());
+
+	for (const auto& [type, key] : m_removed)
+	{
+		table.emplace_back(archive_index_entry{key, 0, type, 0});
+	}
+
+	for (const auto& [map_key, info] : m_entries)
+	{
+		if (info.pos >= m_index_end)
+		{
+			table.emplace_back(archive_index_entry{info.key, info.pos, info.type, info.size});
+		}
+	}
+
+	// Keep file order, so that records are loaded in the order they were first seen (removals go first)
+	std::stable_sort(table.begin(), table.end(), [](const archive_index_entry& a, const archive_index_entry& b) { return a.pos < b.pos; });
+
+	archive_index index{};
+	index.tag = m_format.index_tag;
+	index.count = ::size32(table);
+	index.crc = static_cast<u32>(crc32(0, reinterpret_cast<const u8*>(table.data()), ::narrow<uInt>(table.size() * sizeof(archive_index_entry))));
+	index.prev = m_index_pos;
+
+	const fs::iovec_clone gather[2]
+	{
+		{&index, sizeof(index)},
+		{table.data(), table.size() * sizeof(archive_index_entry)}
+	};
+
+	const u64 index_pos = m_file.seek(0, fs::seek_end);
+	const u64 index_size = sizeof(index) + table.size() * sizeof(archive_index_entry);
+
+	if (m_file.write_gather(gather, 2) != index_size)
+	{
+		arc_log.error("%s: Failed to write index", m_name);
+		m_file.trunc(index_pos);
+		return false;
+	}
+
+	// The index must be on disk before the header points to it
+	m_file.sync();
+
+	archive_header header{};
+	header.magic = m_format.magic;
+	header.version = m_format.version;
+	header.header_size = sizeof(archive_header);
+	header.index_pos = index_pos;
+	header.index_end = index_pos + index_size;
+
+	m_file.seek(0);
+
+	if (m_file.write(&header, sizeof(header)) != sizeof(header))
+	{
+		arc_log.error("%s: Failed to update header", m_name);
+		return false;
+	}
+
+	m_index_pos = header.index_pos;
+	m_index_end = header.index_end;
+	m_removed.clear();
+	m_dirty = false;
+	return true;
+}
+
+usz record_archive::size() const
+{
+	reader_lock lock(m_mutex);
+	return m_entries.size();
+}
+
+std::span<const u8> record_archive::read_record(const record_info& info, bool& corrupted) const
+{
+	corrupted = false;
+
+	if (!m_view || info.pos + sizeof(archive_record) + info.size > m_view_size)
+	{
+		// Unmapped or appended after open()
+		return {};
+	}
+
+	const auto rec = read_from_ptr<archive_record>(m_view, info.pos);
+	const u8* data = m_view + info.pos + sizeof(archive_record);
+
+	if (rec.tag != m_format.record_tag || rec.type != info.type || rec.key != info.key || rec.size != info.size)
+	{
+		arc_log.error("%s: Invalid record at 0x%x", m_name, info.pos);
+		corrupted = true;
+		return {};
+	}
+
+	if (static_cast<u32>(crc32(0, data, rec.size)) != rec.crc)
+	{
+		arc_log.error("%s: Checksum mismatch at 0x%x (type=%u, key=0x%llx)", m_name, info.pos, info.type, info.key);
+		corrupted = true;
+		return {};
+	}
+
+	return {data, rec.size};
+}
+
+record_archive::record_info record_archive::get_info(usz index) const
+{
+	reader_lock lock(m_mutex);
+	return index < m_loaded.size() ? m_loaded[index] : record_info{};
+}
+
+std::span<const u8> record_archive::get(usz index)
+{
+	record_info found{};
+	bool corrupted = false;
+
+	{
+		reader_lock lock(m_mutex);
+
+		if (index >= m_loaded.size())
+		{
+			return {};
+		}
+
+		found = m_loaded[index];
+
+		if (const auto data = read_record(found, corrupted); !data.empty())
+		{
+			return data;
+		}
+	}
+
+	if (corrupted)
+	{
+		invalidate_at(found.type, found.key, found.pos);
+	}
+
+	return {};
+}
+
+std::span<const u8> record_archive::find(u32 type, u64 key)
+{
+	record_info found{};
+	bool corrupted = false;
+
+	{
+		reader_lock lock(m_mutex);
+
+		const auto it = m_entries.find(std::pair{type, key});
+
+		if (it == m_entries.end())
+		{
+			return {};
+		}
+
+		found = it->second;
+
+		if (const auto data = read_record(found, corrupted); !data.empty())
+		{
+			return data;
+		}
+	}
+
+	if (corrupted)
+	{
+		invalidate_at(type, key, found.pos);
+	}
+
+	return {};
+}
+
+bool record_archive::contains(u32 type, u64 key) const
+{
+	reader_lock lock(m_mutex);
+	return m_entries.count(std::pair{type, key}) != 0;
+}
+
+void record_archive::invalidate(u32 type, u64 key)
+{
+	std::lock_guard lock(m_mutex);
+
+	if (const auto it = m_entries.find(std::pair{type, key}); it != m_entries.end())
+	{
+		erase_locked(it);
+	}
+}
+
+void record_archive::erase_locked(std::unordered_map<std::pair<u32, u64>, record_info, entry_key_hash>::iterator it)
+{
+	if (it->second.pos < m_index_end)
+	{
+		// Covered by the index, needs a removal entry
+		m_removed.emplace_back(it->first);
+		m_dirty = true;
+	}
+
+	m_entries.erase(it);
+}
+
+void record_archive::invalidate_at(u32 type, u64 key, u64 pos)
+{
+	std::lock_guard lock(m_mutex);
+
+	if (const auto it = m_entries.find(std::pair{type, key}); it != m_entries.end() && it->second.pos == pos)
+	{
+		erase_locked(it);
+	}
+}
+
+bool record_archive::append(u32 type, u64 key, const void* data, usz size)
+{
+	if (!size || size > m_format.max_record_size)
+	{
+		return false;
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	if (!m_file)
+	{
+		return false;
+	}
+
+	if (m_entries.count(std::pair{type, key}))
+	{
+		// Already stored
+		return false;
+	}
+
+	archive_record rec{};
+	rec.tag = m_format.record_tag;
+	rec.type = type;
+	rec.size = static_cast<u32>(size);
+	rec.crc = static_cast<u32>(crc32(0, static_cast<const u8*>(data), rec.size));
+	rec.key = key;
+
+	const fs::iovec_clone gather[2]
+	{
+		{&rec, sizeof(rec)},
+		{data, size}
+	};
+
+	// Append the whole record with a single write, a partial record is dropped by the next tail scan
+	const u64 pos = m_file.seek(0, fs::seek_end);
+
+	if (m_file.write_gather(gather, 2) != sizeof(rec) + size)
+	{
+		arc_log.error("%s: Failed to write record (type=%u, key=0x%llx, size=%u)", m_name, type, key, size);
+		m_file.trunc(pos);
+		return false;
+	}
+
+	m_entries.emplace(std::pair{type, key}, record_info{pos, key, type, rec.size});
+	m_dirty = true;
+	return true;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "util/types.hpp"
+#include "Utilities/File.h"
+#include "Utilities/mutex.h"
+
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Single-file append-only store of keyed records
+// Layout: header, records (type, key, CRC32 and payload), index chunks
+// Index chunks form a chain, each one only lists the records added and removed since the previous one
+// Records are only reachable from the header after an index covering them was written,
+// records appended after the last index are recovered by a tail scan on open()
+class record_archive
+{
+public:
+	struct format
+	{
+		u64 magic;
+		u32 version;
+		u32 record_tag;
+		u32 index_tag;
+		u32 max_record_size;
+	};
+
+	struct record_info
+	{
+		u64 pos;
+		u64 key;
+		u32 type;
+		u32 size;
+	};
+
+	record_archive(std::string_view name, const format& fmt)
+		: m_name(name)
+		, m_format(fmt)
+	{
+	}
+
+	record_archive(const record_archive&) = delete;
+	record_archive& operator=(const record_archive&) = delete;
+	~record_archive();
+
+	// Open or create the archive and map its contents (an unrecognized file is moved to path + ".bak")
+	bool open(const std::string& path);
+
+	// Write the index and close the file
+	void close();
+
+	// Release the mapped view (loaded records become unavailable until the next open())
+	void unmap();
+
+	// Write an index chunk covering the changes since the last one if needed
+	bool seal();
+
+	explicit operator bool() const
+	{
+		return !!m_file;
+	}
+
+	// Number of unique records in the mapped view (file order)
+	usz loaded_count() const
+	{
+		return m_loaded.size();
+	}
+
+	// Number of unique records in the file
+	usz size() const;
+
+	// Get the location of a loaded record (not verified)
+	record_info get_info(usz index) const;
+
+	// Get a loaded record from the mapped view (checksum verified, empty on failure)
+	std::span<const u8> get(usz index);
+
+	// Find a record in the mapped view (checksum verified, empty on failure)
+	std::span<const u8> find(u32 type, u64 key);
+
+	bool contains(u32 type, u64 key) const;
+
+	// Forget a record, so that append() writes it again
+	void invalidate(u32 type, u64 key);
+
+	// Append a record unless one with the same type and key already exists
+	bool append(u32 type, u64 key, const void* data, usz size);
+
+private:
+	struct entry_key_hash
+	{
+		usz operator()(const std::pair<u32, u64>& key) const noexcept
+		{
+			// Keys are already uniformly distributed hashes
+			return static_cast<usz>(key.second ^ key.first);
+		}
+	};
+
+	std::span<const u8> read_record(const record_info& info, bool& corrupted) const;
+
+	// Drop a record which failed verification (unless it was replaced in the meantime)
+	void invalidate_at(u32 type, u64 key, u64 pos);
+
+	void erase_locked(std::unordered_map<std::pair<u32, u64>, record_info, entry_key_hash>::iterator it);
+
+	void unmap_locked();
+
+	const std::string_view m_name;
+	const format m_format;
+
+	fs::file m_file;
+
+	// File contents at the time of open()
+	const u8* m_view = nullptr;
+	usz m_view_size = 0;
+	bool m_view_mapped = false;
+	std::vector<u8> m_view_copy;
+
+	// Unique records in the view (file order)
+	std::vector<record_info> m_loaded;
+
+	// All records in the file, keyed by type and record key
+	std::unordered_map<std::pair<u32, u64>, record_info, entry_key_hash> m_entries;
+
+	// Indexed records which were invalidated since the last index chunk
+	std::vector<std::pair<u32, u64>> m_removed;
+
+	// Latest index chunk, records at or after m_index_end are not indexed
+	u64 m_index_pos = 0;
+	u64 m_index_end = 0;
+
+	// Set if the index doesn't cover all changes
+	bool m_dirty = false;
+
+	mutable shared_mutex m_mutex;
+};
@@ -769,6 +769,11 @@ int aes_crypt_cbc( aes_context *ctx,
 
     if( mode == AES_DECRYPT )
     {
+#if defined(__SSE2__) || defined(_M_X64)
+        if( aesni_supports( POLARSSL_AESNI_AES ) )
+            return( aesni_crypt_cbc_dec_blocks( ctx, length / 16, iv, input, output ) );
+#endif
+
         while( length > 0 )
         {
             memcpy( temp, input, 16 );
@@ -863,6 +868,17 @@ int aes_crypt_ctr( aes_context *ctx,
     int c, i;
     size_t n = *nc_off;
 
+#if defined(__SSE2__) || defined(_M_X64)
+    // Process whole blocks at once when the stream is block aligned
+    if( n == 0 && length >= 16 && aesni_supports( POLARSSL_AESNI_AES ) )
+    {
+        aesni_crypt_ctr_blocks( ctx, length / 16, nonce_counter, input, output );
+        input  += length & ~size_t{15};
+        output += length & ~size_t{15};
+        length &= 15;
+    }
+#endif
+
     while( length-- )
     {
         if( n == 0 ) {
@@ -131,6 +131,160 @@ int aesni_crypt_ecb( aes_context *ctx,
     return( 0 );
 }
 
+/*
+ * Batched AES-NI modes: the round loop is interleaved over eight independent
+ * blocks, which keeps the AES units busy while each AESENC/AESDEC waits on the
+ * previous round of its own block.
+ */
+#if defined(POLARSSL_HAVE_MSVC_X64_INTRINSICS)
+#define AESNI_BATCH_TARGET
+#else
+#include <immintrin.h>
+#define AESNI_BATCH_TARGET __attribute__((__target__("sse2,aes")))
+#endif
+
+#define AESNI_BATCH 8
+
+/*
+ * Increment a 128-bit big-endian counter
+ */
+static inline void aesni_ctr_increment( unsigned char nonce_counter[16] )
+{
+    int i;
+
+    for( i = 16; i > 0; i-- )
+        if( ++nonce_counter[i - 1] != 0 )
+            break;
+}
+
+AESNI_BATCH_TARGET
+static inline void aesni_encrypt_batch( const aes_context *ctx, __m128i *b, int count )
+{
+    const __m128i *rk = reinterpret_cast<const __m128i*>( ctx->rk );
+    __m128i k;
+    int i, r;
+
+    k = _mm_loadu_si128( rk++ );
+    for( i = 0; i < count; i++ )
+        b[i] = _mm_xor_si128( b[i], k );
+
+    for( r = 1; r < ctx->nr; r++ )
+    {
+        k = _mm_loadu_si128( rk++ );
+        for( i = 0; i < count; i++ )
+            b[i] = _mm_aesenc_si128( b[i], k );
+    }
+
+    k = _mm_loadu_si128( rk );
+    for( i = 0; i < count; i++ )
+        b[i] = _mm_aesenclast_si128( b[i], k );
+}
+
+AESNI_BATCH_TARGET
+static inline void aesni_decrypt_batch( const aes_context *ctx, __m128i *b, int count )
+{
+    const __m128i *rk = reinterpret_cast<const __m128i*>( ctx->rk );
+    __m128i k;
+    int i, r;
+
+    k = _mm_loadu_si128( rk++ );
+    for( i = 0; i < count; i++ )
+        b[i] = _mm_xor_si128( b[i], k );
+
+    for( r = 1; r < ctx->nr; r++ )
+    {
+        k = _mm_loadu_si128( rk++ );
+        for( i = 0; i < count; i++ )
+            b[i] = _mm_aesdec_si128( b[i], k );
+    }
+
+    k = _mm_loadu_si128( rk );
+    for( i = 0; i < count; i++ )
+        b[i] = _mm_aesdeclast_si128( b[i], k );
+}
+
+/*
+ * AES-NI AES-CTR buffer encryption/decryption
+ */
+AESNI_BATCH_TARGET
+int aesni_crypt_ctr_blocks( aes_context *ctx,
+                            size_t blocks,
+                            unsigned char nonce_counter[16],
+                            const unsigned char *input,
+                            unsigned char *output )
+{
+    __m128i b[AESNI_BATCH];
+    int i, count;
+
+    while( blocks > 0 )
+    {
+        count = blocks < AESNI_BATCH ? static_cast<int>( blocks ) : AESNI_BATCH;
+
+        for( i = 0; i < count; i++ )
+        {
+            b[i] = _mm_loadu_si128( reinterpret_cast<const __m128i*>( nonce_counter ) );
+            aesni_ctr_increment( nonce_counter );
+        }
+
+        aesni_encrypt_batch( ctx, b, count );
+
+        for( i = 0; i < count; i++ )
+        {
+            const __m128i in = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input ) + i );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( output ) + i, _mm_xor_si128( in, b[i] ) );
+        }
+
+        input  += count * 16;
+        output += count * 16;
+        blocks -= count;
+    }
+
+    return( 0 );
+}
+
+/*
+ * AES-NI AES-CBC buffer decryption
+ */
+AESNI_BATCH_TARGET
+int aesni_crypt_cbc_dec_blocks( aes_context *ctx,
+                                size_t blocks,
+                                unsigned char iv[16],
+                                const unsigned char *input,
+                                unsigned char *output )
+{
+    __m128i b[AESNI_BATCH], c[AESNI_BATCH];
+    __m128i prev = _mm_loadu_si128( reinterpret_cast<const __m128i*>( iv ) );
+    int i, count;
+
+    while( blocks > 0 )
+    {
+        count = blocks < AESNI_BATCH ? static_cast<int>( blocks ) : AESNI_BATCH;
+
+        // Keep the ciphertext since output may alias input
+        for( i = 0; i < count; i++ )
+            b[i] = c[i] = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input ) + i );
+
+        aesni_decrypt_batch( ctx, b, count );
+
+        for( i = 0; i < count; i++ )
+        {
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( output ) + i, _mm_xor_si128( b[i], prev ) );
+            prev = c[i];
+        }
+
+        input  += count * 16;
+        output += count * 16;
+        blocks -= count;
+    }
+
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( iv ), prev );
+
+    return( 0 );
+}
+
+#undef AESNI_BATCH
+#undef AESNI_BATCH_TARGET
+
 #if defined(POLARSSL_HAVE_MSVC_X64_INTRINSICS)
 static inline void clmul256( __m128i a, __m128i b, __m128i* r0, __m128i* r1 )
 {
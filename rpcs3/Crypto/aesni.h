@@ -61,6 +61,45 @@ int aesni_crypt_ecb( aes_context *ctx,
                      const unsigned char input[16],
                      unsigned char output[16] );
 
+/**
+ * \brief          AES-NI AES-CTR buffer encryption/decryption
+ *
+ * \param ctx      AES context (set up for encryption)
+ * \param blocks   Number of 16-byte blocks to process
+ * \param nonce_counter  128-bit big-endian counter, updated on return
+ * \param input    Input buffer (blocks * 16 bytes)
+ * \param output   Output buffer (blocks * 16 bytes, may alias input)
+ *
+ * \note           Eight blocks are kept in flight to hide the AESENC latency.
+ *
+ * \return         0 on success (cannot fail)
+ */
+int aesni_crypt_ctr_blocks( aes_context *ctx,
+                            size_t blocks,
+                            unsigned char nonce_counter[16],
+                            const unsigned char *input,
+                            unsigned char *output );
+
+/**
+ * \brief          AES-NI AES-CBC buffer decryption
+ *
+ * \param ctx      AES context (set up for decryption)
+ * \param blocks   Number of 16-byte blocks to process
+ * \param iv       Initialization vector, updated on return
+ * \param input    Input buffer (blocks * 16 bytes)
+ * \param output   Output buffer (blocks * 16 bytes, may alias input)
+ *
+ * \note           CBC decryption has no dependency between blocks, so eight
+ *                 blocks are kept in flight like in CTR mode.
+ *
+ * \return         0 on success (cannot fail)
+ */
+int aesni_crypt_cbc_dec_blocks( aes_context *ctx,
+                                size_t blocks,
+                                unsigned char iv[16],
+                                const unsigned char *input,
+                                unsigned char *output );
+
 /**
  * \brief          GCM multiplication: c = a * b in GF(2^128)
  *
@@ -156,6 +156,7 @@ u128 get_block_key(int block, NPD_HEADER *npd)
 
 // for out data, allocate a buffer the size of 'edat->block_size'
 // Also, set 'in file' to the beginning of the encrypted data, which may be offset if inside another file, but normally just reset to beginning of file
+// The file position is not modified, so blocks may be decrypted concurrently if 'in' supports concurrent read_at
 // returns number of bytes written, -1 for error
 s64 decrypt_block(const fs::file* in, u8* out, EDAT_HEADER *edat, NPD_HEADER *npd, u8* crypt_key, u32 block_num, u32 total_blocks, u64 size_left)
 {
@@ -183,11 +184,9 @@ s64 decrypt_block(const fs::file* in, u8* out, EDAT_HEADER *edat, NPD_HEADER *np
 	{
 		metadata_sec_offset = metadata_offset + u64{block_num} * metadata_section_size;
 
-		in->seek(file_offset + metadata_sec_offset);
-
 		unsigned char metadata[0x20];
 		memset(metadata, 0, 0x20);
-		in->read(metadata, 0x20);
+		in->read_at(file_offset + metadata_sec_offset, metadata, 0x20);
 
 		// If the data is compressed, decrypt the metadata.
 		// NOTE: For NPD version 1 the metadata is not encrypted.
@@ -208,11 +207,9 @@ s64 decrypt_block(const fs::file* in, u8* out, EDAT_HEADER *edat, NPD_HEADER *np
 	{
 		// If FLAG 0x20, the metadata precedes each data block.
 		metadata_sec_offset = metadata_offset + u64{block_num} * (metadata_section_size + edat->block_size);
-		in->seek(file_offset + metadata_sec_offset);
-
 		unsigned char metadata[0x20];
 		memset(metadata, 0, 0x20);
-		in->read(metadata, 0x20);
+		in->read_at(file_offset + metadata_sec_offset, metadata, 0x20);
 		memcpy(hash_result, metadata, 0x14);
 
 		// If FLAG 0x20 is set, apply custom xor.
@@ -228,9 +225,7 @@ s64 decrypt_block(const fs::file* in, u8* out, EDAT_HEADER *edat, NPD_HEADER *np
 	else
 	{
 		metadata_sec_offset = metadata_offset + u64{block_num} * metadata_section_size;
-		in->seek(file_offset + metadata_sec_offset);
-
-		in->read(hash_result, 0x10);
+		in->read_at(file_offset + metadata_sec_offset, hash_result, 0x10);
 		offset = metadata_offset + u64{block_num} * edat->block_size + total_blocks * metadata_section_size;
 		length = edat->block_size;
 
@@ -248,8 +243,7 @@ s64 decrypt_block(const fs::file* in, u8* out, EDAT_HEADER *edat, NPD_HEADER *np
 	memset(hash, 0, 0x10);
 	memset(key_result, 0, 0x10);
 
-	in->seek(file_offset + offset);
-	in->read(enc_data.get(), length);
+	in->read_at(file_offset + offset, enc_data.get(), length);
 
 	// Generate a key for the current block.
 	auto b_key = get_block_key(block_num, npd);
@@ -954,6 +948,65 @@ bool EDATADecrypter::ReadHeader()
 	return true;
 }
 
+EDATADecrypter::~EDATADecrypter()
+{
+	if (blocks_decrypted)
+	{
+		const u64 requests = cache_hits + cache_misses;
+
+		edat_log.notice("EDATADecrypter: block cache hit rate %.1f%% (%llu/%llu), decrypted %llu blocks (%llu KiB) at %.1f MiB/s",
+			requests ? cache_hits * 100. / requests : 0., cache_hits, requests, blocks_decrypted, bytes_decrypted / 1024,
+			decrypt_time_ns ? bytes_decrypted * 1e9 / decrypt_time_ns / (1024 * 1024) : 0.);
+	}
+}
+
+EDATADecrypter::cached_block* EDATADecrypter::find_block(u32 block)
+{
+	for (cached_block& entry : block_cache)
+	{
+		if (entry.block == block)
+		{
+			entry.last_use = ++cache_clock;
+			return &entry;
+		}
+	}
+
+	return nullptr;
+}
+
+usz EDATADecrypter::cache_capacity() const
+{
+	// Keep about 1MiB of decrypted data per file
+	return std::max<usz>(1024 * 1024 / edatHeader.block_size, 4);
+}
+
+void EDATADecrypter::insert_block(u32 block, std::shared_ptr<const std::vector<u8>> data)
+{
+	if (find_block(block))
+	{
+		// Decrypted concurrently by another reader
+		return;
+	}
+
+	cached_block* slot = nullptr;
+
+	if (block_cache.size() < cache_capacity())
+	{
+		slot = &block_cache.emplace_back();
+	}
+	else
+	{
+		slot = &*std::min_element(block_cache.begin(), block_cache.end(), [](const cached_block& a, const cached_block& b)
+		{
+			return a.last_use < b.last_use;
+		});
+	}
+
+	slot->block = block;
+	slot->last_use = ++cache_clock;
+	slot->data = std::move(data);
+}
+
 u64 EDATADecrypter::ReadData(u64 pos, u8* data, u64 size)
 {
 	size = std::min<u64>(size, pos > edatHeader.file_size ? 0 : edatHeader.file_size - pos);
@@ -967,28 +1020,148 @@ u64 EDATADecrypter::ReadData(u64 pos, u8* data, u64 size)
 	const u64 startOffset = pos % edatHeader.block_size;
 
 	const u64 num_blocks = utils::aligned_div(startOffset + size, edatHeader.block_size);
-	data_buf.resize(num_blocks * edatHeader.block_size);
 
-	// Find and decrypt block range covering pos + size
+	// Find block range covering pos + size
 	const u32 starting_block = ::narrow<u32>(pos / edatHeader.block_size);
 	const u32 ending_block = ::narrow<u32>(std::min<u64>(starting_block + num_blocks, total_blocks));
-	u64 writeOffset = 0;
 
-	for (u32 i = starting_block; i < ending_block; ++i)
+	// Blocks of the requested range (cached blocks are referenced, so they stay valid if they are evicted meanwhile)
+	std::vector<std::shared_ptr<const std::vector<u8>>> parts(ending_block - starting_block);
+
+	// Blocks which are not cached yet, followed by the read-ahead
+	std::vector<u32> missing;
+	usz requested_missing = 0;
+
 	{
-		edata_file.seek(0);
-		u64 res = decrypt_block(&edata_file, &data_buf[writeOffset], &edatHeader, &npdHeader, reinterpret_cast<uchar*>(&dec_key), i, total_blocks, edatHeader.file_size);
-		if (res == umax)
+		std::lock_guard lock(cache_mutex);
+
+		// Sequential reads start in the last block of the previous read or right after it
+		if (starting_block + 1 >= last_end_block && starting_block <= last_end_block)
+		{
+			sequential_reads++;
+		}
+		else
+		{
+			sequential_reads = 0;
+		}
+
+		last_end_block = ending_block;
+
+		for (u32 i = starting_block; i < ending_block; i++)
+		{
+			if (const auto found = find_block(i))
+			{
+				cache_hits++;
+				parts[i - starting_block] = found->data;
+			}
+			else
+			{
+				cache_misses++;
+				missing.push_back(i);
+			}
+		}
+
+		requested_missing = missing.size();
+
+		// Decrypt ahead of a sequential reader in the same batch
+		// Never more than the cache can hold next to the requested range, otherwise inserting the read-ahead evicts the requested blocks
+		const usz requested = ending_block - starting_block;
+
+		if (!missing.empty() && sequential_reads >= 2 && requested < cache_capacity())
+		{
+			const u32 readahead_end = ::narrow<u32>(std::min<u64>(ending_block + std::min<usz>(cache_capacity() - requested, 16), total_blocks));
+
+			for (u32 i = ending_block; i < readahead_end; i++)
+			{
+				if (!find_block(i))
+				{
+					missing.push_back(i);
+				}
+			}
+		}
+	}
+
+	// Decrypt without holding the lock (decrypt_block only uses read_at, so concurrent readers don't interfere)
+	std::vector<std::shared_ptr<const std::vector<u8>>> blocks(missing.size());
+	u64 decrypted_count = 0;
+	u64 decrypted_bytes = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (usz index = 0; index < missing.size(); index++)
+	{
+		std::vector<u8> block(edatHeader.block_size);
+
+		const s64 result = decrypt_block(&edata_file, block.data(), &edatHeader, &npdHeader, reinterpret_cast<uchar*>(&dec_key), missing[index], total_blocks, edatHeader.file_size);
+
+		if (result < 0)
 		{
-			edat_log.error("Error Decrypting data");
-			return 0;
+			// A failing read-ahead block is only reported when it is actually requested
+			if (index < requested_missing)
+			{
+				edat_log.error("Error Decrypting data");
+				return 0;
+			}
+
+			continue;
 		}
 
-		writeOffset += res;
+		block.resize(result);
+		decrypted_count++;
+		decrypted_bytes += result;
+
+		if (index < requested_missing)
+		{
+			parts[missing[index] - starting_block] = std::make_shared<const std::vector<u8>>(std::move(block));
+			blocks[index] = parts[missing[index] - starting_block];
+		}
+		else
+		{
+			blocks[index] = std::make_shared<const std::vector<u8>>(std::move(block));
+		}
 	}
 
-	const u64 bytesWrote = std::min<u64>(writeOffset - startOffset, size);
+	const u64 decrypt_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+	// Copy the requested range, skipping startOffset bytes of the first block
+	u64 skip = startOffset;
+	u64 bytesWrote = 0;
+
+	for (usz i = 0; i < parts.size() && bytesWrote < size; i++)
+	{
+		const std::vector<u8>& block = *ensure(parts[i]);
+
+		const u64 len = block.size();
+
+		if (skip >= len)
+		{
+			skip -= len;
+			continue;
+		}
+
+		const u64 to_copy = std::min<u64>(len - skip, size - bytesWrote);
+		std::memcpy(data + bytesWrote, block.data() + skip, to_copy);
+		bytesWrote += to_copy;
+		skip = 0;
+	}
+
+	if (!missing.empty())
+	{
+		std::lock_guard lock(cache_mutex);
+
+		blocks_decrypted += decrypted_count;
+		bytes_decrypted += decrypted_bytes;
+		decrypt_time_ns += decrypt_time;
+
+		// Cache the requested blocks first, then the read-ahead
+		for (usz index = 0; index < missing.size(); index++)
+		{
+			if (blocks[index])
+			{
+				insert_block(missing[index], std::move(blocks[index]));
+			}
+		}
+	}
 
-	memcpy(data, &data_buf[startOffset], bytesWrote);
 	return bytesWrote;
 }
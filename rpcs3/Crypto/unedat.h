@@ -5,6 +5,7 @@
 #include "utils.h"
 
 #include "Utilities/File.h"
+#include "Utilities/mutex.h"
 
 constexpr u32 SDAT_FLAG = 0x01000000;
 constexpr u32 EDAT_COMPRESSED_FLAG = 0x00000001;
@@ -79,11 +80,37 @@ struct EDATADecrypter final : fs::file_base
 	NPD_HEADER npdHeader{};
 	EDAT_HEADER edatHeader{};
 
-	// Internal data buffers.
-	std::vector<u8> data_buf{};
-
 	u128 dec_key{};
 
+	// Decrypted block cache (least recently used entries are evicted)
+	// Shared with concurrent read_at() callers, the cache, read-ahead state and statistics are protected by cache_mutex
+	struct cached_block
+	{
+		u32 block = umax;
+		u64 last_use = 0;
+		std::shared_ptr<const std::vector<u8>> data{};
+	};
+
+	shared_mutex cache_mutex;
+
+	std::vector<cached_block> block_cache{};
+	u64 cache_clock{0};
+
+	// Sequential access detection for read-ahead
+	u32 last_end_block{0};
+	u32 sequential_reads{0};
+
+	// Statistics
+	u64 cache_hits{0};
+	u64 cache_misses{0};
+	u64 blocks_decrypted{0};
+	u64 bytes_decrypted{0};
+	u64 decrypt_time_ns{0};
+
+	usz cache_capacity() const;
+	cached_block* find_block(u32 block);
+	void insert_block(u32 block, std::shared_ptr<const std::vector<u8>> data);
+
 public:
 	EDATADecrypter(fs::file&& input, u128 dec_key = {})
 		: edata_file(std::move(input))
@@ -91,6 +118,8 @@ public:
 	{
 	}
 
+	~EDATADecrypter() override;
+
 	// false if invalid
 	bool ReadHeader();
 	u64 ReadData(u64 pos, u8* data, u64 size);
@@ -9,6 +9,7 @@
 #include "Emu/System.h"
 #include "Emu/system_utils.hpp"
 #include "Emu/VFS.h"
+#include "Emu/perf_meter.hpp"
 #include "unpkg.h"
 #include "util/sysinfo.hpp"
 #include "Loader/PSF.h"
@@ -757,6 +758,8 @@ bool package_reader::fill_data(std::map<std::string, install_entry*>& all_instal
 	m_bootable_file_path.clear();
 	m_entry_indexer = 0;
 	m_written_bytes = 0;
+	m_decrypted_bytes = 0;
+	m_decrypt_ns = 0;
 
 	if (!decrypt_data())
 	{
@@ -1123,6 +1126,12 @@ package_error package_reader::extract_data(std::deque<package_reader>& readers,
 
 		reader.m_result = result::success;
 
+		if (const u64 ns = reader.m_decrypt_ns)
+		{
+			// Time is summed over worker threads, so this is the throughput of a single thread
+			pkg_log.notice("Decrypted %u MiB in %u ms of decryption time (%.1f MiB/s per thread)", reader.m_decrypted_bytes / (1024 * 1024), ns / 1'000'000, reader.m_decrypted_bytes * 1e9 / (1024 * 1024) / ns);
+		}
+
 		if (reader.get_progress(1) != 1)
 		{
 			pkg_log.warning("Missing %d bytes from PKG total files size.", reader.m_header.data_size - reader.m_written_bytes);
@@ -1183,6 +1192,9 @@ std::span<const char> package_reader::decrypt(u64 offset, u64 size, const uchar*
 	const auto data_span = archive_read_block(m_header.data_offset + offset, local_buf.get(), size);
 	ensure(data_span.data() == static_cast<void*>(local_buf.get()));
 
+	perf_meter<"PKG_DEC"_u64> perf0;
+	const auto start = std::chrono::steady_clock::now();
+
 	// Get block count
 	const u64 blocks = (data_span.size() + 15) / 16;
 
@@ -1220,24 +1232,23 @@ std::span<const char> package_reader::decrypt(u64 offset, u64 size, const uchar*
 		// Set encryption key for stream cipher
 		aes_setkey_enc(&ctx, key, 128);
 
-		// Initialize stream cipher for start position
+		// Initialize stream cipher for start position (big-endian counter)
 		be_t<u128> input = m_header.klicensee.value() + offset / 16;
 
-		// Increment stream position for every block
-		for (u64 i = 0; i < blocks; i++, input++)
-		{
-			u128 key;
-
-			aes_crypt_ecb(&ctx, AES_ENCRYPT, reinterpret_cast<const u8*>(&input), reinterpret_cast<u8*>(&key));
+		// Decrypt all blocks in place, which lets AES-NI keep several blocks in flight
+		usz nc_off = 0;
+		u8 stream_block[16];
 
-			local_buf[i] ^= key;
-		}
+		aes_crypt_ctr(&ctx, blocks * 16, &nc_off, reinterpret_cast<u8*>(&input), stream_block, reinterpret_cast<const u8*>(local_buf.get()), reinterpret_cast<u8*>(local_buf.get()));
 	}
 	else
 	{
 		pkg_log.error("Unknown release type (0x%x)", m_header.pkg_type);
 	}
 
+	m_decrypted_bytes += data_span.size();
+	m_decrypt_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
 	// Return the amount of data written in buf
 	return data_span;
 }
@@ -372,6 +372,8 @@ private:
 	atomic_t<usz> m_num_failures = 0;
 	atomic_t<usz> m_entry_indexer = 0;
 	atomic_t<usz> m_written_bytes = 0;
+	atomic_t<u64> m_decrypted_bytes = 0;
+	atomic_t<u64> m_decrypt_ns = 0; // Summed over all threads
 	bool m_was_null = false;
 
 	static constexpr usz BUF_SIZE = 8192 * 1024; // 8 MB
@@ -5,7 +5,9 @@
 #include "Emu/VFS.h"
 #include "Emu/System.h"
 #include "Emu/system_utils.hpp"
+#include "Emu/system_config.h"
 #include "Crypto/unzip.h"
+#include "Crypto/sha1.h"
 
 #include <algorithm>
 
@@ -1363,6 +1365,40 @@ static bool CheckDebugSelf(fs::file& s)
 	return false;
 }
 
+// Get path of the decrypted ELF in the cache, keyed by the SELF contents and the klic used to decrypt it
+static std::string get_decrypted_self_cache_path(const std::vector<u8>& self_data, const u8* klic_key)
+{
+	sha1_context ctx;
+	sha1_starts(&ctx);
+	sha1_update(&ctx, self_data.data(), self_data.size());
+
+	if (klic_key)
+	{
+		sha1_update(&ctx, klic_key, 0x10);
+	}
+
+	u8 key[20];
+	sha1_finish(&ctx, key);
+
+	return fs::get_cache_dir() + fmt::format("cache/self/%s.elf", fmt::base57(key));
+}
+
+static void save_decrypted_self(const std::string& path, const fs::file& elf)
+{
+	if (!fs::create_path(fs::get_parent_dir(path)))
+	{
+		self_log.error("Failed to create decrypted SELF cache directory: %s (%s)", fs::get_parent_dir(path), fs::g_tls_error);
+		return;
+	}
+
+	fs::pending_file file(path);
+
+	if (!file.file || (file.file.write(elf.to_vector<u8>()), !file.commit()))
+	{
+		self_log.error("Failed to write decrypted SELF cache: %s (%s)", path, fs::g_tls_error);
+	}
+}
+
 fs::file decrypt_self(fs::file elf_or_self, u8* klic_key, SelfAdditionalInfo* out_info, bool require_encrypted)
 {
 	if (out_info)
@@ -1380,6 +1416,13 @@ fs::file decrypt_self(fs::file elf_or_self, u8* klic_key, SelfAdditionalInfo* ou
 	// Check SELF header first. Check for a debug SELF.
 	if (elf_or_self.size() >= 4 && elf_or_self.read<u32>() == "SCE\0"_u32)
 	{
+		// Read the whole file at once, the headers are parsed with many small reads
+		std::vector<u8> self_data = elf_or_self.to_vector<u8>();
+
+		const std::string cache_path = g_cfg.core.decrypted_self_cache ? get_decrypted_self_cache_path(self_data, klic_key) : std::string{};
+
+		elf_or_self = fs::make_stream(std::move(self_data));
+
 		if (CheckDebugSelf(elf_or_self))
 		{
 			// TODO: Decrypt
@@ -1399,6 +1442,16 @@ fs::file decrypt_self(fs::file elf_or_self, u8* klic_key, SelfAdditionalInfo* ou
 			return fs::file{};
 		}
 
+		// Skip decryption if this SELF was already decrypted with the same klic
+		if (!cache_path.empty())
+		{
+			if (fs::file cached{cache_path})
+			{
+				self_log.notice("Loaded decrypted SELF from cache: %s", cache_path);
+				return cached;
+			}
+		}
+
 		// Load and decrypt the SELF file metadata.
 		if (!self_dec.LoadMetadata(klic_key))
 		{
@@ -1414,7 +1467,14 @@ fs::file decrypt_self(fs::file elf_or_self, u8* klic_key, SelfAdditionalInfo* ou
 		}
 
 		// Make a new ELF file from this SELF.
-		return self_dec.MakeElf(isElf32);
+		fs::file elf = self_dec.MakeElf(isElf32);
+
+		if (!cache_path.empty())
+		{
+			save_decrypted_self(cache_path, elf);
+		}
+
+		return elf;
 	}
 
 	if (require_encrypted)
@@ -1,6 +1,153 @@
 #include "stdafx.h"
 #include "Emu/Audio/audio_resampler.h"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numbers>
+
+audio_resampler_stats g_audio_resampler_stats{};
+
+audio_polyphase_resampler::audio_polyphase_resampler()
+{
+	constexpr f64 half = taps / 2;
+	constexpr f64 cutoff = 0.9; // Fraction of the input Nyquist frequency, the output rate is never lower than the input rate
+
+	m_coefs.resize((phases + 1) * taps);
+
+	for (u32 p = 0; p <= phases; p++)
+	{
+		f64 sum = 0.0;
+
+		for (u32 k = 0; k < taps; k++)
+		{
+			// Distance between the input sample and the output position
+			const f64 d = k - (half - 1) - static_cast<f64>(p) / phases;
+			const f64 x = std::numbers::pi * d * cutoff;
+			const f64 sinc = x == 0.0 ? 1.0 : std::sin(x) / x;
+			const f64 w = std::abs(d) >= half ? 0.0 : 0.42 + 0.5 * std::cos(std::numbers::pi * d / half) + 0.08 * std::cos(2 * std::numbers::pi * d / half); // Blackman window
+
+			m_coefs[p * taps + k] = static_cast<f32>(sinc * w);
+			sum += sinc * w;
+		}
+
+		// Normalize to unity gain
+		for (u32 k = 0; k < taps; k++)
+		{
+			m_coefs[p * taps + k] = static_cast<f32>(m_coefs[p * taps + k] / sum);
+		}
+	}
+
+	flush();
+}
+
+void audio_polyphase_resampler::set_params(u32 ch_cnt)
+{
+	m_ch_cnt = ch_cnt;
+	flush();
+}
+
+void audio_polyphase_resampler::set_step(f64 step)
+{
+	m_step = step;
+}
+
+template <u32 Channels>
+void audio_polyphase_resampler::process()
+{
+	const u32 ch_cnt = Channels ? Channels : m_ch_cnt;
+	const usz frames = m_input.size() / ch_cnt;
+
+	// Count output samples first to resize the output buffer only once
+	usz count = 0;
+
+	for (f64 pos = m_pos; static_cast<usz>(pos) + taps / 2 < frames; pos += m_step)
+	{
+		count++;
+	}
+
+	const usz out_start = m_output.size();
+	m_output.resize(out_start + count * ch_cnt);
+
+	f32* out = m_output.data() + out_start;
+
+	for (usz n = 0; n < count; n++, out += ch_cnt, m_pos += m_step)
+	{
+		const usz i = static_cast<usz>(m_pos);
+		const f64 phase = (m_pos - i) * phases;
+		const u32 p = static_cast<u32>(phase);
+		const f32 alpha = static_cast<f32>(phase - p);
+
+		// Interpolate coefficients between the two nearest phases
+		const f32* c0 = m_coefs.data() + p * taps;
+		const f32* c1 = c0 + taps;
+
+		alignas(16) f32 coef[taps];
+
+		for (u32 k = 0; k < taps; k++)
+		{
+			coef[k] = c0[k] + (c1[k] - c0[k]) * alpha;
+		}
+
+		// Channels are the innermost loop so that fixed channel counts are vectorized
+		const f32* in = m_input.data() + (i + 1 - taps / 2) * ch_cnt;
+
+		alignas(16) f32 acc[8]{};
+
+		for (u32 k = 0; k < taps; k++)
+		{
+			for (u32 ch = 0; ch < ch_cnt; ch++)
+			{
+				acc[ch] += coef[k] * in[k * ch_cnt + ch];
+			}
+		}
+
+		std::copy_n(acc, ch_cnt, out);
+	}
+
+	// Drop input samples which are no longer needed
+	const usz consumed = std::min<usz>(static_cast<usz>(m_pos) + 1 - taps / 2, frames);
+	m_input.erase(m_input.begin(), m_input.begin() + consumed * ch_cnt);
+	m_pos -= static_cast<f64>(consumed);
+}
+
+void audio_polyphase_resampler::put_samples(const f32* buf, u32 sample_cnt)
+{
+	// Drop samples which were already retrieved
+	m_output.erase(m_output.begin(), m_output.begin() + m_output_pos);
+	m_output_pos = 0;
+
+	m_input.insert(m_input.end(), buf, buf + sample_cnt * m_ch_cnt);
+
+	switch (m_ch_cnt)
+	{
+	case 2: process<2>(); break;
+	case 6: process<6>(); break;
+	case 8: process<8>(); break;
+	default: process<0>(); break;
+	}
+}
+
+std::pair<f32* /* buffer */, u32 /* samples */> audio_polyphase_resampler::get_samples(u32 sample_cnt)
+{
+	f32* const buf = m_output.data() + m_output_pos;
+	const u32 samples = std::min(sample_cnt, samples_available());
+	m_output_pos += samples * m_ch_cnt;
+	return std::make_pair(buf, samples);
+}
+
+u32 audio_polyphase_resampler::samples_available() const
+{
+	return static_cast<u32>((m_output.size() - m_output_pos) / m_ch_cnt);
+}
+
+void audio_polyphase_resampler::flush()
+{
+	// Start with silence so that the first output sample has a full filter history
+	m_input.assign((taps / 2 - 1) * m_ch_cnt, 0.0f);
+	m_pos = taps / 2 - 1;
+	m_output.clear();
+	m_output_pos = 0;
+}
 
 audio_resampler::audio_resampler()
 {
@@ -12,44 +159,104 @@ audio_resampler::~audio_resampler()
 {
 }
 
-void audio_resampler::set_params(AudioChannelCnt ch_cnt, AudioFreq freq)
+void audio_resampler::set_params(AudioChannelCnt ch_cnt, AudioFreq freq, audio_resampler_engine engine)
 {
 	flush();
+	this->engine = engine;
+	use_polyphase = engine == audio_resampler_engine::polyphase;
+	sample_rate = static_cast<u32>(freq);
 	resampler.setChannels(static_cast<u32>(ch_cnt));
 	resampler.setSampleRate(static_cast<u32>(freq));
+	polyphase.set_params(static_cast<u32>(ch_cnt));
 }
 
 f64 audio_resampler::set_tempo(f64 new_tempo)
 {
 	new_tempo = std::clamp(new_tempo, RESAMPLER_MIN_FREQ_VAL, RESAMPLER_MAX_FREQ_VAL);
 	resampler.setTempo(new_tempo);
+	polyphase.set_step(new_tempo);
+
+	// Polyphase only resamples, so real time-stretching is left to SoundTouch to keep the pitch
+	const bool to_polyphase = engine == audio_resampler_engine::polyphase && new_tempo >= RESAMPLER_POLYPHASE_MIN_FREQ_VAL;
+
+	if (to_polyphase != use_polyphase)
+	{
+		switch_engine(to_polyphase);
+	}
+
 	return new_tempo;
 }
 
+void audio_resampler::switch_engine(bool to_polyphase)
+{
+	if (to_polyphase)
+	{
+		// Samples still in SoundTouch's input are lost, this is at most one sequence
+		const u32 pending = resampler.numSamples();
+		polyphase.put_samples(resampler.bufBegin(), pending);
+		resampler.clear();
+	}
+	else
+	{
+		const auto [buf, pending] = polyphase.get_samples(polyphase.samples_available());
+		resampler.putSamples(buf, pending);
+		polyphase.flush();
+	}
+
+	use_polyphase = to_polyphase;
+}
+
 void audio_resampler::put_samples(const f32* buf, u32 sample_cnt)
 {
-	resampler.putSamples(buf, sample_cnt);
+	const auto start = std::chrono::steady_clock::now();
+
+	if (use_polyphase)
+	{
+		polyphase.put_samples(buf, sample_cnt);
+	}
+	else
+	{
+		resampler.putSamples(buf, sample_cnt);
+	}
+
+	g_audio_resampler_stats.busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
 }
 
 std::pair<f32* /* buffer */, u32 /* samples */> audio_resampler::get_samples(u32 sample_cnt)
 {
+	if (use_polyphase)
+	{
+		const auto result = polyphase.get_samples(sample_cnt);
+		g_audio_resampler_stats.latency_us = get_latency_us();
+		return result;
+	}
+
 	// NOTE: Make sure to get the buffer first because receiveSamples advances its position internally
 	//       and std::make_pair evaluates the second parameter first...
 	f32 *const buf = resampler.bufBegin();
-	return std::make_pair(buf, resampler.receiveSamples(sample_cnt));
+	const auto result = std::make_pair(buf, resampler.receiveSamples(sample_cnt));
+	g_audio_resampler_stats.latency_us = get_latency_us();
+	return result;
 }
 
 u32 audio_resampler::samples_available() const
 {
-	return resampler.numSamples();
+	return use_polyphase ? polyphase.samples_available() : resampler.numSamples();
 }
 
 f64 audio_resampler::get_resample_ratio()
 {
-	return resampler.getInputOutputSampleRatio();
+	return use_polyphase ? polyphase.get_step() : resampler.getInputOutputSampleRatio();
+}
+
+u64 audio_resampler::get_latency_us() const
+{
+	const u64 algorithmic = use_polyphase ? audio_polyphase_resampler::taps / 2 : resampler.getSetting(SETTING_INITIAL_LATENCY);
+	return (algorithmic + samples_available()) * 1'000'000 / std::max<u32>(sample_rate, 1);
 }
 
 void audio_resampler::flush()
 {
 	resampler.clear();
+	polyphase.flush();
 }
@@ -1,7 +1,11 @@
 #pragma once
 
 #include "util/types.hpp"
+#include "util/atomic.hpp"
 #include "Emu/Audio/AudioBackend.h"
+#include "Emu/system_config_types.h"
+
+#include <vector>
 
 #ifndef _MSC_VER
 #pragma GCC diagnostic push
@@ -15,6 +19,52 @@
 
 constexpr f64 RESAMPLER_MAX_FREQ_VAL = 1.0;
 constexpr f64 RESAMPLER_MIN_FREQ_VAL = 0.1;
+constexpr f64 RESAMPLER_POLYPHASE_MIN_FREQ_VAL = 0.95; // Below this the tempo change is a slowdown rather than clock drift
+
+// Resampler statistics for the performance overlay
+struct audio_resampler_stats
+{
+	atomic_t<u64> busy_ns = 0;    // Total time spent in resamplers
+	atomic_t<u64> latency_us = 0; // Latency added by the most recently used resampler
+};
+
+extern audio_resampler_stats g_audio_resampler_stats;
+
+// Windowed-sinc polyphase rate converter, only meant for small drift corrections (changes pitch)
+class audio_polyphase_resampler
+{
+public:
+	static constexpr u32 taps = 16;
+	static constexpr u32 phases = 128;
+
+	audio_polyphase_resampler();
+
+	void set_params(u32 ch_cnt);
+	void set_step(f64 step);
+
+	void put_samples(const f32* buf, u32 sample_cnt);
+	std::pair<f32* /* buffer */, u32 /* samples */> get_samples(u32 sample_cnt);
+
+	u32 samples_available() const;
+	f64 get_step() const { return m_step; }
+
+	void flush();
+
+private:
+	template <u32 Channels>
+	void process();
+
+	// Filter coefficients, with one extra phase to interpolate between phases
+	std::vector<f32> m_coefs;
+
+	u32 m_ch_cnt = 2;
+	f64 m_step = 1.0; // Input samples consumed per output sample
+	f64 m_pos = 0.0;  // Position of the next output sample in m_input
+
+	std::vector<f32> m_input;
+	std::vector<f32> m_output;
+	usz m_output_pos = 0;
+};
 
 class audio_resampler
 {
@@ -22,7 +72,7 @@ public:
 	audio_resampler();
 	~audio_resampler();
 
-	void set_params(AudioChannelCnt ch_cnt, AudioFreq freq);
+	void set_params(AudioChannelCnt ch_cnt, AudioFreq freq, audio_resampler_engine engine = audio_resampler_engine::soundtouch);
 	f64 set_tempo(f64 new_tempo);
 
 	void put_samples(const f32* buf, u32 sample_cnt);
@@ -31,8 +81,19 @@ public:
 	u32 samples_available() const;
 	f64 get_resample_ratio();
 
+	// Algorithmic latency plus samples waiting to be retrieved
+	u64 get_latency_us() const;
+
 	void flush();
 
 private:
+	// Move pending output to the other engine so that switching doesn't drop audio
+	void switch_engine(bool to_polyphase);
+
+	audio_resampler_engine engine = audio_resampler_engine::soundtouch;
+	bool use_polyphase = false; // Polyphase is only active while the tempo stays within the drift band
+	u32 sample_rate = 48000;
+
 	soundtouch::SoundTouch resampler{};
+	audio_polyphase_resampler polyphase{};
 };
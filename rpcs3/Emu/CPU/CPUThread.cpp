@@ -10,13 +10,18 @@
 #include "Emu/GDB.h"
 #include "Emu/Cell/PPUThread.h"
 #include "Emu/Cell/SPUThread.h"
+#include "Emu/Cell/PPUAnalyser.h"
+#include "Emu/Cell/lv2/sys_prx.h"
+#include "Emu/Cell/lv2/sys_overlay.h"
 #include "Emu/RSX/RSXThread.h"
 #include "Emu/perf_meter.hpp"
 
 #include "util/asm.hpp"
+#include "Utilities/date_time.h"
 #include <thread>
 #include <unordered_map>
 #include <map>
+#include <algorithm>
 
 #if defined(ARCH_X64)
 #include <emmintrin.h>
@@ -29,6 +34,8 @@ DECLARE(cpu_thread::g_suspend_counter){0};
 LOG_CHANNEL(profiler);
 LOG_CHANNEL(sys_log, "SYS");
 
+extern std::vector<std::pair<u32, std::string>> ppu_get_exported_function_names();
+
 static thread_local u32 s_tls_thread_slot = -1;
 
 // Suspend counter stamp
@@ -75,12 +82,135 @@ void fmt_class_string<bs_t<cpu_flag>>::format(std::string& out, u64 arg)
 	format_bitset(out, arg, "[", "|", "]", &fmt_class_string<cpu_flag>::format);
 }
 
+// Guest symbol table used to resolve sampled PPU addresses
+struct cpu_prof_symbols
+{
+	// Function address -> (size, name)
+	std::map<u32, std::pair<u32, std::string>> funcs;
+
+	void add_module(const ppu_module& _module)
+	{
+		std::string_view mod_name = _module.name;
+
+		if (mod_name.empty())
+		{
+			mod_name = std::string_view{_module.path}.substr(_module.path.find_last_of('/') + 1);
+		}
+
+		for (const ppu_function& func : _module.funcs)
+		{
+			if (func.name.empty())
+			{
+				funcs.insert_or_assign(func.addr, std::make_pair(func.size, fmt::format("%s!sub_%x", mod_name, func.addr)));
+			}
+			else
+			{
+				funcs.insert_or_assign(func.addr, std::make_pair(func.size, fmt::format("%s!%s", mod_name, func.name)));
+			}
+		}
+	}
+
+	void refresh()
+	{
+		funcs.clear();
+
+		if (auto _main = g_fxo->try_get<main_ppu_module>())
+		{
+			add_module(*_main);
+		}
+
+		idm::select<lv2_obj, lv2_prx>([&](u32, lv2_prx& prx)
+		{
+			add_module(prx);
+		});
+
+		idm::select<lv2_obj, lv2_overlay>([&](u32, lv2_overlay& ovlm)
+		{
+			add_module(ovlm);
+		});
+
+		// Names of exported and HLE functions take precedence
+		for (auto& [addr, name] : ppu_get_exported_function_names())
+		{
+			if (auto found = funcs.find(addr); found != funcs.end())
+			{
+				found->second.second = std::move(name);
+			}
+			else
+			{
+				funcs.emplace(addr, std::make_pair(4, std::move(name)));
+			}
+		}
+	}
+
+	std::string get(u32 addr) const
+	{
+		if (auto found = funcs.upper_bound(addr); found != funcs.begin())
+		{
+			found--;
+
+			// Functions of unknown size are assumed to extend up to the next one
+			if (!found->second.first || addr - found->first < found->second.first)
+			{
+				return found->second.second;
+			}
+		}
+
+		return fmt::format("0x%08x", addr);
+	}
+};
+
+// Minimal protobuf encoder (pprof profile format)
+struct cpu_prof_proto
+{
+	std::string data;
+
+	void varint(u64 value)
+	{
+		for (; value >= 0x80; value >>= 7)
+		{
+			data += static_cast<char>(value | 0x80);
+		}
+
+		data += static_cast<char>(value);
+	}
+
+	cpu_prof_proto& field(u32 id, u64 value)
+	{
+		varint(u64{id} << 3);
+		varint(value);
+		return *this;
+	}
+
+	cpu_prof_proto& field(u32 id, std::string_view bytes)
+	{
+		varint(u64{id} << 3 | 2);
+		varint(bytes.size());
+		data += bytes;
+		return *this;
+	}
+};
+
 // CPU profiler thread
 struct cpu_prof
 {
 	// PPU/SPU id enqueued for registration
 	lf_queue<u32> registered;
 
+	// Commands sent through the registration channel
+	enum : u32
+	{
+		cmd_flush = 0,
+		cmd_stop = 0xfffffffe,
+		cmd_start = 0xffffffff,
+	};
+
+	// Call stack capture session state (new PPU/SPU threads are registered while set)
+	atomic_t<bool> capturing = g_cfg.core.ppu_prof.get();
+
+	// Call stack sampling period (µs)
+	static constexpr u64 stack_sample_period = 1000;
+
 	struct sample_info
 	{
 		// Block occurences: name -> sample_count
@@ -92,6 +222,10 @@ struct cpu_prof
 		// Avoid printing replicas or when not much changed
 		u64 new_samples = 0;
 
+		// Call stacks sampled during the capture session: (frames, HLE function) -> sample_count
+		// PPU frames are the current address followed by return addresses, SPU frames are block hash and LS address
+		std::map<std::pair<std::vector<u64>, std::string_view>, u64> stacks;
+
 		static constexpr u64 min_print_samples = 500;
 		static constexpr u64 min_print_all_samples = min_print_samples * 20;
 
@@ -103,6 +237,17 @@ struct cpu_prof
 			new_samples = 0;
 		}
 
+		static std::string format_block(u64 name)
+		{
+			// Print only 7 hash characters out of 11 (which covers roughly 48 bits)
+			std::string result = fmt::format("[%s", fmt::base57(be_t<u64>{name}));
+			result.resize(result.size() - 4);
+
+			// Print chunk address from lowest 16 bits
+			fmt::append(result, "...chunk-0x%05x]", (name & 0xffff) * 4);
+			return result;
+		}
+
 		static std::string format(const std::multimap<u64, u64, std::greater<u64>>& chart, u64 samples, u64 idle, bool extended_print = false)
 		{
 			// Print results
@@ -116,12 +261,7 @@ struct cpu_prof
 			{
 				const f64 _frac = count / busy / samples;
 
-				// Print only 7 hash characters out of 11 (which covers roughly 48 bits)
-				fmt::append(results, "\n\t[%s", fmt::base57(be_t<u64>{name}));
-				results.resize(results.size() - 4);
-
-				// Print chunk address from lowest 16 bits
-				fmt::append(results, "...chunk-0x%05x]: %.4f%% (%u)", (name & 0xffff) * 4, _frac * 100., count);
+				fmt::append(results, "\n\t%s: %.4f%% (%u)", format_block(name), _frac * 100., count);
 
 				if (results.size() >= (extended_print ? 10000 : 5000))
 				{
@@ -136,6 +276,12 @@ struct cpu_prof
 		// Print info
 		void print(const std::shared_ptr<cpu_thread>& ptr)
 		{
+			if (!samples)
+			{
+				// Only registered for call stack sampling
+				return;
+			}
+
 			if (new_samples < min_print_samples || samples == idle)
 			{
 				if (cpu_flag::exit - ptr->state)
@@ -211,10 +357,259 @@ struct cpu_prof
 		}
 	};
 
+	// Capture session info (only accessed by the profiler thread)
+	bool session = false;
+	std::string session_name;
+	steady_clock::time_point session_start{};
+	u64 session_time = 0;
+	cpu_prof_symbols symbols;
+
+	void start_session()
+	{
+		session = true;
+		session_name = fmt::format("%s_%s", Emu.GetTitleID().empty() ? "untitled"sv : std::string_view{Emu.GetTitleID()}, date_time::current_time_narrow<'_'>());
+		session_start = steady_clock::now();
+		session_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		symbols.refresh();
+
+		// Register existing threads (duplicates are ignored)
+		idm::select<named_thread<ppu_thread>>([&](u32 id, cpu_thread&)
+		{
+			registered.push(id);
+		});
+
+		idm::select<named_thread<spu_thread>>([&](u32 id, cpu_thread&)
+		{
+			registered.push(id);
+		});
+
+		profiler.success("Started call stack capture session '%s'", session_name);
+	}
+
+	void stop_session(std::unordered_map<std::shared_ptr<cpu_thread>, sample_info>& threads)
+	{
+		write_session(threads);
+
+		session = false;
+
+		for (auto it = threads.begin(); it != threads.end();)
+		{
+			it->second.stacks.clear();
+
+			// Unregister threads which were only sampled for the session
+			if (it->first->id_type() == 2 ? !g_cfg.core.spu_prof : !g_cfg.core.ppu_prof)
+			{
+				it = threads.erase(it);
+				continue;
+			}
+
+			it++;
+		}
+	}
+
+	static void sample_stack(const std::shared_ptr<cpu_thread>& ptr, sample_info& info)
+	{
+		if (ptr->state & (cpu_flag::exit + cpu_flag::wait))
+		{
+			// Only running threads are accounted for
+			return;
+		}
+
+		std::vector<u64> frames;
+		std::string_view hle;
+
+		if (auto ppu = ptr->try_get<ppu_thread>())
+		{
+			// Racy reads, the same way the debugger does it
+			const char* const func = ppu->current_function;
+
+			frames.emplace_back(ppu->cia);
+
+			for (const auto& [addr, sp] : ppu->dump_callstack_list())
+			{
+				frames.emplace_back(addr);
+			}
+
+			if (func)
+			{
+				hle = func;
+			}
+		}
+		else if (auto spu = ptr->try_get<spu_thread>())
+		{
+			frames.emplace_back(atomic_storage<u64>::load(ptr->block_hash));
+			frames.emplace_back(spu->pc);
+		}
+
+		info.stacks[{std::move(frames), hle}]++;
+	}
+
+	// Write symbolized call stacks in folded (flamegraph) and pprof formats
+	void write_session(const std::unordered_map<std::shared_ptr<cpu_thread>, sample_info>& threads)
+	{
+		if (thread_ctrl::state() != thread_state::aborting)
+		{
+			// Modules may have been loaded since the session has started (unavailable on shutdown)
+			symbols.refresh();
+		}
+
+		// Symbolized call stack (root first) -> sample_count
+		std::map<std::vector<std::string>, u64> stacks;
+
+		u64 total = 0;
+
+		for (auto& [ptr, info] : threads)
+		{
+			if (info.stacks.empty())
+			{
+				continue;
+			}
+
+			// Thread name is the root frame
+			std::string thread_name = ptr->get_name();
+			std::replace(thread_name.begin(), thread_name.end(), ';', ':');
+
+			for (auto& [key, count] : info.stacks)
+			{
+				const auto& [frames, hle] = key;
+
+				std::vector<std::string> names{thread_name};
+
+				if (ptr->id_type() == 1)
+				{
+					for (auto it = frames.rbegin(); it != frames.rend(); it++)
+					{
+						// Return addresses point to the instruction after the call
+						const u32 addr = static_cast<u32>(*it);
+						names.emplace_back(symbols.get(std::next(it) == frames.rend() ? addr : addr - 4));
+					}
+
+					if (!hle.empty() && !names.back().ends_with(hle))
+					{
+						names.emplace_back(fmt::format("HLE!%s", hle));
+					}
+				}
+				else if (frames.size() == 2)
+				{
+					if (frames[0])
+					{
+						names.emplace_back(sample_info::format_block(frames[0]));
+					}
+
+					names.emplace_back(fmt::format("LS!0x%05x", frames[1]));
+				}
+
+				stacks[std::move(names)] += count;
+				total += count;
+			}
+		}
+
+		if (stacks.empty())
+		{
+			profiler.warning("Capture session '%s': no samples collected.", session_name);
+			return;
+		}
+
+		std::string folded;
+
+		for (auto& [names, count] : stacks)
+		{
+			for (auto& name : names)
+			{
+				folded += name;
+				folded += ';';
+			}
+
+			folded.back() = ' ';
+			fmt::append(folded, "%u\n", count);
+		}
+
+		// Build pprof profile (one location per function, the string table is written last)
+		cpu_prof_proto profile;
+		std::vector<std::string_view> strings{""};
+		std::unordered_map<std::string_view, u64> string_ids{{"", 0}};
+		std::unordered_map<std::string_view, u64> func_ids;
+
+		const auto get_string = [&](std::string_view str)
+		{
+			const auto [found, added] = string_ids.try_emplace(str, strings.size());
+
+			if (added)
+			{
+				strings.emplace_back(str);
+			}
+
+			return found->second;
+		};
+
+		const auto value_type = [&](std::string_view type, std::string_view unit)
+		{
+			return cpu_prof_proto{}.field(1, get_string(type)).field(2, get_string(unit)).data;
+		};
+
+		const u64 period = stack_sample_period * 1000;
+
+		profile.field(1, value_type("samples", "count"));
+		profile.field(1, value_type("cpu", "nanoseconds"));
+
+		for (auto& [names, count] : stacks)
+		{
+			// Locations are listed leaf first
+			cpu_prof_proto ids;
+
+			for (auto it = names.rbegin(); it != names.rend(); it++)
+			{
+				const auto [found, added] = func_ids.try_emplace(*it, func_ids.size() + 1);
+
+				if (added)
+				{
+					const u64 name = get_string(*it);
+					profile.field(5, cpu_prof_proto{}.field(1, found->second).field(2, name).field(3, name).data);
+					profile.field(4, cpu_prof_proto{}.field(1, found->second).field(4, cpu_prof_proto{}.field(1, found->second).data).data);
+				}
+
+				ids.varint(found->second);
+			}
+
+			cpu_prof_proto values;
+			values.varint(count);
+			values.varint(count * period);
+
+			profile.field(2, cpu_prof_proto{}.field(1, ids.data).field(2, values.data).data);
+		}
+
+		profile.field(9, session_time);
+		profile.field(10, std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now() - session_start).count());
+		profile.field(11, value_type("cpu", "nanoseconds"));
+		profile.field(12, period);
+
+		for (std::string_view str : strings)
+		{
+			profile.field(6, str);
+		}
+
+		const std::string path = fs::get_cache_dir() + "profiles/" + session_name;
+
+		if (!fs::create_path(fs::get_parent_dir(path)) || !fs::write_file(path + ".folded", fs::rewrite, folded) || !fs::write_file(path + ".pb", fs::rewrite, profile.data))
+		{
+			profiler.error("Failed to write capture session to '%s' (%s)", path, fs::g_tls_error);
+			return;
+		}
+
+		profiler.success("Capture session '%s': %u samples written to %s.folded (flamegraph) and %s.pb (pprof)", session_name, total, path, path);
+	}
+
 	void operator()()
 	{
 		std::unordered_map<std::shared_ptr<cpu_thread>, sample_info> threads;
 
+		steady_clock::time_point next_stack_sample{};
+
+		if (capturing)
+		{
+			start_session();
+		}
+
 		while (thread_ctrl::state() != thread_state::aborting)
 		{
 			bool flush = false;
@@ -222,13 +617,27 @@ struct cpu_prof
 			// Handle registration channel
 			for (u32 id : registered.pop_all())
 			{
-				if (id == 0)
+				if (id == cmd_flush)
 				{
 					// Handle id zero as a command to flush results
 					flush = true;
 					continue;
 				}
 
+				if (id == cmd_start || id == cmd_stop)
+				{
+					if (id == cmd_start && !session)
+					{
+						start_session();
+					}
+					else if (id == cmd_stop && session)
+					{
+						stop_session(threads);
+					}
+
+					continue;
+				}
+
 				std::shared_ptr<cpu_thread> ptr;
 
 				if (id >> 24 == 1)
@@ -247,14 +656,8 @@ struct cpu_prof
 
 				if (ptr && cpu_flag::exit - ptr->state)
 				{
-					auto [found, add] = threads.try_emplace(std::move(ptr));
-
-					if (!add)
-					{
-						// Overwritten (impossible?): print previous data
-						found->second.print(found->first);
-						found->second.reset();
-					}
+					// Threads may be registered twice when a capture session starts
+					threads.try_emplace(std::move(ptr));
 				}
 			}
 
@@ -265,9 +668,16 @@ struct cpu_prof
 				continue;
 			}
 
+			const bool spu_prof = g_cfg.core.spu_prof.get();
+
 			// Sample active threads
 			for (auto& [ptr, info] : threads)
 			{
+				if (!spu_prof || ptr->id_type() != 2)
+				{
+					continue;
+				}
+
 				if (auto state = +ptr->state; cpu_flag::exit - state)
 				{
 					// Get short function hash
@@ -302,11 +712,27 @@ struct cpu_prof
 				}
 			}
 
+			// Sample call stacks at a lower rate
+			if (const auto now = steady_clock::now(); session && now >= next_stack_sample)
+			{
+				next_stack_sample = now + std::chrono::microseconds(stack_sample_period);
+
+				for (auto& [ptr, info] : threads)
+				{
+					sample_stack(ptr, info);
+				}
+			}
+
 			if (flush)
 			{
 				profiler.success("Flushing profiling results...");
 
 				sample_info::print_all(threads);
+
+				if (session)
+				{
+					write_session(threads);
+				}
 			}
 
 			if (Emu.IsPaused())
@@ -321,6 +747,11 @@ struct cpu_prof
 
 		// Print all remaining results
 		sample_info::print_all(threads);
+
+		if (session)
+		{
+			write_session(threads);
+		}
 	}
 
 	static constexpr auto thread_name = "CPU Profiler"sv;
@@ -503,12 +934,16 @@ void cpu_thread::operator()()
 	{
 	case 1:
 	{
-		//g_fxo->get<cpu_profiler>().registered.push(id);
+		if (g_cfg.core.ppu_prof || g_fxo->get<cpu_profiler>().capturing)
+		{
+			g_fxo->get<cpu_profiler>().registered.push(id);
+		}
+
 		break;
 	}
 	case 2:
 	{
-		if (g_cfg.core.spu_prof)
+		if (g_cfg.core.spu_prof || g_fxo->get<cpu_profiler>().capturing)
 		{
 			g_fxo->get<cpu_profiler>().registered.push(id);
 		}
@@ -1389,12 +1824,28 @@ void cpu_thread::flush_profilers() noexcept
 		return;
 	}
 
-	if (g_cfg.core.spu_prof)
+	if (g_cfg.core.spu_prof || g_fxo->get<cpu_profiler>().capturing)
 	{
-		g_fxo->get<cpu_profiler>().registered.push(0);
+		g_fxo->get<cpu_profiler>().registered.push(cpu_prof::cmd_flush);
 	}
 }
 
+bool cpu_thread::toggle_profiler() noexcept
+{
+	if (!g_fxo->is_init<cpu_profiler>())
+	{
+		return false;
+	}
+
+	auto& prof = g_fxo->get<cpu_profiler>();
+
+	// Set flag first so threads created meanwhile register themselves
+	const bool start = !prof.capturing.test_and_invert();
+
+	prof.registered.push(start ? cpu_prof::cmd_start : cpu_prof::cmd_stop);
+	return start;
+}
+
 u32 CPUDisAsm::DisAsmBranchTarget(s32 /*imm*/)
 {
 	// Unused
@@ -283,6 +283,9 @@ public:
 	// Send signal to the profiler(s) to flush results
 	static void flush_profilers() noexcept;
 
+	// Start or stop call stack capture session of the profiler, returns true if started
+	static bool toggle_profiler() noexcept;
+
 	template <DerivedFrom<cpu_thread> T = cpu_thread>
 	static inline T* get_current() noexcept
 	{
@@ -386,6 +386,86 @@ void cpu_translator::replace_intrinsics(llvm::Function& f)
 	}
 }
 
+void cpu_translator::init_debug_info(std::string_view source)
+{
+	m_dib.reset();
+	m_dfile = nullptr;
+
+	if (!jit_dump_enabled())
+	{
+		return;
+	}
+
+	// Line numbers are guest addresses
+	m_dib = std::make_unique<llvm::DIBuilder>(*m_module);
+	m_dfile = m_dib->createFile({source.data(), source.size()}, ".");
+	m_dib->createCompileUnit(llvm::dwarf::DW_LANG_C, m_dfile, "RPCS3", true, "", 0);
+	m_module->addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+}
+
+void cpu_translator::set_guest_address(u32 addr)
+{
+	if (!m_dib)
+	{
+		return;
+	}
+
+	const auto func = m_ir->GetInsertBlock()->getParent();
+	auto sp = func->getSubprogram();
+
+	if (!sp)
+	{
+		const auto type = m_dib->createSubroutineType(m_dib->getOrCreateTypeArray({}));
+		sp = m_dib->createFunction(m_dfile, func->getName(), {}, m_dfile, addr, type, addr, llvm::DINode::FlagZero, llvm::DISubprogram::SPFlagDefinition | llvm::DISubprogram::SPFlagOptimized);
+		func->setSubprogram(sp);
+	}
+
+	m_ir->SetCurrentDebugLocation(llvm::DILocation::get(m_context, addr, 0, sp));
+}
+
+void cpu_translator::finalize_debug_info(llvm::Function& f)
+{
+	if (!m_dib)
+	{
+		return;
+	}
+
+	// Instructions emitted outside of guest instructions inherit the previous location
+	// Locations leaked from other functions (IR builder state) are replaced as well
+	const auto sp = f.getSubprogram();
+
+	llvm::DebugLoc last;
+
+	if (sp)
+	{
+		last = llvm::DILocation::get(m_context, sp->getLine(), 0, sp);
+	}
+
+	for (auto& bb : f)
+	{
+		for (auto& inst : bb)
+		{
+			if (const llvm::DebugLoc& loc = inst.getDebugLoc(); sp && loc && loc->getScope()->getSubprogram() == sp)
+			{
+				last = loc;
+				continue;
+			}
+
+			inst.setDebugLoc(last);
+		}
+	}
+}
+
+void cpu_translator::finalize_debug_info()
+{
+	if (m_dib)
+	{
+		m_dib->finalize();
+		m_dib.reset();
+		m_dfile = nullptr;
+	}
+}
+
 void cpu_translator::erase_stores(llvm::ArrayRef<llvm::Value*> args)
 {
 	for (auto v : args)
@@ -19,6 +19,7 @@
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/DIBuilder.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Support/KnownBits.h"
 #include "llvm/Support/ModRef.h"
@@ -2988,6 +2989,10 @@ protected:
 	// IR builder
 	llvm::IRBuilder<>* m_ir = nullptr;
 
+	// Debug info builder (guest address line tables, only used with perf jitdump)
+	std::unique_ptr<llvm::DIBuilder> m_dib;
+	llvm::DIFile* m_dfile = nullptr;
+
 	void initialize(llvm::LLVMContext& context, llvm::ExecutionEngine& engine);
 
 public:
@@ -3684,6 +3689,18 @@ public:
 	// Finalize processing custom intrinsics
 	void replace_intrinsics(llvm::Function&);
 
+	// Start building guest address line tables for the current module (if requested)
+	void init_debug_info(std::string_view source);
+
+	// Set guest address of the instructions emitted next
+	void set_guest_address(u32 addr);
+
+	// Fill missing debug locations of the function after translation
+	void finalize_debug_info(llvm::Function&);
+
+	// Finalize debug info of the current module
+	void finalize_debug_info();
+
 	// Erase store instructions of provided
 	void erase_stores(llvm::ArrayRef<llvm::Value*> args);
 
@@ -6,7 +6,10 @@
 #include "Emu/Cell/lv2/sys_event.h"
 #include "Emu/Cell/Modules/cellAudioOut.h"
 #include "cellAudio.h"
+#include "Emu/perf_meter.hpp"
 #include "util/video_provider.h"
+#include "util/v128.hpp"
+#include "util/simd.hpp"
 
 #include <cmath>
 
@@ -149,7 +152,7 @@ audio_ringbuffer::audio_ringbuffer(cell_audio_config& _cfg)
 	}
 
 	// Configure resampler
-	resampler.set_params(static_cast<AudioChannelCnt>(cfg.audio_channels), static_cast<AudioFreq>(cfg.audio_sampling_rate));
+	resampler.set_params(static_cast<AudioChannelCnt>(cfg.audio_channels), static_cast<AudioFreq>(cfg.audio_sampling_rate), cfg.raw.time_stretching_engine);
 	resampler.set_tempo(RESAMPLER_MAX_FREQ_VAL);
 
 	const f64 buffer_dur_mult = [&]()
@@ -612,6 +615,7 @@ namespace audio
 			.desired_buffer_duration = g_cfg.audio.desired_buffer_duration,
 			.enable_time_stretching = static_cast<bool>(g_cfg.audio.enable_time_stretching),
 			.time_stretching_threshold = g_cfg.audio.time_stretching_threshold,
+			.time_stretching_engine = g_cfg.audio.time_stretching_engine,
 			.convert_to_s16 = static_cast<bool>(g_cfg.audio.convert_to_s16),
 			.dump_to_file = static_cast<bool>(g_cfg.audio.dump_to_file),
 			.renderer = g_cfg.audio.renderer,
@@ -638,6 +642,7 @@ namespace audio
 				raw.buffering_enabled != new_raw.buffering_enabled ||
 				raw.time_stretching_threshold != new_raw.time_stretching_threshold ||
 				raw.enable_time_stretching != new_raw.enable_time_stretching ||
+				raw.time_stretching_engine != new_raw.time_stretching_engine ||
 				raw.convert_to_s16 != new_raw.convert_to_s16 ||
 				raw.renderer != new_raw.renderer ||
 				raw.dump_to_file != new_raw.dump_to_file)
@@ -1028,11 +1033,61 @@ audio_port* cell_audio_thread::open_port()
 	return nullptr;
 }
 
+namespace
+{
+	// Load 4 big-endian floats from guest memory
+	inline v128 load_be_f32x4(const be_t<f32>* src)
+	{
+		const v128 x = v128::loadu(src);
+		const v128 lo = gv_or32(gv_shl32(x, 24), gv_and32(gv_shl32(x, 8), gv_bcst32(0x00ff0000)));
+		const v128 hi = gv_or32(gv_shr32(x, 24), gv_and32(gv_shr32(x, 8), gv_bcst32(0x0000ff00)));
+		return gv_or32(lo, hi);
+	}
+
+	// Convert big-endian samples to native floats multiplied by a constant volume
+	void convert_be_f32(float* dst, const be_t<f32>* src, u32 count, float volume)
+	{
+		const v128 vol = gv_bcstfs(volume);
+
+		u32 i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			v128::storeu(gv_mulfs(load_be_f32x4(src + i), vol), dst + i);
+		}
+
+		for (; i < count; i++)
+		{
+			dst[i] = src[i] * volume;
+		}
+	}
+
+	// Accumulate big-endian samples multiplied by a constant volume (same channel layout)
+	void mix_be_f32(float* dst, const be_t<f32>* src, u32 count, float volume)
+	{
+		const v128 vol = gv_bcstfs(volume);
+
+		u32 i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			v128::storeu(gv_addfs(v128::loadu(dst + i), gv_mulfs(load_be_f32x4(src + i), vol)), dst + i);
+		}
+
+		for (; i < count; i++)
+		{
+			dst[i] += src[i] * volume;
+		}
+	}
+}
+
 template <AudioChannelCnt channels, AudioChannelCnt downmix>
 void cell_audio_thread::mix(float* out_buffer, s32 offset)
 {
 	AUDIT(out_buffer != nullptr);
 
+	perf_meter<"AUDIOMIX"_u64> perf0;
+
 	constexpr u32 out_channels = static_cast<u32>(channels);
 	constexpr u32 out_buffer_sz = out_channels * AUDIO_BUFFER_SAMPLES;
 
@@ -1041,64 +1096,96 @@ void cell_audio_thread::mix(float* out_buffer, s32 offset)
 	// Reset out_buffer
 	std::memset(out_buffer, 0, out_buffer_sz * sizeof(float));
 
+	// Port samples converted to native floats with volume applied
+	alignas(16) float in_buffer[8 * AUDIO_BUFFER_SAMPLES];
+
 	// mixing
 	for (audio_port& port : ports)
 	{
 		if (port.state != audio_port_state::started) continue;
 
-		auto buf = port.get_vm_ptr(offset);
+		const be_t<f32>* buf = port.get_vm_ptr(offset);
 
 		static constexpr float minus_3db = 0.707f; // value taken from https://www.dolby.com/us/en/technologies/a-guide-to-dolby-metadata.pdf
-		float m = master_volume;
+
+		const u32 in_channels = port.num_channels;
+
+		if (in_channels != 2 && in_channels != 8)
+		{
+			fmt::throw_exception("Unknown channel count (port=%u, channel=%d)", port.number, port.num_channels);
+		}
 
 		// part of cellAudioSetPortLevel functionality
-		// spread port volume changes over 13ms
-		auto step_volume = [master_volume, &m](audio_port& port)
+		// spread port volume changes over 13ms, the ramp is computed once per block
+		u32 ramp_frames = 0;
+
+		if (const audio_port::level_set_t param = port.level_set.load(); param.inc != 0.0f)
 		{
-			const audio_port::level_set_t param = port.level_set.load();
+			const bool dec = param.inc < 0.0f;
 
-			if (param.inc != 0.0f)
+			while (ramp_frames < AUDIO_BUFFER_SAMPLES)
 			{
 				port.level += param.inc;
-				const bool dec = param.inc < 0.0f;
 
 				if ((!dec && param.value - port.level <= 0.0f) || (dec && param.value - port.level >= 0.0f))
 				{
 					port.level = param.value;
 					port.level_set.compare_and_swap(param, { param.value, 0.0f });
 				}
+
+				const float m = port.level * master_volume;
+
+				for (u32 ch = 0; ch < in_channels; ch++)
+				{
+					in_buffer[ramp_frames * in_channels + ch] = buf[ramp_frames * in_channels + ch] * m;
+				}
+
+				ramp_frames++;
+
+				if (port.level == param.value)
+				{
+					break;
+				}
 			}
+		}
 
-			m = port.level * master_volume;
-		};
+		const float m = port.level * master_volume;
+		const u32 ramp_samples = ramp_frames * in_channels;
 
-		if (port.num_channels == 2)
+		if (in_channels == out_channels && out_channels == 2)
 		{
-			for (u32 out = 0, in = 0; out < out_buffer_sz; out += out_channels, in += 2)
+			// Stereo to stereo needs no reordering, accumulate directly from guest memory
+			for (u32 i = 0; i < ramp_samples; i++)
 			{
-				step_volume(port);
+				out_buffer[i] += in_buffer[i];
+			}
 
-				const float left  = buf[in + 0] * m;
-				const float right = buf[in + 1] * m;
+			mix_be_f32(out_buffer + ramp_samples, buf + ramp_samples, out_buffer_sz - ramp_samples, m);
+			continue;
+		}
 
-				out_buffer[out + 0] += left;
-				out_buffer[out + 1] += right;
+		convert_be_f32(in_buffer + ramp_samples, buf + ramp_samples, in_channels * AUDIO_BUFFER_SAMPLES - ramp_samples, m);
+
+		if (in_channels == 2)
+		{
+			for (u32 out = 0, in = 0; out < out_buffer_sz; out += out_channels, in += 2)
+			{
+				out_buffer[out + 0] += in_buffer[in + 0];
+				out_buffer[out + 1] += in_buffer[in + 1];
 			}
 		}
-		else if (port.num_channels == 8)
+		else
 		{
 			for (u32 out = 0, in = 0; out < out_buffer_sz; out += out_channels, in += 8)
 			{
-				step_volume(port);
-
-				const float left       = buf[in + 0] * m;
-				const float right      = buf[in + 1] * m;
-				const float center     = buf[in + 2] * m;
-				const float low_freq   = buf[in + 3] * m;
-				const float side_left  = buf[in + 4] * m;
-				const float side_right = buf[in + 5] * m;
-				const float rear_left  = buf[in + 6] * m;
-				const float rear_right = buf[in + 7] * m;
+				const float left       = in_buffer[in + 0];
+				const float right      = in_buffer[in + 1];
+				const float center     = in_buffer[in + 2];
+				const float low_freq   = in_buffer[in + 3];
+				const float side_left  = in_buffer[in + 4];
+				const float side_right = in_buffer[in + 5];
+				const float rear_left  = in_buffer[in + 6];
+				const float rear_right = in_buffer[in + 7];
 
 				if constexpr (downmix == AudioChannelCnt::STEREO)
 				{
@@ -1155,10 +1242,6 @@ void cell_audio_thread::mix(float* out_buffer, s32 offset)
 				}
 			}
 		}
-		else
-		{
-			fmt::throw_exception("Unknown channel count (port=%u, channel=%d)", port.number, port.num_channels);
-		}
 	}
 }
 
@@ -210,6 +210,7 @@ struct cell_audio_config
 		s64 desired_buffer_duration = 0;
 		bool enable_time_stretching = false;
 		s64 time_stretching_threshold = 0;
+		audio_resampler_engine time_stretching_engine = audio_resampler_engine::soundtouch;
 		bool convert_to_s16 = false;
 		bool dump_to_file = false;
 		audio_renderer renderer = audio_renderer::null;
@@ -5,9 +5,16 @@
 
 #include "Emu/Cell/lv2/sys_fs.h"
 #include "Emu/Cell/lv2/sys_sync.h"
+#include "Emu/Cell/lv2/sys_event.h"
+#include "Emu/Cell/lv2/sys_ppu_thread.h"
 #include "cellFs.h"
+#include "cellSysutil.h"
+#include "sysPrxForUser.h"
+#include "util/sysinfo.hpp"
 
 #include <mutex>
+#include <deque>
+#include <map>
 
 LOG_CHANNEL(cellFs);
 
@@ -68,10 +75,15 @@ error_code cellFsWrite(ppu_thread& ppu, u32 fd, vm::cptr<void> buf, u64 nbytes,
 	return sys_fs_write(ppu, fd, buf, nbytes, nwrite ? nwrite : vm::var<u64>{});
 }
 
+static void fs_st_close(u32 fd);
+
 error_code cellFsClose(ppu_thread& ppu, u32 fd)
 {
 	cellFs.trace("cellFsClose(fd=0x%x)", fd);
 
+	// Streaming read is implicitly finished
+	fs_st_close(fd);
+
 	return sys_fs_close(ppu, fd);
 }
 
@@ -676,9 +688,228 @@ error_code cellFsSetDiscReadRetrySetting()
 	return CELL_OK;
 }
 
+// Streaming read state (cellFsStRead*)
+struct fs_st_stream
+{
+	const u32 fd;
+	const std::shared_ptr<lv2_file> file;
+
+	// Guest ring buffer (filled directly by the prefetch thread)
+	const u32 ring_addr;
+	const u64 ring_size;
+	const u64 block_size;
+	const u64 transfer_rate;
+	const s32 copy;
+
+	// Total amount of bytes produced by the prefetch thread and consumed by the guest
+	atomic_t<u64> produced{0};
+	atomic_t<u64> consumed{0};
+
+	// Incremented on every update of the counters above (for waiting)
+	atomic_t<u32> produce_signal{0};
+	atomic_t<u32> consume_signal{0};
+
+	// Set between cellFsStReadStart and cellFsStReadStop
+	atomic_t<bool> active{false};
+
+	// Set when the prefetch thread reached the end of the requested range
+	atomic_t<bool> finished{false};
+
+	// Protects starting and stopping
+	shared_mutex mutex;
+
+	// Requested file range
+	u64 offset = 0;
+	u64 end = 0;
+
+	// Pending cellFsStReadWaitCallback request
+	shared_mutex cb_mutex;
+	vm::ptr<void(s32 xfd, u64 xsize)> cb_func{};
+	u64 cb_size = 0;
+
+	std::unique_ptr<named_thread<std::function<void()>>> thread;
+
+	fs_st_stream(u32 fd, std::shared_ptr<lv2_file> file, u32 ring_addr, const CellFsRingBuffer& ringbuf)
+		: fd(fd)
+		, file(std::move(file))
+		, ring_addr(ring_addr)
+		, ring_size(ringbuf.ringbuf_size)
+		, block_size(ringbuf.block_size)
+		, transfer_rate(ringbuf.transfer_rate)
+		, copy(ringbuf.copy)
+	{
+	}
+
+	u64 available() const
+	{
+		return produced - consumed;
+	}
+
+	// Amount of data which can still be requested from the stream
+	u64 reachable() const
+	{
+		return finished ? available() : umax;
+	}
+
+	void check_callback()
+	{
+		std::lock_guard lock(cb_mutex);
+
+		if (cb_func && std::min(cb_size, reachable()) <= available())
+		{
+			sysutil_register_cb([func = cb_func, fd = fd, size = std::min(cb_size, available())](ppu_thread& ppu) -> s32
+			{
+				func(ppu, fd, size);
+				return CELL_OK;
+			});
+
+			cb_func = vm::null;
+		}
+	}
+
+	void prefetch()
+	{
+		const u64 start_time = get_system_time();
+
+		for (u64 pos = offset; pos < end && thread_ctrl::state() != thread_state::aborting;)
+		{
+			const u32 signal = consume_signal;
+
+			// Wait for the guest to release a block
+			if (ring_size - (produced - consumed) < std::min(block_size, end - pos))
+			{
+				thread_ctrl::wait_on(consume_signal, signal);
+				continue;
+			}
+
+			// Keep to the requested transfer rate (bytes per second)
+			if (transfer_rate)
+			{
+				const u64 due = start_time + (pos - offset) * 1'000'000 / transfer_rate;
+
+				if (const u64 now = get_system_time(); now < due)
+				{
+					thread_ctrl::wait_for(due - now);
+					continue;
+				}
+			}
+
+			// Blocks never cross the end of the ring because the ring size is a multiple of the block size
+			const u64 ring_pos = produced % ring_size;
+			const u64 size = std::min({block_size, end - pos, ring_size - ring_pos});
+
+			u64 read = 0;
+			{
+				// Only keeps the file open, positional reads don't need exclusive access to the mount point
+				reader_lock lock(file->mp->mutex);
+
+				if (!file->file)
+				{
+					// Closed without cellFsStReadFinish
+					break;
+				}
+
+				// Read directly into the guest ring buffer
+				read = file->file.read_at(pos, vm::base(ring_addr + static_cast<u32>(ring_pos)), size);
+			}
+
+			if (read < size)
+			{
+				end = pos + read;
+			}
+
+			pos += read;
+			produced += read;
+			signal_produced();
+			check_callback();
+		}
+
+		finished = true;
+		signal_produced();
+		check_callback();
+	}
+
+	void signal_produced()
+	{
+		produce_signal++;
+		produce_signal.notify_all();
+	}
+
+	void release(u64 size)
+	{
+		consumed += size;
+		consume_signal++;
+		consume_signal.notify_all();
+	}
+
+	void stop()
+	{
+		std::lock_guard lock(mutex);
+
+		active = false;
+
+		if (thread)
+		{
+			*thread = thread_state::aborting;
+			thread.reset();
+		}
+
+		signal_produced();
+	}
+};
+
+struct fs_st_manager
+{
+	shared_mutex mutex;
+	std::unordered_map<u32, std::shared_ptr<fs_st_stream>> streams;
+
+	// Streams belong to the lv2_file object, not to the fd number (which may be reused)
+	std::shared_ptr<fs_st_stream> get(u32 fd, const std::shared_ptr<lv2_file>& file)
+	{
+		reader_lock lock(mutex);
+
+		if (auto found = streams.find(fd); found != streams.end() && found->second->file == file)
+		{
+			return found->second;
+		}
+
+		return nullptr;
+	}
+
+	std::shared_ptr<fs_st_stream> remove(u32 fd)
+	{
+		std::lock_guard lock(mutex);
+
+		std::shared_ptr<fs_st_stream> stream;
+
+		if (auto found = streams.find(fd); found != streams.end())
+		{
+			stream = std::move(found->second);
+			streams.erase(found);
+		}
+
+		return stream;
+	}
+
+	static void destroy(const std::shared_ptr<fs_st_stream>& stream)
+	{
+		stream->stop();
+		vm::dealloc(stream->ring_addr, vm::main);
+	}
+};
+
+static void fs_st_close(u32 fd)
+{
+	if (auto stream = g_fxo->get<fs_st_manager>().remove(fd))
+	{
+		cellFs.warning("cellFsClose(fd=%d): streaming read was not finished", fd);
+		fs_st_manager::destroy(stream);
+	}
+}
+
 s32 cellFsStReadInit(u32 fd, vm::cptr<CellFsRingBuffer> ringbuf)
 {
-	cellFs.todo("cellFsStReadInit(fd=%d, ringbuf=*0x%x)", fd, ringbuf);
+	cellFs.warning("cellFsStReadInit(fd=%d, ringbuf=*0x%x)", fd, ringbuf);
 
 	if (ringbuf->copy & ~CELL_FS_ST_COPYLESS)
 	{
@@ -707,14 +938,42 @@ s32 cellFsStReadInit(u32 fd, vm::cptr<CellFsRingBuffer> ringbuf)
 		return CELL_EPERM;
 	}
 
-	// TODO
+	if (!ringbuf->block_size || ringbuf->ringbuf_size > u32{umax})
+	{
+		return CELL_EINVAL;
+	}
+
+	auto& st = g_fxo->get<fs_st_manager>();
+
+	std::lock_guard lock(st.mutex);
+
+	if (auto found = st.streams.find(fd); found != st.streams.end())
+	{
+		if (found->second->file == file)
+		{
+			return CELL_EBUSY;
+		}
+
+		// Left over from a file closed directly by sys_fs_close with the same fd
+		fs_st_manager::destroy(found->second);
+		st.streams.erase(found);
+	}
+
+	const u32 addr = vm::alloc(static_cast<u32>(ringbuf->ringbuf_size), vm::main);
+
+	if (!addr)
+	{
+		return CELL_ENOMEM;
+	}
+
+	st.streams.emplace(fd, std::make_shared<fs_st_stream>(fd, file, addr, *ringbuf));
 
 	return CELL_OK;
 }
 
 s32 cellFsStReadFinish(u32 fd)
 {
-	cellFs.todo("cellFsStReadFinish(fd=%d)", fd);
+	cellFs.warning("cellFsStReadFinish(fd=%d)", fd);
 
 	const auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 
@@ -723,14 +982,21 @@ s32 cellFsStReadFinish(u32 fd)
 		return CELL_EBADF; // ???
 	}
 
-	// TODO
+	const auto stream = g_fxo->get<fs_st_manager>().remove(fd);
+
+	if (!stream)
+	{
+		return CELL_ENXIO;
+	}
+
+	fs_st_manager::destroy(stream);
 
 	return CELL_OK;
 }
 
 s32 cellFsStReadGetRingBuf(u32 fd, vm::ptr<CellFsRingBuffer> ringbuf)
 {
-	cellFs.todo("cellFsStReadGetRingBuf(fd=%d, ringbuf=*0x%x)", fd, ringbuf);
+	cellFs.trace("cellFsStReadGetRingBuf(fd=%d, ringbuf=*0x%x)", fd, ringbuf);
 
 	const auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 
@@ -739,14 +1005,24 @@ s32 cellFsStReadGetRingBuf(u32 fd, vm::ptr<CellFsRingBuffer> ringbuf)
 		return CELL_EBADF;
 	}
 
-	// TODO
+	const auto stream = g_fxo->get<fs_st_manager>().get(fd, file);
+
+	if (!stream)
+	{
+		return CELL_ENXIO;
+	}
+
+	ringbuf->ringbuf_size = stream->ring_size;
+	ringbuf->block_size = stream->block_size;
+	ringbuf->transfer_rate = stream->transfer_rate;
+	ringbuf->copy = stream->copy;
 
 	return CELL_OK;
 }
 
 s32 cellFsStReadGetStatus(u32 fd, vm::ptr<u64> status)
 {
-	cellFs.todo("cellFsStReadGetRingBuf(fd=%d, status=*0x%x)", fd, status);
+	cellFs.trace("cellFsStReadGetStatus(fd=%d, status=*0x%x)", fd, status);
 
 	const auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 
@@ -755,14 +1031,22 @@ s32 cellFsStReadGetStatus(u32 fd, vm::ptr<u64> status)
 		return CELL_EBADF;
 	}
 
-	// TODO
+	const auto stream = g_fxo->get<fs_st_manager>().get(fd, file);
+
+	if (!stream)
+	{
+		*status = CELL_FS_ST_NOT_INITIALIZED | CELL_FS_ST_STOP;
+		return CELL_OK;
+	}
+
+	*status = CELL_FS_ST_INITIALIZED | (stream->active && !stream->finished ? CELL_FS_ST_PROGRESS : CELL_FS_ST_STOP);
 
 	return CELL_OK;
 }
 
 s32 cellFsStReadGetRegid(u32 fd, vm::ptr<u64> regid)
 {
-	cellFs.todo("cellFsStReadGetRingBuf(fd=%d, regid=*0x%x)", fd, regid);
+	cellFs.todo("cellFsStReadGetRegid(fd=%d, regid=*0x%x)", fd, regid);
 
 	const auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 
@@ -771,14 +1055,22 @@ s32 cellFsStReadGetRegid(u32 fd, vm::ptr<u64> regid)
 		return CELL_EBADF;
 	}
 
-	// TODO
+	const auto stream = g_fxo->get<fs_st_manager>().get(fd, file);
+
+	if (!stream)
+	{
+		return CELL_ENXIO;
+	}
+
+	// TODO: the ring buffer is not allocated from a separate memory region
+	*regid = 0;
 
 	return CELL_OK;
 }
 
 s32 cellFsStReadStart(u32 fd, u64 offset, u64 size)
 {
-	cellFs.todo("cellFsStReadStart(fd=%d, offset=0x%llx, size=0x%llx)", fd, offset, size);
+	cellFs.warning("cellFsStReadStart(fd=%d, offset=0x%llx, size=0x%llx)", fd, offset, size);
 
 	const auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 
@@ -787,14 +1079,56 @@ s32 cellFsStReadStart(u32 fd, u64 offset, u64 size)
 		return CELL_EBADF;
 	}
 
-	// TODO
+	const auto stream = g_fxo->get<fs_st_manager>().get(fd, file);
+
+	if (!stream)
+	{
+		return CELL_ENXIO;
+	}
+
+	std::lock_guard lock(stream->mutex);
+
+	if (stream->thread)
+	{
+		return CELL_EBUSY;
+	}
+
+	u64 file_size = 0;
+	{
+		reader_lock file_lock(file->mp->mutex);
+
+		if (!file->file)
+		{
+			return CELL_EBADF;
+		}
+
+		file_size = file->file.size();
+	}
+
+	if (offset > file_size)
+	{
+		return CELL_EINVAL;
+	}
+
+	// Zero size streams the rest of the file
+	stream->offset = offset;
+	stream->end = size ? std::min(file_size, offset + size) : file_size;
+	stream->produced = 0;
+	stream->consumed = 0;
+	stream->finished = false;
+	stream->active = true;
+
+	stream->thread = std::make_unique<named_thread<std::function<void()>>>(fmt::format("cellFsSt Prefetch %d", fd), [stream = stream.get()]()
+	{
+		stream->prefetch();
+	});
 
 	return CELL_OK;
 }
 
 s32 cellFsStReadStop(u32 fd)
 {
-	cellFs.todo("cellFsStReadStop(fd=%d)", fd);
+	cellFs.warning("cellFsStReadStop(fd=%d)", fd);
 
 	const auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 
@@ -803,14 +1137,21 @@ s32 cellFsStReadStop(u32 fd)
 		return CELL_EBADF;
 	}
 
-	// TODO
+	const auto stream = g_fxo->get<fs_st_manager>().get(fd, file);
+
+	if (!stream)
+	{
+		return CELL_ENXIO;
+	}
+
+	stream->stop();
 
 	return CELL_OK;
 }
 
 s32 cellFsStRead(u32 fd, vm::ptr<u8> buf, u64 size, vm::ptr<u64> rsize)
 {
-	cellFs.todo("cellFsStRead(fd=%d, buf=*0x%x, size=0x%llx, rsize=*0x%x)", fd, buf, size, rsize);
+	cellFs.trace("cellFsStRead(fd=%d, buf=*0x%x, size=0x%llx, rsize=*0x%x)", fd, buf, size, rsize);
 
 	const auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 
@@ -819,14 +1160,37 @@ s32 cellFsStRead(u32 fd, vm::ptr<u8> buf, u64 size, vm::ptr<u64> rsize)
 		return CELL_EBADF;
 	}
 
-	// TODO
+	const auto stream = g_fxo->get<fs_st_manager>().get(fd, file);
+
+	if (!stream)
+	{
+		return CELL_ENXIO;
+	}
+
+	if (stream->copy == CELL_FS_ST_COPYLESS)
+	{
+		return CELL_EPERM;
+	}
+
+	// Copy what is available without blocking (cellFsStReadWait is used to wait for data)
+	const u64 consumed = stream->consumed;
+	const u64 count = std::min(size, stream->produced - consumed);
+	const u64 ring_pos = consumed % stream->ring_size;
+	const u64 first = std::min(count, stream->ring_size - ring_pos);
+
+	std::memcpy(buf.get_ptr(), vm::base(stream->ring_addr + static_cast<u32>(ring_pos)), first);
+	std::memcpy(buf.get_ptr() + first, vm::base(stream->ring_addr), count - first);
+
+	stream->release(count);
+
+	*rsize = count;
 
 	return CELL_OK;
 }
 
 s32 cellFsStReadGetCurrentAddr(u32 fd, vm::ptr<u32> addr, vm::ptr<u64> size)
 {
-	cellFs.todo("cellFsStReadGetCurrentAddr(fd=%d, addr=*0x%x, size=*0x%x)", fd, addr, size);
+	cellFs.trace("cellFsStReadGetCurrentAddr(fd=%d, addr=*0x%x, size=*0x%x)", fd, addr, size);
 
 	const auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 
@@ -835,14 +1199,31 @@ s32 cellFsStReadGetCurrentAddr(u32 fd, vm::ptr<u32> addr, vm::ptr<u64> size)
 		return CELL_EBADF;
 	}
 
-	// TODO
+	const auto stream = g_fxo->get<fs_st_manager>().get(fd, file);
+
+	if (!stream)
+	{
+		return CELL_ENXIO;
+	}
+
+	if (stream->copy != CELL_FS_ST_COPYLESS)
+	{
+		return CELL_EPERM;
+	}
+
+	// Hand out the contiguous part of the ring buffer which is already filled
+	const u64 consumed = stream->consumed;
+	const u64 ring_pos = consumed % stream->ring_size;
+
+	*addr = stream->ring_addr + static_cast<u32>(ring_pos);
+	*size = std::min(stream->produced - consumed, stream->ring_size - ring_pos);
 
 	return CELL_OK;
 }
 
 s32 cellFsStReadPutCurrentAddr(u32 fd, vm::ptr<u8> addr, u64 size)
 {
-	cellFs.todo("cellFsStReadPutCurrentAddr(fd=%d, addr=*0x%x, size=0x%llx)", fd, addr, size);
+	cellFs.trace("cellFsStReadPutCurrentAddr(fd=%d, addr=*0x%x, size=0x%llx)", fd, addr, size);
 
 	const auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 
@@ -851,14 +1232,33 @@ s32 cellFsStReadPutCurrentAddr(u32 fd, vm::ptr<u8> addr, u64 size)
 		return CELL_EBADF;
 	}
 
-	// TODO
+	const auto stream = g_fxo->get<fs_st_manager>().get(fd, file);
+
+	if (!stream)
+	{
+		return CELL_ENXIO;
+	}
+
+	if (stream->copy != CELL_FS_ST_COPYLESS)
+	{
+		return CELL_EPERM;
+	}
+
+	const u64 consumed = stream->consumed;
+
+	if (addr.addr() != stream->ring_addr + consumed % stream->ring_size || size > stream->produced - consumed)
+	{
+		return CELL_EINVAL;
+	}
+
+	stream->release(size);
 
 	return CELL_OK;
 }
 
-s32 cellFsStReadWait(u32 fd, u64 size)
+s32 cellFsStReadWait(ppu_thread& ppu, u32 fd, u64 size)
 {
-	cellFs.todo("cellFsStReadWait(fd=%d, size=0x%llx)", fd, size);
+	cellFs.trace("cellFsStReadWait(fd=%d, size=0x%llx)", fd, size);
 
 	const auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 
@@ -867,14 +1267,42 @@ s32 cellFsStReadWait(u32 fd, u64 size)
 		return CELL_EBADF;
 	}
 
-	// TODO
+	const auto stream = g_fxo->get<fs_st_manager>().get(fd, file);
+
+	if (!stream)
+	{
+		return CELL_ENXIO;
+	}
+
+	if (size > stream->ring_size)
+	{
+		return CELL_EINVAL;
+	}
+
+	// Wait until enough data is buffered or the stream ends
+	while (stream->active)
+	{
+		const u32 signal = stream->produce_signal;
+
+		if (stream->available() >= std::min(size, stream->reachable()))
+		{
+			break;
+		}
+
+		thread_ctrl::wait_on(stream->produce_signal, signal, 100'000);
+
+		if (ppu.is_stopped())
+		{
+			return {};
+		}
+	}
 
 	return CELL_OK;
 }
 
 s32 cellFsStReadWaitCallback(u32 fd, u64 size, vm::ptr<void(s32 xfd, u64 xsize)> func)
 {
-	cellFs.todo("cellFsStReadWaitCallback(fd=%d, size=0x%llx, func=*0x%x)", fd, size, func);
+	cellFs.trace("cellFsStReadWaitCallback(fd=%d, size=0x%llx, func=*0x%x)", fd, size, func);
 
 	const auto file = idm::get<lv2_fs_object, lv2_file>(fd);
 
@@ -883,76 +1311,349 @@ s32 cellFsStReadWaitCallback(u32 fd, u64 size, vm::ptr<void(s32 xfd, u64 xsize)>
 		return CELL_EBADF;
 	}
 
-	// TODO
+	const auto stream = g_fxo->get<fs_st_manager>().get(fd, file);
+
+	if (!stream)
+	{
+		return CELL_ENXIO;
+	}
+
+	if (size > stream->ring_size)
+	{
+		return CELL_EINVAL;
+	}
+
+	{
+		std::lock_guard lock(stream->cb_mutex);
+
+		if (stream->cb_func)
+		{
+			return CELL_EIO;
+		}
+
+		stream->cb_func = func;
+		stream->cb_size = size;
+	}
+
+	// The callback is delivered through the sysutil callback queue once the data is buffered
+	stream->check_callback();
 
 	return CELL_OK;
 }
 
 using fs_aio_cb_t = vm::ptr<void(vm::ptr<CellFsAio> xaio, s32 error, s32 xid, u64 size)>;
 
-struct fs_aio_thread : ppu_thread
+// AIO engine: requests are executed concurrently by host worker threads (adjacent reads on the same fd are merged),
+// completions are delivered in submission order by a PPU thread waiting on an event queue (fs_aio_entry)
+struct fs_aio_manager
 {
-	using ppu_thread::ppu_thread;
+	struct request
+	{
+		u64 seq;
+		u32 type; // 1: read, 2: write
+		s32 xid;
+		vm::ptr<CellFsAio> aio;
+		fs_aio_cb_t func;
+		u32 fd;
+		u64 offset;
+		vm::ptr<void> buf;
+		u64 size;
+		s32 error;
+		u64 result;
+	};
+
+	// Limit of merged read size
+	static constexpr u64 max_merge_size = 4 * 1024 * 1024;
+
+	shared_mutex mutex;
+	u32 init_count = 0;
+	u32 ppu_id = 0;
+	u32 queue_id = 0;
+
+	// Pending requests, completed requests waiting for their turn
+	shared_mutex req_mutex;
+	std::deque<request> pending;
+	std::map<u64, request> completed;
+	u64 next_seq = 0;
+	u64 next_delivery = 0;
+
+	// Submitted requests which callbacks haven't returned yet
+	atomic_t<u32> in_flight{0};
 
-	void non_task()
+	// Incremented on new requests (for waiting)
+	atomic_t<u32> signal{0};
+
+	std::unique_ptr<named_thread_group<std::function<void()>>> workers;
+
+	void submit(u32 type, s32 xid, vm::ptr<CellFsAio> aio, fs_aio_cb_t func)
 	{
-		while (cmd64 cmd = cmd_wait())
 		{
-			const u32 type = cmd.arg1<u32>();
-			const s32 xid = cmd.arg2<s32>();
-			const cmd64 cmd2 = cmd_get(1);
-			const auto aio = cmd2.arg1<vm::ptr<CellFsAio>>();
-			const auto func = cmd2.arg2<fs_aio_cb_t>();
-			cmd_pop(1);
+			std::lock_guard lock(req_mutex);
+			pending.push_back(request{next_seq++, type, xid, aio, func, aio->fd, aio->offset, aio->buf, aio->size, static_cast<s32>(CELL_EBADF), 0});
+		}
 
-			s32 error = CELL_EBADF;
-			u64 result = 0;
+		signal++;
+		signal.notify_one();
+	}
 
-			const auto file = idm::get<lv2_fs_object, lv2_file>(aio->fd);
+	// Take a request and the queued reads directly following it
+	std::vector<request> take()
+	{
+		std::vector<request> batch;
 
-			if (!file || (type == 1 && file->flags & CELL_FS_O_WRONLY) || (type == 2 && !(file->flags & CELL_FS_O_ACCMODE)))
+		std::lock_guard lock(req_mutex);
+
+		if (pending.empty())
+		{
+			return batch;
+		}
+
+		batch.emplace_back(std::move(pending.front()));
+		pending.pop_front();
+
+		for (u64 total = batch[0].size; batch[0].type == 1 && total < max_merge_size;)
+		{
+			const request& last = batch.back();
+
+			const auto next = std::find_if(pending.begin(), pending.end(), [&](const request& r)
 			{
-			}
-			else if (std::lock_guard lock(file->mp->mutex); file->file)
+				return r.type == 1 && r.fd == last.fd && r.offset == last.offset + last.size;
+			});
+
+			if (next == pending.end())
 			{
-				const auto old_pos = file->file.pos(); file->file.seek(aio->offset);
+				break;
+			}
+
+			total += next->size;
+			batch.emplace_back(std::move(*next));
+			pending.erase(next);
+		}
+
+		return batch;
+	}
 
-				result = type == 2
-					? file->op_write(aio->buf, aio->size)
-					: file->op_read(aio->buf, aio->size);
+	void execute(std::vector<request>& batch)
+	{
+		const auto file = idm::get<lv2_fs_object, lv2_file>(batch[0].fd);
+		const u32 type = batch[0].type;
 
+		if (!file || (type == 1 && file->flags & CELL_FS_O_WRONLY) || (type == 2 && !(file->flags & CELL_FS_O_ACCMODE)))
+		{
+			return;
+		}
+
+		if (type == 2)
+		{
+			request& req = batch[0];
+
+			std::lock_guard lock(file->mp->mutex);
+
+			if (file->file)
+			{
+				const auto old_pos = file->file.pos(); file->file.seek(req.offset);
+				req.result = file->op_write(req.buf, req.size);
 				file->file.seek(old_pos);
-				error = CELL_OK;
+				req.error = CELL_OK;
 			}
 
-			func(*this, aio, error, xid, result);
-			lv2_obj::sleep(*this);
+			return;
+		}
+
+		// Positional reads only need the file to stay open, so reads of different workers can run concurrently (like sys_fs_fcntl 0x8000000a)
+		reader_lock lock(file->mp->mutex);
+
+		if (!file->file)
+		{
+			// Closed while the request was pending
+			return;
+		}
+
+		if (batch.size() == 1)
+		{
+			batch[0].result = file->op_read(batch[0].buf, batch[0].size, batch[0].offset);
+			batch[0].error = CELL_OK;
+			return;
+		}
+
+		// Merged read through an intermediate buffer
+		std::vector<uchar> data(batch.back().offset + batch.back().size - batch[0].offset);
+		data.resize(file->file.read_at(batch[0].offset, data.data(), data.size()));
+
+		const fs::file merged = fs::make_stream(std::move(data));
+
+		for (request& req : batch)
+		{
+			req.result = lv2_file::op_read(merged, req.buf, req.size, req.offset - batch[0].offset);
+			req.error = CELL_OK;
+		}
+	}
+
+	void complete(std::vector<request>& batch)
+	{
+		std::lock_guard lock(req_mutex);
+
+		for (request& req : batch)
+		{
+			completed.emplace(req.seq, std::move(req));
+		}
+
+		// Deliver completions in submission order
+		const auto queue = idm::get<lv2_obj, lv2_event_queue>(queue_id);
+
+		for (auto it = completed.begin(); it != completed.end() && it->first == next_delivery; it = completed.erase(it), next_delivery++)
+		{
+			const request& req = it->second;
+
+			if (!queue || queue->send(0, u64{req.aio.addr()} << 32 | req.func.addr(), u64{static_cast<u32>(req.xid)} << 32 | static_cast<u32>(req.error), req.result))
+			{
+				cellFs.error("cellFsAio: failed to deliver completion (xid=%d)", req.xid);
+				in_flight--;
+			}
+		}
+	}
+
+	void worker()
+	{
+		while (thread_ctrl::state() != thread_state::aborting)
+		{
+			const u32 old = signal;
+
+			auto batch = take();
+
+			if (batch.empty())
+			{
+				thread_ctrl::wait_on(signal, old);
+				continue;
+			}
+
+			execute(batch);
+			complete(batch);
 		}
 	}
 };
 
-struct fs_aio_manager
+void fs_aio_entry(ppu_thread& ppu)
 {
-	std::shared_ptr<fs_aio_thread> thread;
+	auto& m = g_fxo->get<fs_aio_manager>();
 
-	shared_mutex mutex;
-};
+	if (!ppu.loaded_from_savestate)
+	{
+		// Ensure awake
+		ppu.check_state();
+	}
+
+	while (!sys_event_queue_receive(ppu, m.queue_id, vm::null, 0))
+	{
+		if (ppu.is_stopped())
+		{
+			ppu.state += cpu_flag::again;
+			return;
+		}
 
-s32 cellFsAioInit(vm::cptr<char> mount_point)
+		// Wakeup
+		ppu.check_state();
+
+		const u64 arg1 = ppu.gpr[5];
+		const u64 arg2 = ppu.gpr[6];
+		const u64 arg3 = ppu.gpr[7];
+
+		const auto aio = vm::ptr<CellFsAio>::make(static_cast<u32>(arg1 >> 32));
+		const auto func = fs_aio_cb_t::make(static_cast<u32>(arg1));
+
+		func(ppu, aio, static_cast<s32>(arg2), static_cast<s32>(arg2 >> 32), arg3);
+		m.in_flight--;
+	}
+
+	cellFs.notice("fs_aio_entry(): Exited with the following error code: %s", CellError{static_cast<u32>(ppu.gpr[3])});
+
+	ppu_execute<&sys_ppu_thread_exit>(ppu, 0);
+}
+
+s32 cellFsAioInit(ppu_thread& ppu, vm::cptr<char> mount_point)
 {
 	cellFs.warning("cellFsAioInit(mount_point=%s)", mount_point);
 
 	// TODO: create AIO thread (if not exists) for specified mount point
-	cellFs.fatal("cellFsAio disabled, use LLE.");
+	auto& m = g_fxo->get<fs_aio_manager>();
+
+	std::lock_guard lock(m.mutex);
+
+	if (m.init_count++ == 0)
+	{
+		vm::var<u64> _tid;
+		vm::var<u32> queue_id;
+		vm::var<char[]> _name = vm::make_str("_fs_aio_cb_hndlr");
+
+		vm::var<sys_event_queue_attribute_t> attr;
+		attr->protocol = SYS_SYNC_PRIORITY;
+		attr->type = SYS_PPU_QUEUE;
+		attr->name_u64 = 0;
+
+		// Requests are limited so completions always fit in the queue
+		ensure(CELL_OK == sys_event_queue_create(ppu, queue_id, attr, 0, CELL_FS_AIO_MAX_REQUEST * 2));
+		ppu.check_state();
+		m.queue_id = *queue_id;
+
+		ensure(CELL_OK == ppu_execute<&sys_ppu_thread_create>(ppu, +_tid, g_fxo->get<ppu_function_manager>().func_addr(FIND_FUNC(fs_aio_entry)), 0, 512, 0x4000, SYS_PPU_THREAD_CREATE_JOINABLE, +_name));
+		ppu.check_state();
+		m.ppu_id = static_cast<u32>(*_tid);
+
+		const u32 count = std::clamp<u32>(utils::get_thread_count() / 2, 2, 8);
+		m.workers = std::make_unique<named_thread_group<std::function<void()>>>("FS AIO Worker "sv, count, [&m]() { m.worker(); });
+	}
 
 	return CELL_OK;
 }
 
-s32 cellFsAioFinish(vm::cptr<char> mount_point)
+s32 cellFsAioFinish(ppu_thread& ppu, vm::cptr<char> mount_point)
 {
 	cellFs.warning("cellFsAioFinish(mount_point=%s)", mount_point);
 
 	// TODO: delete existing AIO thread for specified mount point
+	auto& m = g_fxo->get<fs_aio_manager>();
+
+	u32 queue_id = 0;
+	u32 ppu_id = 0;
+	{
+		std::lock_guard lock(m.mutex);
+
+		if (!m.init_count || m.init_count-- != 1)
+		{
+			return CELL_OK;
+		}
+
+		// Finish pending requests, new requests fail with CELL_ENXIO from now on
+		m.workers.reset();
+
+		for (auto batch = m.take(); !batch.empty(); batch = m.take())
+		{
+			m.execute(batch);
+			m.complete(batch);
+		}
+
+		queue_id = m.queue_id;
+		ppu_id = m.ppu_id;
+	}
+
+	// Wait for the remaining callbacks (without the lock, they may call cellFsAioRead/cellFsAioWrite)
+	ppu.state += cpu_flag::wait;
+
+	while (m.in_flight)
+	{
+		if (ppu.is_stopped())
+		{
+			return 0;
+		}
+
+		thread_ctrl::wait_for(1000);
+	}
+
+	ppu.check_state();
+
+	ensure(CELL_OK == sys_event_queue_destroy(ppu, queue_id, SYS_EVENT_QUEUE_DESTROY_FORCE));
+	ppu.check_state();
+	ensure(CELL_OK == sys_ppu_thread_join(ppu, ppu_id, +vm::var<u64>{}));
 
 	return CELL_OK;
 }
@@ -967,18 +1668,21 @@ s32 cellFsAioRead(vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
 
 	auto& m = g_fxo->get<fs_aio_manager>();
 
-	if (!m.thread)
+	reader_lock lock(m.mutex);
+
+	if (!m.workers)
 	{
 		return CELL_ENXIO;
 	}
 
+	if (!m.in_flight.try_inc(CELL_FS_AIO_MAX_REQUEST))
+	{
+		return CELL_EBUSY;
+	}
+
 	const s32 xid = (*id = ++g_fs_aio_id);
 
-	m.thread->cmd_list
-	({
-		{ 1, xid },
-		{ aio, func },
-	});
+	m.submit(1, xid, aio, func);
 
 	return CELL_OK;
 }
@@ -991,18 +1695,21 @@ s32 cellFsAioWrite(vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
 
 	auto& m = g_fxo->get<fs_aio_manager>();
 
-	if (!m.thread)
+	reader_lock lock(m.mutex);
+
+	if (!m.workers)
 	{
 		return CELL_ENXIO;
 	}
 
+	if (!m.in_flight.try_inc(CELL_FS_AIO_MAX_REQUEST))
+	{
+		return CELL_EBUSY;
+	}
+
 	const s32 xid = (*id = ++g_fs_aio_id);
 
-	m.thread->cmd_list
-	({
-		{ 2, xid },
-		{ aio, func },
-	});
+	m.submit(2, xid, aio, func);
 
 	return CELL_OK;
 }
@@ -1044,6 +1751,8 @@ DECLARE(ppu_module_manager::cellFs)("sys_fs", []()
 	REG_FUNC(sys_fs, cellFsAioInit);
 	REG_FUNC(sys_fs, cellFsAioRead);
 	REG_FUNC(sys_fs, cellFsAioWrite);
+
+	REG_HIDDEN_FUNC(fs_aio_entry);
 	REG_FUNC(sys_fs, cellFsAllocateFileAreaByFdWithInitialData);
 	REG_FUNC(sys_fs, cellFsAllocateFileAreaByFdWithoutZeroFill);
 	REG_FUNC(sys_fs, cellFsAllocateFileAreaWithInitialData);
@@ -16,6 +16,7 @@
 #include "Loader/PSF.h"
 #include "Utilities/StrUtil.h"
 #include "Utilities/date_time.h"
+#include "Emu/perf_meter.hpp"
 
 #include <mutex>
 #include <algorithm>
@@ -1108,7 +1109,8 @@ static NEVER_INLINE error_code savedata_op(ppu_thread& ppu, u32 operation, u32 v
 			doneGet->excResult     = CELL_OK;
 			std::memset(doneGet->reserved, 0, sizeof(doneGet->reserved));
 
-			const std::string old_path = base_dir + ".backup_" + save_entries[selected].escaped + "/";
+			// Not ".backup_", which would be restored as an interrupted commit
+			const std::string old_path = base_dir + ".deleting_" + save_entries[selected].escaped + "/";
 			const std::string del_path = base_dir + save_entries[selected].escaped + "/";
 
 			const fs::dir _dir(del_path);
@@ -1126,7 +1128,7 @@ static NEVER_INLINE error_code savedata_op(ppu_thread& ppu, u32 operation, u32 v
 
 			if (_dir)
 			{
-				// Remove old backup
+				// Remove leftovers of an interrupted deletion
 				fs::remove_all(old_path);
 
 				// Remove savedata by renaming
@@ -1418,6 +1420,17 @@ static NEVER_INLINE error_code savedata_op(ppu_thread& ppu, u32 operation, u32 v
 	const std::string old_path = base_dir + ".backup_" + save_entry.escaped + "/";
 	const std::string new_path = base_dir + ".working_" + save_entry.escaped + "/";
 
+	if (!fs::is_dir(dir_path) && fs::is_dir(old_path))
+	{
+		// The previous commit was interrupted after the backup was made, restore it
+		cellSaveData.warning("savedata_op(): restoring interrupted savedata commit %s", old_path);
+
+		if (!vfs::host::rename(old_path, dir_path, &g_mp_sys_dev_hdd0, false))
+		{
+			cellSaveData.error("savedata_op(): failed to restore %s (%s)", old_path, fs::g_tls_error);
+		}
+	}
+
 	psf::registry psf = psf::load_object(dir_path + "PARAM.SFO");
 	bool has_modified = false;
 	bool recreated = false;
@@ -1711,14 +1724,16 @@ static NEVER_INLINE error_code savedata_op(ppu_thread& ppu, u32 operation, u32 v
 
 	// Enter the loop where the save files are read/created/deleted
 	std::map<std::string, std::pair<s64, s64>> all_times;
+
+	// Files of the save directory: closed until the game reads them, then a read-only handle to the file on disk
+	// Only files which are written become memory files, untouched files are hard-linked into the new directory on commit
 	std::map<std::string, fs::file> all_files;
+	std::set<std::string> modified_files;
 
-	// First, preload all files (TODO: beware of possible lag, although it should be insignificant)
 	for (auto&& entry : fs::dir(dir_path))
 	{
 		if (!recreated && !entry.is_directory)
 		{
-			// Read file into a vector and make a memory file
 			entry.name = vfs::unescape(entry.name);
 
 			if (check_filename(entry.name, false, true))
@@ -1727,10 +1742,46 @@ static NEVER_INLINE error_code savedata_op(ppu_thread& ppu, u32 operation, u32 v
 			}
 
 			all_times.emplace(entry.name, std::make_pair(entry.atime, entry.mtime));
-			all_files.emplace(std::move(entry.name), fs::make_stream(fs::file(dir_path + entry.name).to_vector<uchar>()));
+			all_files.emplace(std::move(entry.name), fs::file{});
 		}
 	}
 
+	// Get existing file for reading, opening it if necessary
+	const auto open_file = [&](const std::string& name) -> const fs::file*
+	{
+		const auto found = all_files.find(name);
+
+		if (found == all_files.end())
+		{
+			return nullptr;
+		}
+
+		if (!found->second)
+		{
+			found->second.open(dir_path + vfs::escape(name), fs::read);
+		}
+
+		return &found->second;
+	};
+
+	// Get memory file for writing, loading the file contents on first modification
+	const auto open_file_for_write = [&](const std::string& name) -> fs::file&
+	{
+		fs::file& file = all_files[name];
+
+		if (modified_files.emplace(name).second)
+		{
+			if (!file && all_times.count(name))
+			{
+				file.open(dir_path + vfs::escape(name), fs::read);
+			}
+
+			file = file ? fs::make_stream(file.to_vector<uchar>()) : fs::make_stream<std::vector<uchar>>();
+		}
+
+		return file;
+	};
+
 	fileGet->excSize = 0;
 
 	error_code savedata_result = CELL_OK;
@@ -1895,18 +1946,18 @@ static NEVER_INLINE error_code savedata_op(ppu_thread& ppu, u32 operation, u32 v
 				break;
 			}
 
-			const auto file = std::as_const(all_files).find(file_path);
+			const fs::file* file = open_file(file_path);
 			const u64 pos = fileSet->fileOffset;
 
-			if (file == all_files.cend() || file->second.size() <= pos)
+			if (!file || !*file || file->size() <= pos)
 			{
-				cellSaveData.error("Failed to open file %s%s (size=%d, fileOffset=%d)", dir_path, file_path, file == all_files.cend() ? -1 : file->second.size(), fileSet->fileOffset);
+				cellSaveData.error("Failed to open file %s%s (size=%d, fileOffset=%d)", dir_path, file_path, file && *file ? file->size() : -1, fileSet->fileOffset);
 				savedata_result = CELL_SAVEDATA_ERROR_FAILURE;
 				break;
 			}
 
-			// Read from memory file to vm
-			const u64 rr = lv2_file::op_read(file->second, fileSet->fileBuf, fileSet->fileSize, pos);
+			// Read from disk or memory file to vm
+			const u64 rr = lv2_file::op_read(*file, fileSet->fileBuf, fileSet->fileSize, pos);
 			fileGet->excSize = ::narrow<u32>(rr);
 			break;
 		}
@@ -1927,12 +1978,7 @@ static NEVER_INLINE error_code savedata_op(ppu_thread& ppu, u32 operation, u32 v
 				break;
 			}
 
-			fs::file& file = all_files[file_path];
-
-			if (!file)
-			{
-				file = fs::make_stream<std::vector<uchar>>();
-			}
+			fs::file& file = open_file_for_write(file_path);
 
 			// Write to memory file and truncate
 			const u64 sr = file.seek(fileSet->fileOffset);
@@ -1947,7 +1993,9 @@ static NEVER_INLINE error_code savedata_op(ppu_thread& ppu, u32 operation, u32 v
 
 		case CELL_SAVEDATA_FILEOP_DELETE:
 		{
-			// Delete memory file
+			// Delete memory file or reference to the file on disk
+			modified_files.erase(file_path);
+
 			if (all_files.erase(file_path) == 0)
 			{
 				cellSaveData.error("Failed to delete file %s%s", dir_path, file_path);
@@ -1979,12 +2027,7 @@ static NEVER_INLINE error_code savedata_op(ppu_thread& ppu, u32 operation, u32 v
 				break;
 			}
 
-			fs::file& file = all_files[file_path];
-
-			if (!file)
-			{
-				file = fs::make_stream<std::vector<uchar>>();
-			}
+			fs::file& file = open_file_for_write(file_path);
 
 			// Write to memory file normally
 			file.seek(fileSet->fileOffset);
@@ -2019,6 +2062,8 @@ static NEVER_INLINE error_code savedata_op(ppu_thread& ppu, u32 operation, u32 v
 	// Write PARAM.SFO and savedata
 	if (!psf.empty() && has_modified)
 	{
+		perf_meter<"SAVEDATA"_u64> perf0;
+
 		// First, create temporary directory
 		if (fs::create_dir(new_path) || fs::g_tls_error == fs::error::exist)
 		{
@@ -2038,22 +2083,48 @@ static NEVER_INLINE error_code savedata_op(ppu_thread& ppu, u32 operation, u32 v
 		auto& fsfo = all_files["PARAM.SFO"];
 		fsfo = fs::make_stream<std::vector<uchar>>();
 		fsfo.write(psf::save_object(psf));
+		modified_files.emplace("PARAM.SFO");
+
+		u64 written_bytes = 0;
+		usz linked_files = 0;
 
 		for (auto&& pair : all_files)
 		{
+			const std::string from = dir_path + vfs::escape(pair.first);
+			const std::string to = new_path + vfs::escape(pair.first);
+
+			if (!modified_files.count(pair.first))
+			{
+				// Close the file first, directories with open files can't be renamed on Windows
+				pair.second.close();
+
+				// Reuse unmodified file (copy it if the filesystem doesn't support hard links)
+				if (!fs::create_hard_link(from, to))
+				{
+					cellSaveData.warning("savedata_op(): failed to link %s (%s), copying", from, fs::g_tls_error);
+					ensure(fs::copy_file(from, to, false));
+				}
+
+				linked_files++;
+				continue;
+			}
+
 			if (auto file = pair.second.release())
 			{
 				auto&& fvec = static_cast<fs::container_stream<std::vector<uchar>>&>(*file);
+				written_bytes += fvec.obj.size();
 #ifdef _WIN32
-				fs::pending_file f(new_path + vfs::escape(pair.first));
+				fs::pending_file f(to);
 				f.file.write(fvec.obj);
 				ensure(f.commit());
 #else
-				ensure(fs::write_file(new_path + vfs::escape(pair.first), fs::rewrite, fvec.obj));
+				ensure(fs::write_file(to, fs::rewrite, fvec.obj));
 #endif
 			}
 		}
 
+		cellSaveData.notice("savedata_op(): committing %s (written=%u bytes, reused=%u files)", dir_path, written_bytes, linked_files);
+
 		for (auto&& pair : all_times)
 		{
 			// Restore atime/mtime for files which have not been modified
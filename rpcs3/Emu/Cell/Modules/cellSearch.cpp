@@ -1,4 +1,5 @@
 #include "stdafx.h"
+#include "Emu/System.h"
 #include "Emu/VFS.h"
 #include "Emu/IdManager.h"
 #include "Emu/Cell/PPUModule.h"
@@ -8,7 +9,10 @@
 
 #include "cellSearch.h"
 #include "Utilities/StrUtil.h"
+#include "Crypto/sha1.h"
 #include "util/media_utils.h"
+#include "util/sysinfo.hpp"
+#include "util/serialization.hpp"
 
 #include <random>
 
@@ -118,6 +122,307 @@ struct search_object_t
 
 static const std::string link_base = "/dev_hdd0/.tmp/"; // WipEout HD does not like it if we return a path starting with "/.tmp", so let's use "/dev_hdd0"
 
+// Persistent index of media metadata, keyed by host path and invalidated by file size and modification time
+struct media_info_index
+{
+	static constexpr u64 c_magic = "RPCS3MII"_u64;
+	static constexpr u32 c_version = 1;
+	static constexpr usz c_header_size = 32;
+
+	struct entry
+	{
+		u64 size = 0;
+		s64 mtime = 0;
+		s32 av_media_type = 0;
+		bool success = false;
+		utils::media_info info;
+
+		bool matches(const fs::stat_t& stat, s32 type) const
+		{
+			return size == stat.size && mtime == stat.mtime && av_media_type == type;
+		}
+	};
+
+	shared_mutex mutex;
+	std::unordered_map<std::string, entry> entries;
+	atomic_t<bool> loaded = false;
+	bool dirty = false;
+
+	media_info_index() = default;
+	media_info_index(const media_info_index&) = delete;
+	media_info_index& operator=(const media_info_index&) = delete;
+
+	~media_info_index()
+	{
+		// Store entries which were probed by single lookups
+		save();
+	}
+
+	static std::string get_path()
+	{
+		return fs::get_cache_dir() + "cache/media_index.dat";
+	}
+
+	void load()
+	{
+		if (loaded)
+		{
+			return;
+		}
+
+		std::lock_guard lock(mutex);
+
+		if (loaded)
+		{
+			return;
+		}
+
+		loaded = true;
+
+		const std::string path = get_path();
+		const fs::file file(path);
+
+		if (!file || file.size() < c_header_size)
+		{
+			return;
+		}
+
+		std::vector<u8> data = file.to_vector<u8>();
+
+		u8 digest[20];
+		sha1(data.data() + c_header_size, data.size() - c_header_size, digest);
+
+		if (read_from_ptr<le_t<u64>>(data, 0) != c_magic || read_from_ptr<le_t<u32>>(data, 8) != c_version || std::memcmp(data.data() + 12, digest, sizeof(digest)) != 0)
+		{
+			cellSearch.warning("Media index is outdated or damaged, ignoring: %s", path);
+			return;
+		}
+
+		data.erase(data.begin(), data.begin() + c_header_size);
+
+		utils::serial ar;
+		ar.set_reading_state(std::move(data));
+
+		usz count = 0;
+		ar(count);
+
+		for (usz i = 0; i < count; i++)
+		{
+			std::string host_path;
+			entry e;
+			utils::media_info& mi = e.info;
+			ar(host_path, e.size, e.mtime, e.av_media_type, e.success, mi.sub_type, mi.audio_av_codec_id, mi.video_av_codec_id, mi.audio_bitrate_bps,
+				mi.video_bitrate_bps, mi.sample_rate, mi.duration_us, mi.width, mi.height, mi.orientation, mi.metadata);
+
+			mi.path = host_path;
+			entries.emplace(std::move(host_path), std::move(e));
+		}
+
+		cellSearch.notice("Loaded media index with %d entries", entries.size());
+	}
+
+	void save()
+	{
+		utils::serial ar;
+		{
+			std::lock_guard lock(mutex);
+
+			if (!dirty)
+			{
+				return;
+			}
+
+			dirty = false;
+
+			usz count = entries.size();
+			ar(count);
+
+			for (auto& [host_path, e] : entries)
+			{
+				utils::media_info& mi = e.info;
+				ar(host_path, e.size, e.mtime, e.av_media_type, e.success, mi.sub_type, mi.audio_av_codec_id, mi.video_av_codec_id, mi.audio_bitrate_bps,
+					mi.video_bitrate_bps, mi.sample_rate, mi.duration_us, mi.width, mi.height, mi.orientation, mi.metadata);
+			}
+		}
+
+		std::vector<u8> header(c_header_size);
+		write_to_ptr<le_t<u64>>(header, 0, c_magic);
+		write_to_ptr<le_t<u32>>(header, 8, c_version);
+		sha1(ar.data.data(), ar.data.size(), header.data() + 12);
+
+		const std::string path = get_path();
+
+		if (!fs::create_path(fs::get_parent_dir(path)))
+		{
+			cellSearch.error("Failed to create media index directory: %s (%s)", fs::get_parent_dir(path), fs::g_tls_error);
+			return;
+		}
+
+		fs::pending_file file(path);
+
+		if (!file.file || (file.file.write(header), file.file.write(ar.data), !file.commit()))
+		{
+			cellSearch.error("Failed to write media index: %s (%s)", path, fs::g_tls_error);
+		}
+	}
+
+	// Get media info from the index, probing the file if it isn't indexed yet or was modified
+	std::pair<bool, utils::media_info> get(const std::string& host_path, const fs::stat_t& stat, s32 av_media_type)
+	{
+		load();
+
+		{
+			reader_lock lock(mutex);
+
+			if (const auto found = entries.find(host_path); found != entries.end() && found->second.matches(stat, av_media_type))
+			{
+				return { found->second.success, found->second.info };
+			}
+		}
+
+		auto [success, mi] = utils::get_media_info(host_path, av_media_type);
+
+		std::lock_guard lock(mutex);
+		entries.insert_or_assign(host_path, entry{ stat.size, stat.mtime, av_media_type, success, mi });
+		dirty = true;
+
+		return { success, std::move(mi) };
+	}
+
+	// Probe all files which aren't indexed yet or were modified, in parallel
+	void update(const std::vector<std::pair<std::string, fs::stat_t>>& files, s32 av_media_type)
+	{
+		load();
+
+		std::vector<usz> missing;
+		{
+			reader_lock lock(mutex);
+
+			for (usz i = 0; i < files.size(); i++)
+			{
+				if (const auto found = entries.find(files[i].first); found == entries.end() || !found->second.matches(files[i].second, av_media_type))
+				{
+					missing.push_back(i);
+				}
+			}
+		}
+
+		if (missing.empty())
+		{
+			return;
+		}
+
+		std::vector<std::pair<bool, utils::media_info>> results(missing.size());
+		atomic_t<usz> next = 0;
+
+		const auto probe = [&]()
+		{
+			for (usz i; !Emu.IsStopped() && (i = next++) < missing.size();)
+			{
+				results[i] = utils::get_media_info(files[missing[i]].first, av_media_type);
+			}
+		};
+
+		if (const u32 thread_count = std::min<u32>(utils::get_thread_count(), ::narrow<u32>(missing.size())); thread_count > 1)
+		{
+			named_thread_group workers("cellSearch Probe ", thread_count, [&]() { probe(); });
+			workers.join();
+		}
+		else
+		{
+			probe();
+		}
+
+		if (Emu.IsStopped())
+		{
+			return;
+		}
+
+		{
+			std::lock_guard lock(mutex);
+
+			for (usz i = 0; i < missing.size(); i++)
+			{
+				const auto& [host_path, stat] = files[missing[i]];
+				entries.insert_or_assign(host_path, entry{ stat.size, stat.mtime, av_media_type, results[i].first, std::move(results[i].second) });
+			}
+
+			dirty = true;
+		}
+
+		cellSearch.notice("Media index: probed %d files", missing.size());
+		save();
+	}
+
+	// Index all files in a virtual directory
+	void update_dir(const std::string& vpath, s32 av_media_type, bool recursive)
+	{
+		std::vector<std::pair<std::string, fs::stat_t>> files;
+
+		std::function<void(const std::string&)> collect = [&](const std::string& dir_vpath)
+		{
+			for (auto&& item : fs::dir(vfs::get(dir_vpath)))
+			{
+				item.name = vfs::unescape(item.name);
+
+				if (item.name == "." || item.name == "..")
+				{
+					continue;
+				}
+
+				const std::string item_vpath = dir_vpath + "/" + item.name;
+
+				if (item.is_directory)
+				{
+					if (recursive && !Emu.IsStopped())
+					{
+						collect(item_vpath);
+					}
+
+					continue;
+				}
+
+				files.emplace_back(vfs::get(item_vpath), item);
+			}
+		};
+
+		collect(vpath);
+		update(files, av_media_type);
+	}
+};
+
+// Fills the media index in the background after cellSearchInitialize
+struct media_index_thread_info
+{
+	atomic_t<u32> requested = 0;
+
+	void operator()()
+	{
+		while (thread_ctrl::state() != thread_state::aborting)
+		{
+			if (!requested.exchange(0))
+			{
+				thread_ctrl::wait_on(requested, 0);
+				continue;
+			}
+
+			auto& index = g_fxo->get<media_info_index>();
+			index.update_dir("/dev_hdd0/music", 1, true); // AVMEDIA_TYPE_AUDIO
+			index.update_dir("/dev_hdd0/video", 0, true); // AVMEDIA_TYPE_VIDEO
+		}
+	}
+
+	void request()
+	{
+		requested = 1;
+		requested.notify_one();
+	}
+
+	static constexpr auto thread_name = "cellSearch Media Index"sv;
+};
+
+using media_index_thread = named_thread<media_index_thread_info>;
+
 error_code check_search_state(search_state state, search_state action)
 {
 	switch (action)
@@ -447,6 +752,9 @@ error_code cellSearchInitialize(CellSearchMode mode, u32 container, vm::ptr<Cell
 	search.func = func;
 	search.userData = userData;
 
+	// Start indexing media files early, searches only need to probe what was added since
+	g_fxo->get<media_index_thread>().request();
+
 	sysutil_register_cb([=, &search](ppu_thread& ppu) -> s32
 	{
 		search.state.store(search_state::idle);
@@ -798,7 +1106,7 @@ error_code cellSearchStartContentSearchInList(vm::cptr<CellSearchContentId> list
 
 	const u32 id = *outSearchId = idm::make<search_object_t>();
 
-	sysutil_register_cb([=, list_path = std::string(content_info->infoPath.contentPath), &search, &content_map](ppu_thread& ppu) -> s32
+	sysutil_register_cb([=, list_path = std::string(content_info->infoPath.contentPath), &search, &content_map, &media_index = g_fxo->get<media_info_index>()](ppu_thread& ppu) -> s32
 	{
 		auto curr_search = idm::get<search_object_t>(id);
 		vm::var<CellSearchResultParam> resultParam;
@@ -842,6 +1150,19 @@ error_code cellSearchStartContentSearchInList(vm::cptr<CellSearchContentId> list
 
 			// TODO: Use sortKey (CellSearchSortKey) to allow for sorting by category
 
+			if (type == CELL_SEARCH_CONTENTSEARCHTYPE_MUSIC_ALL || type == CELL_SEARCH_CONTENTSEARCHTYPE_VIDEO_ALL)
+			{
+				// Probe new or modified files in parallel, so the loop below only needs index lookups
+				std::vector<std::pair<std::string, fs::stat_t>> files;
+
+				for (const auto& item : files_sorted)
+				{
+					files.emplace_back(vfs::get(vpath + "/" + item.name), item);
+				}
+
+				media_index.update(files, type == CELL_SEARCH_CONTENTSEARCHTYPE_MUSIC_ALL ? 1 : 0);
+			}
+
 			for (auto&& item : files_sorted)
 			{
 				// TODO
@@ -880,7 +1201,7 @@ error_code cellSearchStartContentSearchInList(vm::cptr<CellSearchContentId> list
 						curr_find->type = CELL_SEARCH_CONTENTTYPE_MUSIC;
 
 						const std::string path = vfs::get(item_path);
-						const auto [success, mi] = utils::get_media_info(path, 1); // AVMEDIA_TYPE_AUDIO
+						const auto [success, mi] = media_index.get(path, item, 1); // AVMEDIA_TYPE_AUDIO
 						if (!success)
 						{
 							continue;
@@ -901,7 +1222,7 @@ error_code cellSearchStartContentSearchInList(vm::cptr<CellSearchContentId> list
 						curr_find->type = CELL_SEARCH_CONTENTTYPE_VIDEO;
 
 						const std::string path = vfs::get(item_path);
-						const auto [success, mi] = utils::get_media_info(path, 0); // AVMEDIA_TYPE_VIDEO
+						const auto [success, mi] = media_index.get(path, item, 0); // AVMEDIA_TYPE_VIDEO
 						if (!success)
 						{
 							continue;
@@ -1058,7 +1379,7 @@ error_code cellSearchStartContentSearch(CellSearchContentSearchType type, CellSe
 
 	const u32 id = *outSearchId = idm::make<search_object_t>();
 
-	sysutil_register_cb([=, &content_map = g_fxo->get<content_id_map>(), &search](ppu_thread& ppu) -> s32
+	sysutil_register_cb([=, &content_map = g_fxo->get<content_id_map>(), &search, &media_index = g_fxo->get<media_info_index>()](ppu_thread& ppu) -> s32
 	{
 		auto curr_search = idm::get<search_object_t>(id);
 		vm::var<CellSearchResultParam> resultParam;
@@ -1121,7 +1442,7 @@ error_code cellSearchStartContentSearch(CellSearchContentSearchType type, CellSe
 						curr_find->type = CELL_SEARCH_CONTENTTYPE_MUSIC;
 
 						const std::string path = vfs::get(item_path);
-						const auto [success, mi] = utils::get_media_info(path, 1); // AVMEDIA_TYPE_AUDIO
+						const auto [success, mi] = media_index.get(path, item, 1); // AVMEDIA_TYPE_AUDIO
 						if (!success)
 						{
 							continue;
@@ -1142,7 +1463,7 @@ error_code cellSearchStartContentSearch(CellSearchContentSearchType type, CellSe
 						curr_find->type = CELL_SEARCH_CONTENTTYPE_VIDEO;
 
 						const std::string path = vfs::get(item_path);
-						const auto [success, mi] = utils::get_media_info(path, 0); // AVMEDIA_TYPE_VIDEO
+						const auto [success, mi] = media_index.get(path, item, 0); // AVMEDIA_TYPE_VIDEO
 						if (!success)
 						{
 							continue;
@@ -1177,6 +1498,12 @@ error_code cellSearchStartContentSearch(CellSearchContentSearchType type, CellSe
 			}
 		};
 
+		if (type == CELL_SEARCH_CONTENTSEARCHTYPE_MUSIC_ALL || type == CELL_SEARCH_CONTENTSEARCHTYPE_VIDEO_ALL)
+		{
+			// Probe new or modified files in parallel, so the search only needs index lookups
+			media_index.update_dir(fmt::format("/dev_hdd0/%s", media_dir), type == CELL_SEARCH_CONTENTSEARCHTYPE_MUSIC_ALL ? 1 : 0, true);
+		}
+
 		searchInFolder(fmt::format("/dev_hdd0/%s", media_dir), "");
 		resultParam->resultNum = ::narrow<s32>(curr_search->content_ids.size());
 
@@ -2237,7 +2564,7 @@ error_code music_selection_context::find_content_id(vm::ptr<CellSearchContentId>
 
 			if (hash == file_hash)
 			{
-				const auto [success, mi] = utils::get_media_info(vfs_dir_path + "/" + item.name, 1); // AVMEDIA_TYPE_AUDIO
+				const auto [success, mi] = g_fxo->get<media_info_index>().get(vfs_dir_path + "/" + item.name, item, 1); // AVMEDIA_TYPE_AUDIO
 				if (!success)
 				{
 					continue;
@@ -4,10 +4,15 @@
 #include "PPUOpcodes.h"
 #include "PPUModule.h"
 #include "Emu/system_config.h"
+#include "Crypto/sha1.h"
+#include "Utilities/File.h"
+#include "Utilities/Thread.h"
 
 #include <unordered_set>
 #include "util/yaml.hpp"
 #include "util/asm.hpp"
+#include "util/sysinfo.hpp"
+#include "util/serialization.hpp"
 
 LOG_CHANNEL(ppu_validator);
 
@@ -530,6 +535,198 @@ namespace ppu_patterns
 	};
 }
 
+namespace
+{
+	// Function information used during analysis (flattened to ppu_function when done)
+	struct ppu_function_ext
+	{
+		u32 addr = 0;
+		u32 toc = 0;
+		u32 size = 0;
+		bs_t<ppu_attr> attr{};
+
+		u32 stack_frame = 0;
+		u32 trampoline = 0;
+
+		std::map<u32, u32> blocks{}; // Basic blocks: addr -> size
+		std::set<u32> calls{}; // Set of called functions
+		std::set<u32> callers{};
+		std::string name{}; // Function name
+
+		ppu_function flatten() &&
+		{
+			ppu_function r;
+			r.addr = addr;
+			r.toc = toc;
+			r.size = size;
+			r.attr = attr;
+			r.stack_frame = stack_frame;
+			r.trampoline = trampoline;
+			r.blocks.assign(blocks.begin(), blocks.end());
+			r.calls.assign(calls.begin(), calls.end());
+			r.callers.assign(callers.begin(), callers.end());
+			r.name = std::move(name);
+			return r;
+		}
+	};
+
+	// Persistent analysis results, allows to skip analysis of unchanged modules entirely
+	struct ppu_analysis_cache
+	{
+		static constexpr u64 c_magic = "RPCS3PPA"_u64;
+		static constexpr u32 c_version = 1;
+		static constexpr usz c_header_size = 32;
+
+		// Get file path for given module and analysis parameters, empty if the module can't be cached
+		static std::string get_path(const ppu_module& info, u32 lib_toc, u32 entry, u32 sec_end, const std::basic_string<u32>& applied)
+		{
+			if (std::all_of(std::begin(info.sha1), std::end(info.sha1), FN(x == 0)))
+			{
+				return {};
+			}
+
+			sha1_context ctx;
+			sha1_starts(&ctx);
+
+			const auto add = [&](const auto& value)
+			{
+				sha1_update(&ctx, reinterpret_cast<const u8*>(&value), sizeof(value));
+			};
+
+			add(lib_toc);
+			add(entry);
+			add(sec_end);
+
+			for (const auto& seg : info.segs)
+			{
+				add(seg.addr);
+				add(seg.size);
+
+				if (!applied.empty() && seg.ptr)
+				{
+					// Patched memory contents aren't covered by the module hash
+					sha1_update(&ctx, static_cast<const u8*>(seg.ptr), seg.size);
+				}
+			}
+
+			for (const auto& sec : info.secs)
+			{
+				add(sec.addr);
+				add(sec.size);
+			}
+
+			u8 key[20];
+			sha1_finish(&ctx, key);
+
+			return fs::get_cache_dir() + fmt::format("cache/ppu_analysis/%s-%s.dat", fmt::base57(info.sha1), fmt::base57(key));
+		}
+
+		static bool serialize(utils::serial& ar, std::vector<ppu_function>& funcs)
+		{
+			usz count = funcs.size();
+			ar(count);
+
+			if (!ar.is_writing())
+			{
+				funcs.resize(count);
+			}
+
+			std::vector<u32> flat_blocks;
+
+			for (ppu_function& func : funcs)
+			{
+				if (ar.is_writing())
+				{
+					flat_blocks.clear();
+
+					for (const auto& [addr, size] : func.blocks)
+					{
+						flat_blocks.push_back(addr);
+						flat_blocks.push_back(size);
+					}
+				}
+
+				ar(func.addr, func.toc, func.size, func.attr, func.stack_frame, func.trampoline, func.name, flat_blocks, func.calls, func.callers);
+
+				if (!ar.is_writing())
+				{
+					if (flat_blocks.size() % 2)
+					{
+						return false;
+					}
+
+					func.blocks.resize(flat_blocks.size() / 2);
+
+					for (usz i = 0; i < func.blocks.size(); i++)
+					{
+						func.blocks[i] = {flat_blocks[i * 2], flat_blocks[i * 2 + 1]};
+					}
+				}
+			}
+
+			return true;
+		}
+
+		static bool load(const std::string& path, std::vector<ppu_function>& funcs)
+		{
+			const fs::file file(path);
+
+			if (!file || file.size() < c_header_size)
+			{
+				return false;
+			}
+
+			std::vector<u8> data = file.to_vector<u8>();
+
+			u8 digest[20];
+			sha1(data.data() + c_header_size, data.size() - c_header_size, digest);
+
+			if (read_from_ptr<le_t<u64>>(data, 0) != c_magic || read_from_ptr<le_t<u32>>(data, 8) != c_version || std::memcmp(data.data() + 12, digest, sizeof(digest)) != 0)
+			{
+				ppu_log.warning("PPU analysis cache is outdated or damaged, ignoring: %s", path);
+				return false;
+			}
+
+			data.erase(data.begin(), data.begin() + c_header_size);
+
+			utils::serial ar;
+			ar.set_reading_state(std::move(data));
+
+			if (!serialize(ar, funcs))
+			{
+				funcs.clear();
+				return false;
+			}
+
+			return true;
+		}
+
+		static void save(const std::string& path, std::vector<ppu_function>& funcs)
+		{
+			utils::serial ar;
+			serialize(ar, funcs);
+
+			std::vector<u8> header(c_header_size);
+			write_to_ptr<le_t<u64>>(header, 0, c_magic);
+			write_to_ptr<le_t<u32>>(header, 8, c_version);
+			sha1(ar.data.data(), ar.data.size(), header.data() + 12);
+
+			if (!fs::create_path(fs::get_parent_dir(path)))
+			{
+				ppu_log.error("Failed to create PPU analysis cache directory: %s (%s)", fs::get_parent_dir(path), fs::g_tls_error);
+				return;
+			}
+
+			fs::pending_file file(path);
+
+			if (!file.file || (file.file.write(header), file.file.write(ar.data), !file.commit()))
+			{
+				ppu_log.error("Failed to write PPU analysis cache: %s (%s)", path, fs::g_tls_error);
+			}
+		}
+	};
+}
+
 bool ppu_module::analyse(u32 lib_toc, u32 entry, const u32 sec_end, const std::basic_string<u32>& applied, std::function<bool()> check_aborted)
 {
 	if (segs.empty())
@@ -537,6 +734,15 @@ bool ppu_module::analyse(u32 lib_toc, u32 entry, const u32 sec_end, const std::b
 		return false;
 	}
 
+	// Reuse results of the previous analysis if possible (only if nothing was added to this module before)
+	const std::string cache_path = funcs.empty() ? ppu_analysis_cache::get_path(*this, lib_toc, entry, sec_end, applied) : std::string{};
+
+	if (!cache_path.empty() && ppu_analysis_cache::load(cache_path, funcs))
+	{
+		ppu_log.notice("Loaded PPU analysis cache: %zu blocks (%s)", funcs.size(), cache_path);
+		return true;
+	}
+
 	// Assume first segment is executable
 	const u32 start = segs[0].addr;
 
@@ -547,11 +753,11 @@ bool ppu_module::analyse(u32 lib_toc, u32 entry, const u32 sec_end, const std::b
 	std::unordered_set<u32> TOCs;
 
 	// Known functions
-	std::map<u32, ppu_function> fmap;
+	std::map<u32, ppu_function_ext> fmap;
 	std::set<u32> known_functions;
 
 	// Function analysis workload
-	std::vector<std::reference_wrapper<ppu_function>> func_queue;
+	std::vector<std::reference_wrapper<ppu_function_ext>> func_queue;
 
 	// Known references (within segs, addr and value alignment = 4)
 	std::set<u32> addr_heap;
@@ -605,9 +811,9 @@ bool ppu_module::analyse(u32 lib_toc, u32 entry, const u32 sec_end, const std::b
 	};
 
 	// Register new function
-	auto add_func = [&](u32 addr, u32 toc, u32 caller) -> ppu_function&
+	auto add_func = [&](u32 addr, u32 toc, u32 caller) -> ppu_function_ext&
 	{
-		ppu_function& func = fmap[addr];
+		ppu_function_ext& func = fmap[addr];
 
 		if (caller)
 		{
@@ -687,34 +893,60 @@ bool ppu_module::analyse(u32 lib_toc, u32 entry, const u32 sec_end, const std::b
 		return it == known_functions.end() ? end : *it;
 	};
 
-	// Find references indiscriminately
-	for (const auto& seg : segs)
+	// Find references indiscriminately (chunks are independent and scanned in parallel)
+	if (std::any_of(segs.begin(), segs.end(), FN(x.addr != 0)))
 	{
-		if (seg.size < 4) continue;
+		constexpr u32 chunk_size = 0x40000;
 
-		vm::cptr<u32> _ptr = vm::cast(seg.addr);
-		const vm::cptr<void> seg_end = vm::cast(seg.addr + seg.size - 4);
-		auto ptr = get_ptr<u32>(_ptr);
+		// Segment index, offset
+		std::vector<std::pair<u32, u32>> chunks;
 
-		for (vm::cptr<u32> _ptr = vm::cast(seg.addr); _ptr <= seg_end; advance(_ptr, ptr, 1))
+		for (u32 i = 0; i < segs.size(); i++)
 		{
-			const u32 value = *ptr;
-
-			if (value % 4)
+			for (u32 off = 0; off < segs[i].size / 4 * 4; off += chunk_size)
 			{
-				continue;
+				chunks.emplace_back(i, off);
 			}
+		}
+
+		std::vector<std::vector<u32>> chunk_refs(chunks.size());
+
+		atomic_t<u32> chunk_index = 0;
 
-			for (const auto& _seg : segs)
+		auto scan_chunks = [&]()
+		{
+			for (u32 i = chunk_index++; i < chunks.size(); i = chunk_index++)
 			{
-				if (!_seg.addr) continue;
+				const auto& seg = segs[chunks[i].first];
+				const u32 off = chunks[i].second;
+				const u32 count = std::min<u32>(chunk_size, seg.size / 4 * 4 - off) / 4;
+				const auto ptr = get_ptr<u32>(seg.addr + off);
 
-				if (value >= start && value < end)
+				for (u32 j = 0; j < count; j++)
 				{
-					addr_heap.emplace(value);
-					break;
+					const u32 value = ptr[j];
+
+					if (value % 4 == 0 && value >= start && value < end)
+					{
+						chunk_refs[i].push_back(value);
+					}
 				}
 			}
+		};
+
+		if (const u32 thread_count = std::min<u32>(utils::get_thread_count(), ::size32(chunks)); thread_count > 1)
+		{
+			named_thread_group workers("PPU Analyser ", thread_count, [&]() { scan_chunks(); });
+			workers.join();
+		}
+		else
+		{
+			scan_chunks();
+		}
+
+		for (const auto& refs : chunk_refs)
+		{
+			addr_heap.insert(refs.begin(), refs.end());
 		}
 	}
 
@@ -937,14 +1169,14 @@ bool ppu_module::analyse(u32 lib_toc, u32 entry, const u32 sec_end, const std::b
 			return false;
 		}
 
-		ppu_function& func = func_queue[i];
+		ppu_function_ext& func = func_queue[i];
 
 		// Fixup TOCs
 		if (func.toc && func.toc != umax)
 		{
 			for (u32 addr : func.callers)
 			{
-				ppu_function& caller = fmap[addr];
+				ppu_function_ext& caller = fmap[addr];
 
 				if (!caller.toc)
 				{
@@ -954,7 +1186,7 @@ bool ppu_module::analyse(u32 lib_toc, u32 entry, const u32 sec_end, const std::b
 
 			for (u32 addr : func.calls)
 			{
-				ppu_function& callee = fmap[addr];
+				ppu_function_ext& callee = fmap[addr];
 
 				if (!callee.toc)
 				{
@@ -2036,7 +2268,7 @@ bool ppu_module::analyse(u32 lib_toc, u32 entry, const u32 sec_end, const std::b
 			continue;
 		}
 
-		funcs.emplace_back(std::move(block));
+		funcs.emplace_back(std::move(block).flatten());
 	}
 
 	if (per_instruction_bytes)
@@ -2046,6 +2278,12 @@ bool ppu_module::analyse(u32 lib_toc, u32 entry, const u32 sec_end, const std::b
 	}
 
 	ppu_log.notice("Block analysis: %zu blocks (%zu enqueued)", funcs.size(), block_queue.size());
+
+	if (!cache_path.empty())
+	{
+		ppu_analysis_cache::save(cache_path, funcs);
+	}
+
 	return true;
 }
 
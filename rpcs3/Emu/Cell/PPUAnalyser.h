@@ -35,9 +35,9 @@ struct ppu_function
 	u32 stack_frame = 0;
 	u32 trampoline = 0;
 
-	std::map<u32, u32> blocks{}; // Basic blocks: addr -> size
-	std::set<u32> calls{}; // Set of called functions
-	std::set<u32> callers{};
+	std::vector<std::pair<u32, u32>> blocks{}; // Basic blocks: addr -> size (sorted by addr)
+	std::vector<u32> calls{}; // Called functions (sorted)
+	std::vector<u32> callers{}; // (sorted)
 	std::string name{}; // Function name
 };
 
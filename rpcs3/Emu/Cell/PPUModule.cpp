@@ -650,6 +650,47 @@ extern u32 ppu_get_exported_func_addr(u32 fnid, const std::string& module_name)
 	return g_fxo->get<ppu_linkage_info>().modules[module_name].functions[fnid].export_addr;
 }
 
+// Get code addresses of linked functions with their names (for diagnostic purposes)
+extern std::vector<std::pair<u32, std::string>> ppu_get_exported_function_names()
+{
+	std::vector<std::pair<u32, std::string>> result;
+
+	const auto link = g_fxo->try_get<ppu_linkage_info>();
+	const auto fman = g_fxo->try_get<ppu_function_manager>();
+
+	if (!link || !fman)
+	{
+		return result;
+	}
+
+	reader_lock lock(link->mutex);
+
+	for (const auto& [module_name, _module] : link->modules)
+	{
+		for (const auto& [fnid, flink] : _module.functions)
+		{
+			u32 addr = 0;
+
+			if (flink.export_addr && vm::check_addr(flink.export_addr, vm::page_readable, 4))
+			{
+				// Read code address from function descriptor
+				addr = vm::read32(flink.export_addr);
+			}
+			else if (flink.static_func)
+			{
+				addr = fman->func_addr(flink.static_func->index, true);
+			}
+
+			if (addr)
+			{
+				result.emplace_back(addr, fmt::format("%s!%s", module_name, ppu_get_function_name(module_name, fnid)));
+			}
+		}
+	}
+
+	return result;
+}
+
 extern bool ppu_register_library_lock(std::string_view libname, bool lock_lib)
 {
 	auto link = g_fxo->try_get<ppu_linkage_info>();
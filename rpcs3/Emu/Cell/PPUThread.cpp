@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Utilities/JIT.h"
 #include "Utilities/StrUtil.h"
+#include "Utilities/bin_patch.h"
 #include "util/serialization.hpp"
 #include "Crypto/sha1.h"
 #include "Crypto/unself.h"
@@ -175,7 +176,7 @@ bool serialize<ppu_thread::cr_bits>(utils::serial& ar, typename ppu_thread::cr_b
 extern void ppu_initialize();
 extern void ppu_finalize(const ppu_module& info);
 extern bool ppu_initialize(const ppu_module& info, bool = false);
-static void ppu_initialize2(class jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name);
+static void ppu_initialize2(class jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name, bool use_cache = true);
 extern bool ppu_load_exec(const ppu_exec_object&, bool virtual_load, const std::string&, utils::serial* = nullptr);
 extern std::pair<std::shared_ptr<lv2_overlay>, CellError> ppu_load_overlay(const ppu_exec_object&, bool virtual_load, const std::string& path, s64 file_offset, utils::serial* = nullptr);
 extern void ppu_unload_prx(const lv2_prx&);
@@ -2316,6 +2317,9 @@ ppu_thread::ppu_thread(const ppu_thread_params& param, std::string_view name, u3
 #endif
 }
 
+// PPU object file version (part of the object name)
+static constexpr auto c_ppu_obj_version = "v6-kusa";
+
 struct disable_precomp_t
 {
 	atomic_t<bool> disable = false;
@@ -3566,6 +3570,302 @@ extern void ppu_finalize(const ppu_module& info)
 #endif
 }
 
+// Persistent record of precompiled files and their object files, allows skipping decryption and analysis of unchanged files
+struct ppu_precompile_manifest
+{
+	static constexpr u64 c_magic = "RPCS3PPM"_u64;
+	static constexpr u32 c_version = 2;
+
+	struct entry
+	{
+		std::string path;
+		u64 offset = 0; // MSELF record offset
+		u64 size = 0;
+		s64 mtime = 0;
+		std::string title; // Title ID the cache path was created for (empty for dev_flash)
+		std::array<u8, 20> sha1{};
+		std::string cache_path;
+		std::vector<std::string> objects;
+		std::vector<std::string> patch_names; // Hashes the patch engine matches against this module
+
+		void operator()(utils::serial& ar)
+		{
+			ar(path, offset, size, mtime, title, sha1, cache_path, objects, patch_names);
+		}
+	};
+
+	// Result reported by ppu_initialize
+	struct result
+	{
+		std::array<u8, 20> sha1{};
+		std::string cache_path;
+		std::vector<std::string> objects;
+	};
+
+	shared_mutex mutex;
+
+	// Fingerprint of the settings which affect object names
+	u64 settings = 0;
+
+	// Path + offset -> entry
+	std::map<std::pair<std::string, u64>, entry> entries;
+
+	// Module path -> result (filled during precompilation)
+	std::unordered_map<std::string, result> results;
+
+	bool dirty = false;
+
+	static std::string get_path()
+	{
+		return fs::get_cache_dir() + "cache/ppu_precompile_manifest.dat";
+	}
+
+	void load(u64 current_settings)
+	{
+		std::lock_guard lock(mutex);
+
+		entries.clear();
+		results.clear();
+		settings = current_settings;
+		dirty = false;
+
+		const fs::file file(get_path());
+
+		if (!file || file.size() < 24)
+		{
+			return;
+		}
+
+		std::vector<u8> data = file.to_vector<u8>();
+
+		// Header: magic, version, payload crc, settings
+		const u64 magic = read_from_ptr<le_t<u64>>(data, 0);
+		const u32 version = read_from_ptr<le_t<u32>>(data, 8);
+		const u32 stored_crc = read_from_ptr<le_t<u32>>(data, 12);
+		const u64 old_settings = read_from_ptr<le_t<u64>>(data, 16);
+
+		if (magic != c_magic || version != c_version || stored_crc != crc(data.data() + 24, data.size() - 24))
+		{
+			ppu_log.warning("PPU precompilation manifest is outdated or damaged, ignoring.");
+			dirty = true;
+			return;
+		}
+
+		if (old_settings != current_settings)
+		{
+			// Object names depend on settings
+			ppu_log.notice("PPU precompilation manifest was created with different settings, ignoring.");
+			dirty = true;
+			return;
+		}
+
+		data.erase(data.begin(), data.begin() + 24);
+
+		utils::serial ar;
+		ar.set_reading_state(std::move(data));
+
+		std::vector<entry> list;
+		ar(list);
+
+		for (auto& e : list)
+		{
+			auto key = std::make_pair(e.path, e.offset);
+			entries.emplace(std::move(key), std::move(e));
+		}
+	}
+
+	void save()
+	{
+		std::lock_guard lock(mutex);
+
+		if (!dirty)
+		{
+			return;
+		}
+
+		std::vector<entry> list;
+		list.reserve(entries.size());
+
+		for (auto& [key, e] : entries)
+		{
+			list.emplace_back(e);
+		}
+
+		utils::serial ar;
+		ar(list);
+
+		std::vector<u8> header(24);
+		write_to_ptr<le_t<u64>>(header, 0, c_magic);
+		write_to_ptr<le_t<u32>>(header, 8, c_version);
+		write_to_ptr<le_t<u32>>(header, 12, crc(ar.data.data(), ar.data.size()));
+		write_to_ptr<le_t<u64>>(header, 16, settings);
+
+		fs::pending_file file(get_path());
+
+		if (!file.file || (file.file.write(header), file.file.write(ar.data), !file.commit()))
+		{
+			ppu_log.error("Failed to write PPU precompilation manifest: %s (%s)", get_path(), fs::g_tls_error);
+			return;
+		}
+
+		dirty = false;
+	}
+
+	static u32 crc(const u8* data, usz size)
+	{
+		// FNV-1a, only used to detect truncated or damaged files
+		u32 hash = 0x811c9dc5;
+
+		for (usz i = 0; i < size; i++)
+		{
+			hash = (hash ^ data[i]) * 0x01000193;
+		}
+
+		return hash;
+	}
+
+	// Check if the file was precompiled with current settings and all its objects still exist
+	bool is_up_to_date(const std::string& path, u64 offset, const fs::stat_t& stat)
+	{
+		reader_lock lock(mutex);
+
+		const auto found = entries.find(std::make_pair(path, offset));
+
+		if (found == entries.end())
+		{
+			return false;
+		}
+
+		const entry& e = found->second;
+
+		if (e.size != stat.size || e.mtime != stat.mtime || (!e.title.empty() && e.title != Emu.GetTitleID()))
+		{
+			return false;
+		}
+
+		// Patches change the module hash and object names, never skip patchable modules
+		const auto& patches = g_fxo->get<patch_engine>();
+
+		for (const std::string& name : e.patch_names)
+		{
+			if (patches.has_patches(name) || (!Emu.GetTitleID().empty() && patches.has_patches(Emu.GetTitleID() + '-' + name)))
+			{
+				ppu_log.notice("Not skipping patchable file: %s (patch=%s)", path, name);
+				return false;
+			}
+		}
+
+		for (const std::string& obj : e.objects)
+		{
+			if (!fs::is_file(e.cache_path + obj) && !fs::is_file(e.cache_path + obj + ".gz"))
+			{
+				return false;
+			}
+		}
+
+		return !e.objects.empty();
+	}
+
+	// Called by ppu_initialize after a module has been fully compiled
+	void set_objects(const ppu_module& info, const std::string& cache_path, const std::vector<std::pair<std::string, bool>>& link_workload)
+	{
+		std::lock_guard lock(mutex);
+
+		result& r = results[info.path];
+		std::memcpy(r.sha1.data(), info.sha1, sizeof(info.sha1));
+		r.cache_path = cache_path;
+		r.objects.clear();
+
+		for (const auto& [obj_name, is_compiled] : link_workload)
+		{
+			r.objects.emplace_back(obj_name);
+		}
+	}
+
+	// Get the patch names of a PRX or an overlay (see ppu_load_prx and ppu_load_overlay)
+	static std::vector<std::string> get_patch_names(const ppu_module& info, bool is_prx)
+	{
+		std::vector<std::string> names;
+
+		if (is_prx)
+		{
+			const std::string hash = fmt::format("PRX-%s", fmt::base57(info.sha1));
+
+			for (usz i = 0; i < info.segs.size(); i++)
+			{
+				if (info.segs[i].size)
+				{
+					names.emplace_back(fmt::format("%s-%u", hash, i));
+				}
+			}
+		}
+		else
+		{
+			std::string hash = "OVL-";
+
+			for (u8 byte : info.sha1)
+			{
+				fmt::append(hash, "%02x", byte);
+			}
+
+			names.emplace_back(std::move(hash));
+		}
+
+		return names;
+	}
+
+	// Move the result of the precompiled module into the manifest
+	void commit(const ppu_module& info, bool is_prx, const std::string& path, u64 offset, const fs::stat_t& stat)
+	{
+		const std::string& module_path = info.path;
+		std::vector<std::string> patch_names = get_patch_names(info, is_prx);
+
+		std::lock_guard lock(mutex);
+
+		const auto found = results.find(module_path);
+
+		if (found == results.end())
+		{
+			return;
+		}
+
+		entry& e = entries[std::make_pair(path, offset)];
+		e.path = path;
+		e.offset = offset;
+		e.size = stat.size;
+		e.mtime = stat.mtime;
+		e.title = path.starts_with(vfs::get("/dev_flash/")) ? std::string{} : Emu.GetTitleID();
+		e.sha1 = found->second.sha1;
+		e.cache_path = std::move(found->second.cache_path);
+		e.objects = std::move(found->second.objects);
+		e.patch_names = std::move(patch_names);
+		results.erase(found);
+		dirty = true;
+	}
+};
+
+// Hash of every setting which affects PPU object names (see ppu_initialize)
+static u64 ppu_get_precompile_settings_hash()
+{
+	std::string data = fmt::format("%s|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d", c_ppu_obj_version,
+		g_cfg.core.use_accurate_dfma.get(), g_cfg.core.ppu_fix_vnan.get(), g_cfg.core.ppu_llvm_nj_fixup.get(), g_cfg.core.accurate_cache_line_stores.get(),
+		g_cfg.core.ppu_128_reservations_loop_max_length.get(), g_cfg.core.ppu_llvm_greedy_mode.get(), g_cfg.core.ppu_set_sat_bit.get(),
+		g_cfg.core.ppu_set_fpcc.get(), g_cfg.core.ppu_set_vnan.get(), g_cfg.core.ppu_use_nj_bit.get());
+
+#ifdef LLVM_AVAILABLE
+	data += '|';
+	data += jit_compiler::cpu(g_cfg.core.llvm_cpu);
+#endif
+
+	sha1_context ctx;
+	u8 output[20];
+
+	sha1_starts(&ctx);
+	sha1_update(&ctx, reinterpret_cast<const u8*>(data.data()), data.size());
+	sha1_finish(&ctx, output);
+	return read_from_ptr<le_t<u64>>(output);
+}
+
 extern void ppu_precompile(std::vector<std::string>& dir_queue, std::vector<ppu_module*>* loaded_modules)
 {
 	if (g_cfg.core.ppu_decoder != ppu_decoder_type::llvm)
@@ -3729,6 +4029,13 @@ extern void ppu_precompile(std::vector<std::string>& dir_queue, std::vector<ppu_
 	g_progr_ftotal += file_queue.size();
 	scoped_progress_dialog progr = "Compiling PPU modules...";
 
+	g_fxo->need<ppu_precompile_manifest>();
+
+	auto& manifest = g_fxo->get<ppu_precompile_manifest>();
+	manifest.load(ppu_get_precompile_settings_hash());
+
+	atomic_t<usz> skipped = 0;
+
 	atomic_t<usz> fnext = 0;
 
 	lf_queue<std::string> possible_exec_file_paths;
@@ -3751,6 +4058,18 @@ extern void ppu_precompile(std::vector<std::string>& dir_queue, std::vector<ppu_
 
 			auto& [path, offset] = file_queue[func_i];
 
+			const std::string file_path = path;
+
+			fs::stat_t file_stat{};
+
+			if (fs::get_stat(file_path, file_stat) && manifest.is_up_to_date(file_path, offset, file_stat))
+			{
+				// All objects of this file are already compiled
+				ppu_log.notice("Skipping unchanged file: %s (offset=0x%x)", file_path, offset);
+				skipped++;
+				continue;
+			}
+
 			ppu_log.notice("Trying to load: %s", path);
 
 			// Load MSELF, SPRX or SELF
@@ -3789,6 +4108,7 @@ extern void ppu_precompile(std::vector<std::string>& dir_queue, std::vector<ppu_
 					obj.clear(), src.close(); // Clear decrypted file and elf object memory
 					ppu_initialize(*prx);
 					ppu_finalize(*prx);
+					manifest.commit(*prx, true, file_path, offset, file_stat);
 					continue;
 				}
 
@@ -3825,6 +4145,7 @@ extern void ppu_precompile(std::vector<std::string>& dir_queue, std::vector<ppu_
 					}
 
 					ppu_finalize(*ovlm);
+					manifest.commit(*ovlm, false, file_path, offset, file_stat);
 					break;
 				}
 
@@ -3843,6 +4164,13 @@ extern void ppu_precompile(std::vector<std::string>& dir_queue, std::vector<ppu_
 	// Join every thread
 	workers.join();
 
+	if (skipped)
+	{
+		ppu_log.success("Skipped %u unchanged files out of %u (precompilation manifest)", +skipped, file_queue.size());
+	}
+
+	manifest.save();
+
 	named_thread exec_worker("PPU Exec Worker", [&]
 	{
 		if (!possible_exec_file_paths)
@@ -4226,6 +4554,9 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 	// Info to load to main JIT instance (true - compiled)
 	std::vector<std::pair<std::string, bool>> link_workload;
 
+	// Module parts of cached objects, kept to recompile objects found damaged while linking
+	std::unordered_map<usz, ppu_module> cached_parts;
+
 	// Sync variable to acquire workloads
 	atomic_t<u32> work_cv = 0;
 
@@ -4348,7 +4679,7 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 
 			if (entry.blocks.empty())
 			{
-				entry.blocks.emplace(func.addr, func.size);
+				entry.blocks.emplace_back(func.addr, func.size);
 			}
 
 			bsize += func.size;
@@ -4502,7 +4833,7 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 				settings += ppu_settings::accurate_nj_mode, settings -= ppu_settings::fixup_nj_denormals, fmt::throw_exception("NJ Not implemented");
 
 			// Write version, hash, CPU, settings
-			fmt::append(obj_name, "v6-kusa-%s-%s-%s.obj", fmt::base57(output, 16), fmt::base57(settings), jit_compiler::cpu(g_cfg.core.llvm_cpu));
+			fmt::append(obj_name, "%s-%s-%s-%s.obj", c_ppu_obj_version, fmt::base57(output, 16), fmt::base57(settings), jit_compiler::cpu(g_cfg.core.llvm_cpu));
 		}
 
 		if (Emu.IsStopped())
@@ -4518,6 +4849,14 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 			link_workload.emplace_back(obj_name, false);
 		}
 
+		// Object files are fully checked while linking (in parallel), only when used in emulation
+		if (is_being_used_in_emulation && !check_only && (fs::is_file(cache_path + obj_name + ".gz") || fs::is_file(cache_path + obj_name)))
+		{
+			part.funcs.shrink_to_fit();
+			cached_parts.emplace(link_workload.size() - 1, std::move(part));
+			continue;
+		}
+
 		// Check object file
 		if (jit_compiler::check(cache_path + obj_name))
 		{
@@ -4557,8 +4896,13 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 		*progr = "Compiling PPU modules...";
 	}
 
+	// Object writing flags for auxiliary compilers
+	const u32 jit_flags = 0x1 | (g_cfg.core.ppu_llvm_compress_objects ? 0 : 0x4);
+
 	// Create worker threads for compilation (TODO: how many threads)
 	{
+		const auto compile_start = steady_clock::now();
+
 		u32 thread_count = rpcs3::utils::get_max_threads();
 
 		if (workload.size() < thread_count)
@@ -4603,7 +4947,7 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 				ppu_log.warning("LLVM: Compiling module %s%s", cache_path, obj_name);
 
 				// Use another JIT instance
-				jit_compiler jit2({}, g_cfg.core.llvm_cpu, 0x1);
+				jit_compiler jit2({}, g_cfg.core.llvm_cpu, jit_flags);
 				ppu_initialize2(jit2, part, cache_path, obj_name);
 
 				ppu_log.success("LLVM: Compiled module %s", obj_name);
@@ -4614,6 +4958,20 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 
 		g_watchdog_hold_ctr--;
 
+		if (!workload.empty())
+		{
+			ppu_log.notice("LLVM: Compiled %u modules in %.3fs (%u threads)", workload.size(), std::chrono::duration<double>(steady_clock::now() - compile_start).count(), thread_count);
+		}
+
+		if (!is_being_used_in_emulation && !Emu.IsStopped())
+		{
+			if (auto manifest = g_fxo->try_get<ppu_precompile_manifest>())
+			{
+				// Remember which objects this module consists of
+				manifest->set_objects(info, cache_path, link_workload);
+			}
+		}
+
 		if (!is_being_used_in_emulation || (cpu ? cpu->state.all_of(cpu_flag::exit) : Emu.IsStopped()))
 		{
 			return compiled_new;
@@ -4625,14 +4983,124 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 			*progr = "Linking PPU modules...";
 		}
 
-		for (const auto& [obj_name, is_compiled] : link_workload)
+		const auto link_start = steady_clock::now();
+
+		const u32 link_count = ::size32(link_workload);
+
+		// Objects are read and decompressed by the loaders and linked in order on this thread
+		const auto objects = std::make_unique<std::vector<u8>[]>(link_count);
+		const auto loaded = std::make_unique<atomic_t<u32>[]>(link_count);
+
+		// Number of linked objects, limits the amount of decompressed objects held in memory
+		atomic_t<u32> linked = 0;
+		atomic_t<u32> load_cv = 0;
+		atomic_t<u64> load_time = 0;
+
+		const u32 loader_count = std::clamp<u32>(utils::get_thread_count() / 2, 1, std::max<u32>(link_count, 1));
+		const u32 window = loader_count * 2;
+
+		named_thread_group loaders("PPU Loader ", loader_count, [&]()
+		{
+			for (u32 i = load_cv++; i < link_count; i = load_cv++)
+			{
+				for (u32 old = linked; i >= old + window; old = linked)
+				{
+					if (thread_ctrl::state() == thread_state::aborting)
+					{
+						return;
+					}
+
+					thread_ctrl::wait_on(linked, old);
+				}
+
+				if (thread_ctrl::state() == thread_state::aborting)
+				{
+					return;
+				}
+
+				const auto start = steady_clock::now();
+
+				objects[i] = jit_compiler::load_object(cache_path + link_workload[i].first);
+
+				load_time += std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - start).count();
+
+				loaded[i].release(1);
+				loaded[i].notify_one();
+			}
+		});
+
+		u64 wait_time = 0;
+
+		for (u32 i = 0; i < link_count; i++)
 		{
+			const auto& [obj_name, is_compiled] = link_workload[i];
+
 			if (cpu ? cpu->state.all_of(cpu_flag::exit) : Emu.IsStopped())
 			{
 				break;
 			}
 
-			jit->add(cache_path + obj_name);
+			if (!loaded[i])
+			{
+				const auto start = steady_clock::now();
+
+				while (!loaded[i])
+				{
+					loaded[i].wait(0, atomic_wait_timeout{1'000'000});
+
+					if (cpu ? cpu->state.all_of(cpu_flag::exit) : Emu.IsStopped())
+					{
+						break;
+					}
+				}
+
+				wait_time += std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - start).count();
+
+				if (!loaded[i])
+				{
+					break;
+				}
+			}
+
+			if (!jit->add(std::move(objects[i]), cache_path + obj_name))
+			{
+				// Damaged cached object (existence was only checked), compile it again on this thread
+				const auto found = cached_parts.find(i);
+
+				if (found == cached_parts.end())
+				{
+					fmt::throw_exception("Failed to link PPU module %s%s", cache_path, obj_name);
+				}
+
+				ppu_log.error("LLVM: Recompiling damaged module %s%s", cache_path, obj_name);
+
+				fs::remove_file(cache_path + obj_name + ".gz");
+				fs::remove_file(cache_path + obj_name);
+
+				{
+					std::lock_guard jlock(g_fxo->get<jit_core_allocator>().sem);
+
+					jit_compiler jit2({}, g_cfg.core.llvm_cpu, jit_flags);
+					ppu_initialize2(jit2, found->second, cache_path, obj_name);
+				}
+
+				compiled_new = true;
+
+				if (!jit->add(jit_compiler::load_object(cache_path + obj_name), cache_path + obj_name))
+				{
+					// The object couldn't be written back (e.g. disk full), compile it directly into the linked modules without caching it
+					ppu_log.error("LLVM: Failed to reload module %s%s, compiling it in memory", cache_path, obj_name);
+
+					fs::remove_file(cache_path + obj_name + ".gz");
+					fs::remove_file(cache_path + obj_name);
+
+					std::lock_guard jlock(g_fxo->get<jit_core_allocator>().sem);
+					ppu_initialize2(*jit, found->second, cache_path, obj_name, false);
+				}
+			}
+
+			linked.release(i + 1);
+			linked.notify_all();
 
 			if (!is_compiled)
 			{
@@ -4640,6 +5108,13 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 				g_progr_pdone++;
 			}
 		}
+
+		// Loaders waiting for the window exit when the thread group is destroyed (if linking was interrupted)
+		if (link_count)
+		{
+			ppu_log.notice("LLVM: Linked %u modules in %.3fs (read and decompression: %.3fs on %u threads, linker waited %.3fs)", link_count,
+				std::chrono::duration<double>(steady_clock::now() - link_start).count(), load_time / 1e6, loader_count, wait_time / 1e6);
+		}
 	}
 
 	if (!is_being_used_in_emulation || (cpu ? cpu->state.all_of(cpu_flag::exit) : Emu.IsStopped()))
@@ -4653,8 +5128,12 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 #endif
 	if (jit && !jit_mod.init)
 	{
+		const auto fin_start = steady_clock::now();
+
 		jit->fin();
 
+		ppu_log.notice("LLVM: Finalized PPU modules in %.3fs", std::chrono::duration<double>(steady_clock::now() - fin_start).count());
+
 		// Get and install function addresses
 		for (const auto& func : info.funcs)
 		{
@@ -4698,7 +5177,7 @@ bool ppu_initialize(const ppu_module& info, bool check_only)
 #endif
 }
 
-static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name)
+static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name, bool use_cache)
 {
 #ifdef LLVM_AVAILABLE
 	using namespace llvm;
@@ -4712,6 +5191,7 @@ static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, co
 
 	// Initialize translator
 	PPUTranslator translator(jit.get_context(), _module.get(), module_part, jit.get_engine());
+	translator.init_debug_info("ppu");
 
 	// Define some types
 	const auto _func = FunctionType::get(translator.get_type<void>(), {
@@ -4797,6 +5277,8 @@ static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, co
 		//mpm.add(createDeadInstEliminationPass());
 		//mpm.run(*module);
 
+		translator.finalize_debug_info();
+
 		std::string result;
 		raw_string_ostream out(result);
 
@@ -4818,6 +5300,13 @@ static void ppu_initialize2(jit_compiler& jit, const ppu_module& module_part, co
 		ppu_log.notice("LLVM: %zu functions generated", _module->getFunctionList().size());
 	}
 
+	if (!use_cache)
+	{
+		// Compile module in memory only
+		jit.add(std::move(_module));
+		return;
+	}
+
 	// Load or compile module
 	jit.add(std::move(_module), cache_path);
 #endif // LLVM_AVAILABLE
@@ -149,6 +149,8 @@ Function* PPUTranslator::Translate(const ppu_function& info)
 	m_addr = info.addr - base;
 	m_attr = info.attr;
 
+	set_guest_address(info.addr);
+
 	// Don't emit check in small blocks without terminator
 	bool need_check = info.size >= 16;
 
@@ -250,6 +252,8 @@ Function* PPUTranslator::Translate(const ppu_function& info)
 			// Reset MMIO hint
 			m_may_be_mmio = true;
 
+			set_guest_address(::narrow<u32>(m_addr + base));
+
 			const u32 op = *ensure(m_info.get_ptr<u32>(::narrow<u32>(m_addr + base)));
 
 			(this->*(s_ppu_decoder.decode(op)))({op});
@@ -271,6 +275,7 @@ Function* PPUTranslator::Translate(const ppu_function& info)
 	}
 
 	replace_intrinsics(*m_function);
+	finalize_debug_info(*m_function);
 	return m_function;
 }
 
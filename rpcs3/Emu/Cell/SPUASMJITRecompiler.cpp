@@ -771,6 +771,11 @@ spu_function_t spu_recompiler::compile(spu_program&& _func)
 		m_pos = -1;
 	}
 
+	// Host code offset -> LS address (for perf jitdump)
+	std::vector<jit_line_info> lines;
+
+	const bool record_lines = jit_dump_enabled();
+
 	for (u32 i = 0; i < func.data.size(); i++)
 	{
 		const u32 pos = start + i * 4;
@@ -805,6 +810,11 @@ spu_function_t spu_recompiler::compile(spu_program&& _func)
 			c->bind(found->second);
 		}
 
+		if (record_lines)
+		{
+			lines.push_back({::narrow<u32>(c->offset()), pos});
+		}
+
 		if (g_cfg.core.spu_debug)
 		{
 			// Write the instruction address inside the ASMJIT log
@@ -900,7 +910,7 @@ spu_function_t spu_recompiler::compile(spu_program&& _func)
 	}
 	else
 	{
-		jit_announce(fn, code.codeSize(), fmt::format("spu-b-%s", fmt::base57(be_t<u64>(m_hash_start))));
+		jit_announce(fn, code.codeSize(), fmt::format("spu-b-%s", fmt::base57(be_t<u64>(m_hash_start))), "spu", lines);
 	}
 
 	// Install compiled function pointer
@@ -6,10 +6,12 @@
 #include "Emu/system_progress.hpp"
 #include "Emu/system_utils.hpp"
 #include "Emu/cache_utils.hpp"
+#include "Emu/perf_meter.hpp"
 #include "Emu/IdManager.h"
 #include "Crypto/sha1.h"
 #include "Utilities/StrUtil.h"
 #include "Utilities/JIT.h"
+#include "Utilities/record_archive.h"
 #include "util/init_mutex.hpp"
 #include "util/shared_ptr.hpp"
 
@@ -21,9 +23,11 @@
 #include <optional>
 #include <unordered_set>
 
+#include "util/asm.hpp"
 #include "util/v128.hpp"
 #include "util/simd.hpp"
 #include "util/sysinfo.hpp"
+#include "util/cpu_stats.hpp"
 
 const extern spu_decoder<spu_itype> g_spu_itype;
 const extern spu_decoder<spu_iname> g_spu_iname;
@@ -504,13 +508,69 @@ DECLARE(spu_runtime::g_interpreter_table) = {};
 
 DECLARE(spu_runtime::g_interpreter) = nullptr;
 
+namespace
+{
+	// SPU cache file (v2 format), records are keyed by the program hash and typed by the entry point
+	constexpr record_archive::format c_spu_cache_format
+	{
+		.magic = "RPCS3SPU"_u64,
+		.version = 2,
+		.record_tag = "SPUR"_u32,
+		.index_tag = "SPUI"_u32,
+		.max_record_size = SPU_LS_SIZE,
+	};
+}
+
+struct spu_cache::state_t
+{
+	record_archive archive{"SPU Cache", c_spu_cache_format};
+};
+
+static u64 get_spu_program_hash(const std::vector<u32>& data)
+{
+	sha1_context ctx;
+	u8 output[20];
+
+	sha1_starts(&ctx);
+	sha1_update(&ctx, reinterpret_cast<const u8*>(data.data()), data.size() * 4);
+	sha1_finish(&ctx, output);
+	return read_from_ptr<be_t<u64>>(output);
+}
+
+spu_cache::spu_cache()
+	: m_state(std::make_unique<state_t>())
+{
+}
+
 spu_cache::spu_cache(const std::string& loc)
-	: m_file(loc, fs::read + fs::write + fs::create + fs::append)
+	: m_state(std::make_unique<state_t>())
+{
+	m_state->archive.open(loc);
+}
+
+spu_cache::spu_cache(spu_cache&& other) noexcept
+	: m_state(std::move(other.m_state))
+	, collect_funcs_to_precompile(other.collect_funcs_to_precompile)
+	, precompile_funcs(std::move(other.precompile_funcs))
 {
 }
 
+spu_cache& spu_cache::operator=(spu_cache&& other) noexcept
+{
+	if (this != &other)
+	{
+		seal();
+		m_state = std::move(other.m_state);
+		collect_funcs_to_precompile = other.collect_funcs_to_precompile;
+		precompile_funcs = std::move(other.precompile_funcs);
+	}
+
+	return *this;
+}
+
 spu_cache::~spu_cache()
 {
+	seal();
 }
 
 extern void utilize_spu_data_segment(u32 vaddr, const void* ls_data_vaddr, u32 size)
@@ -577,93 +637,215 @@ static u16 calculate_crc16(const uchar* data, usz length)
 	return crc;
 }
 
-std::deque<spu_program> spu_cache::get()
+spu_cache::operator bool() const
 {
-	std::deque<spu_program> result;
+	return m_state && !!m_state->archive;
+}
+
+usz spu_cache::load()
+{
+	return m_state ? m_state->archive.loaded_count() : 0;
+}
+
+usz spu_cache::size() const
+{
+	return m_state ? m_state->archive.loaded_count() : 0;
+}
+
+spu_program spu_cache::get(usz index, u64* hash) const
+{
+	spu_program res{};
 
-	if (!m_file)
+	if (!m_state || index >= m_state->archive.loaded_count())
 	{
-		return result;
+		return res;
 	}
 
-	m_file.seek(0);
+	auto& archive = m_state->archive;
 
-	// TODO: signal truncated or otherwise broken file
-	while (true)
-	{
-		struct block_info_t
-		{
-			be_t<u16> crc;
-			be_t<u16> size;
-			be_t<u32> addr;
-		} block_info{};
+	// Newest programs first
+	index = archive.loaded_count() - 1 - index;
 
-		if (!m_file.read(block_info))
-		{
-			break;
-		}
+	const auto info = archive.get_info(index);
 
-		const u32 crc = block_info.crc;
-		const u32 size = block_info.size;
-		const u32 addr = block_info.addr;
+	if (info.size % 4 || utils::add_saturate<u32>(info.type, info.size) > SPU_LS_SIZE)
+	{
+		spu_log.error("SPU Cache: Invalid record at 0x%x (addr=0x%05x, size=0x%x)", info.pos, info.type, info.size);
+		return res;
+	}
 
-		if (utils::add_saturate<u32>(addr, size * 4) > SPU_LS_SIZE)
-		{
-			break;
-		}
+	const auto data = archive.get(index);
 
-		std::vector<u32> func;
+	if (data.empty())
+	{
+		return res;
+	}
 
-		if (!m_file.read(func, size))
-		{
-			break;
-		}
+	res.entry_point = info.type;
+	res.lower_bound = info.type;
+	res.data.resize(data.size() / 4);
+	std::memcpy(res.data.data(), data.data(), data.size());
 
-		if (!size || !func[0])
-		{
-			// Skip old format Giga entries
-			continue;
-		}
+	if (hash)
+	{
+		*hash = info.key;
+	}
 
-		// CRC check is optional to be compatible with old format
-		if (crc && std::max<u32>(calculate_crc16(reinterpret_cast<const uchar*>(func.data()), size * 4), 1) != crc)
-		{
-			// Invalid, but continue anyway
-			continue;
-		}
+	return res;
+}
 
-		spu_program res;
-		res.entry_point = addr;
-		res.lower_bound = addr;
-		res.data = std::move(func);
-		result.emplace_front(std::move(res));
+void spu_cache::unmap()
+{
+	if (m_state)
+	{
+		m_state->archive.unmap();
 	}
+}
 
-	return result;
+bool spu_cache::contains(u64 hash, u32 addr) const
+{
+	return m_state && m_state->archive.contains(addr, hash);
 }
 
 void spu_cache::add(const spu_program& func)
 {
-	if (!m_file)
+	if (!*this || func.data.empty())
 	{
 		return;
 	}
 
-	be_t<u32> size = ::size32(func.data);
-	be_t<u32> addr = func.entry_point;
+	m_state->archive.append(func.entry_point, get_spu_program_hash(func.data), func.data.data(), func.data.size() * 4);
+}
 
-	// Add CRC (forced non-zero)
-	size |= std::max<u32>(calculate_crc16(reinterpret_cast<const uchar*>(func.data.data()), size * 4), 1) << 16;
+bool spu_cache::seal()
+{
+	return m_state && m_state->archive.seal();
+}
 
-	const fs::iovec_clone gather[3]
+bool spu_cache::compact(const std::string& src, const std::string& dst)
+{
+	if (src == dst)
 	{
-		{&size, sizeof(size)},
-		{&addr, sizeof(addr)},
-		{func.data.data(), func.data.size() * 4}
-	};
+		// The result is written next to dst and renamed over it, compacting in place is not supported
+		spu_log.error("SPU Cache: Cannot compact %s into itself", src);
+		return false;
+	}
+
+	std::vector<spu_program> programs;
+
+	if (fs::file in{src}; in && in.size() >= sizeof(u64) && in.read<u64>() == c_spu_cache_format.magic)
+	{
+		in.close();
+
+		spu_cache cache(src);
+		const usz count = cache.load();
+
+		// Restore file order
+		for (usz i = count; i--;)
+		{
+			if (spu_program func = cache.get(i); !func.data.empty())
+			{
+				programs.emplace_back(std::move(func));
+			}
+		}
+	}
+	else if (in)
+	{
+		// Legacy v1 format: sequence of {crc, size, addr, data}
+		in.seek(0);
+
+		while (true)
+		{
+			struct block_info_t
+			{
+				be_t<u16> crc;
+				be_t<u16> size;
+				be_t<u32> addr;
+			} block_info{};
+
+			if (!in.read(block_info))
+			{
+				break;
+			}
+
+			const u32 crc = block_info.crc;
+			const u32 size = block_info.size;
+			const u32 addr = block_info.addr;
+
+			if (utils::add_saturate<u32>(addr, size * 4) > SPU_LS_SIZE)
+			{
+				break;
+			}
 
-	// Append data
-	m_file.write_gather(gather, 3);
+			std::vector<u32> func;
+
+			if (!in.read(func, size))
+			{
+				break;
+			}
+
+			if (!size || !func[0])
+			{
+				// Skip old format Giga entries
+				continue;
+			}
+
+			// CRC check is optional to be compatible with old format
+			if (crc && std::max<u32>(calculate_crc16(reinterpret_cast<const uchar*>(func.data()), size * 4), 1) != crc)
+			{
+				continue;
+			}
+
+			spu_program res;
+			res.entry_point = addr;
+			res.lower_bound = addr;
+			res.data = std::move(func);
+			programs.emplace_back(std::move(res));
+		}
+	}
+	else
+	{
+		spu_log.error("SPU Cache: Failed to open %s (%s)", src, fs::g_tls_error);
+		return false;
+	}
+
+	const std::string tmp = dst + ".tmp";
+	fs::remove_file(tmp);
+
+	usz written = 0;
+	{
+		spu_cache out(tmp);
+
+		if (!out)
+		{
+			spu_log.error("SPU Cache: Failed to create %s (%s)", tmp, fs::g_tls_error);
+			return false;
+		}
+
+		for (const spu_program& func : programs)
+		{
+			out.add(func);
+		}
+
+		written = out.m_state->archive.size();
+
+		if (!out.seal())
+		{
+			out.m_state->archive.close();
+			fs::remove_file(tmp);
+			return false;
+		}
+	}
+
+	if (!fs::rename(tmp, dst, true))
+	{
+		spu_log.error("SPU Cache: Failed to rename %s to %s (%s)", tmp, dst, fs::g_tls_error);
+		fs::remove_file(tmp);
+		return false;
+	}
+
+	spu_log.success("SPU Cache: Compacted %s to %s (%u programs, %u duplicates removed)", src, dst, written, programs.size() - written);
+	return true;
 }
 
 void spu_cache::initialize(bool build_existing_cache)
@@ -686,7 +868,17 @@ void spu_cache::initialize(bool build_existing_cache)
 	}
 
 	// SPU cache file (version + block size type)
-	const std::string loc = ppu_cache + "spu-" + fmt::to_lower(g_cfg.core.spu_block_size.to_string()) + "-v1-tane.dat";
+	const std::string loc = ppu_cache + "spu-" + fmt::to_lower(g_cfg.core.spu_block_size.to_string()) + "-v2-tane.dat";
+	const std::string loc_v1 = ppu_cache + "spu-" + fmt::to_lower(g_cfg.core.spu_block_size.to_string()) + "-v1-tane.dat";
+
+	if (!fs::is_file(loc) && fs::is_file(loc_v1))
+	{
+		// Migrate legacy cache (removing duplicates)
+		if (spu_cache::compact(loc_v1, loc))
+		{
+			fs::remove_file(loc_v1);
+		}
+	}
 
 	spu_cache cache(loc);
 
@@ -696,8 +888,18 @@ void spu_cache::initialize(bool build_existing_cache)
 		return;
 	}
 
-	// Read cache
-	auto func_list = cache.get();
+	// Map cache file, records are decoded by the workers
+	const usz func_count = cache.load();
+
+	if (!cache)
+	{
+		spu_log.error("Failed to load SPU cache at: %s", loc);
+		return;
+	}
+
+	// Write index for records which were not covered by it
+	cache.seal();
+
 	atomic_t<usz> fnext{};
 	atomic_t<u8> fail_flag{0};
 
@@ -711,11 +913,12 @@ void spu_cache::initialize(bool build_existing_cache)
 		total_precompile += sec.funcs.size();
 	}
 
-	const bool spu_precompilation_enabled = func_list.empty() && g_cfg.core.spu_cache && g_cfg.core.llvm_precompilation;
+	const bool spu_precompilation_enabled = !func_count && g_cfg.core.spu_cache && g_cfg.core.llvm_precompilation;
 
 	if (spu_precompilation_enabled)
 	{
 		// What compiles in this case goes straight to disk
+		cache.unmap();
 		g_fxo->get<spu_cache>() = std::move(cache);
 	}
 	else if (!build_existing_cache)
@@ -760,7 +963,7 @@ void spu_cache::initialize(bool build_existing_cache)
 
 	if (g_cfg.core.spu_decoder == spu_decoder_type::asmjit || g_cfg.core.spu_decoder == spu_decoder_type::llvm)
 	{
-		const usz add_count = func_list.size() + total_precompile;
+		const usz add_count = func_count + total_precompile;
 
 		if (add_count)
 		{
@@ -814,29 +1017,27 @@ void spu_cache::initialize(bool build_existing_cache)
 		const bool is_first_thread = func_i == 0;
 
 		// Build functions
-		for (; func_i < func_list.size(); func_i = fnext++, (showing_progress ? g_progr_pdone : pending_progress) += build_existing_cache ? 1 : 0)
+		for (; func_i < func_count; func_i = fnext++, (showing_progress ? g_progr_pdone : pending_progress) += build_existing_cache ? 1 : 0)
 		{
-			const spu_program& func = std::as_const(func_list)[func_i];
-
 			if (Emu.IsStopped() || fail_flag)
 			{
 				continue;
 			}
 
+			// Claim the record directly from the mapped file (hash is stored along with it)
+			u64 hash = 0;
+			const spu_program func = cache.get(func_i, &hash);
+
+			if (func.data.empty())
+			{
+				continue;
+			}
+
 			// Get data start
 			const u32 start = func.lower_bound;
 			const u32 size0 = ::size32(func.data);
 
-			be_t<u64> hash_start;
-			{
-				sha1_context ctx;
-				u8 output[20];
-
-				sha1_starts(&ctx);
-				sha1_update(&ctx, reinterpret_cast<const u8*>(func.data.data()), func.data.size() * 4);
-				sha1_finish(&ctx, output);
-				std::memcpy(&hash_start, output, sizeof(hash_start));
-			}
+			const be_t<u64> hash_start = hash;
 
 			// Check hash against allowed bounds
 			const bool inverse_bounds = g_cfg.core.spu_llvm_lower_bound > g_cfg.core.spu_llvm_upper_bound;
@@ -1100,12 +1301,23 @@ void spu_cache::initialize(bool build_existing_cache)
 		return;
 	}
 
-	if ((g_cfg.core.spu_decoder == spu_decoder_type::asmjit || g_cfg.core.spu_decoder == spu_decoder_type::llvm) && !func_list.empty())
+	if ((g_cfg.core.spu_decoder == spu_decoder_type::asmjit || g_cfg.core.spu_decoder == spu_decoder_type::llvm) && func_count)
 	{
-		spu_log.success("SPU Runtime: Built %u functions.", func_list.size());
+		spu_log.success("SPU Runtime: Built %u functions.", func_count);
 
 		if (g_cfg.core.spu_debug)
 		{
+			std::vector<spu_program> func_list;
+			func_list.reserve(func_count);
+
+			for (usz i = 0; i < func_count; i++)
+			{
+				if (spu_program func = cache.get(i); !func.data.empty())
+				{
+					func_list.emplace_back(std::move(func));
+				}
+			}
+
 			std::string dump;
 			dump.reserve(10'000'000);
 
@@ -1210,6 +1422,7 @@ void spu_cache::initialize(bool build_existing_cache)
 	// Initialize global cache instance
 	if (g_cfg.core.spu_cache && cache)
 	{
+		cache.unmap();
 		g_fxo->get<spu_cache>() = std::move(cache);
 	}
 }
@@ -1301,6 +1514,9 @@ spu_item* spu_runtime::add_empty(spu_program&& data)
 
 spu_function_t spu_runtime::rebuild_ubertrampoline(u32 id_inst)
 {
+	// Trampoline pointers are compared and retired below, they must not be recycled meanwhile
+	jit_runtime::reclaim_guard reclaim_guard;
+
 	// Prepare sorted list
 	static thread_local std::vector<std::pair<std::basic_string_view<u32>, spu_function_t>> m_flat_list;
 
@@ -1357,7 +1573,7 @@ spu_function_t spu_runtime::rebuild_ubertrampoline(u32 id_inst)
 	{
 #if defined(ARCH_ARM64)
 		// Allocate some writable executable memory
-		u8* const wxptr = jit_runtime::alloc(size0 * 128 + 16, 16);
+		u8* const wxptr = jit_runtime::alloc_reclaimable(size0 * 128 + 16, 16);
 
 		if (!wxptr)
 		{
@@ -1439,7 +1655,7 @@ spu_function_t spu_runtime::rebuild_ubertrampoline(u32 id_inst)
 		};
 #elif defined(ARCH_X64)
 		// Allocate some writable executable memory
-		u8* const wxptr = jit_runtime::alloc(size0 * 22 + 14, 16);
+		u8* const wxptr = jit_runtime::alloc_reclaimable(size0 * 22 + 14, 16);
 
 		if (!wxptr)
 		{
@@ -1849,6 +2065,8 @@ spu_function_t spu_runtime::rebuild_ubertrampoline(u32 id_inst)
 
 	if (auto _old = stuff_it->trampoline.compare_and_swap(nullptr, result))
 	{
+		// Never published (no-op if result is a compiled function)
+		jit_runtime::retire(reinterpret_cast<const void*>(result));
 		return _old;
 	}
 
@@ -1857,23 +2075,25 @@ spu_function_t spu_runtime::rebuild_ubertrampoline(u32 id_inst)
 
 	auto _old = insert_to.load();
 
+	spu_item* old_owner = nullptr;
+
 	do
 	{
+		old_owner = nullptr;
+
 		// Make sure we are replacing an older ubertrampoline but not newer one
 		if (_old != tr_dispatch)
 		{
-			bool ok = false;
-
 			for (auto it = stuff_it; it != stuff_end; ++it)
 			{
 				if (it->trampoline == _old)
 				{
-					ok = true;
+					old_owner = &*it;
 					break;
 				}
 			}
 
-			if (!ok)
+			if (!old_owner)
 			{
 				return result;
 			}
@@ -1881,6 +2101,13 @@ spu_function_t spu_runtime::rebuild_ubertrampoline(u32 id_inst)
 	}
 	while (!insert_to.compare_exchange(_old, result));
 
+	if (old_owner && old_owner != &*stuff_it)
+	{
+		// Previous ubertrampoline is no longer reachable from the dispatcher, forget it so its address can be reused
+		old_owner->trampoline.compare_and_swap(_old, nullptr);
+		jit_runtime::retire(reinterpret_cast<const void*>(_old));
+	}
+
 	return result;
 }
 
@@ -2086,6 +2313,17 @@ void spu_recompiler_base::dispatch(spu_thread& spu, void*, u8* rip)
 		return;
 	}
 
+	if (jit_runtime::needs_collect()) [[unlikely]]
+	{
+		perf_meter<"SPUJITGC"_u64> perf0;
+
+		// Retired ubertrampolines can only be in use by threads which haven't reached check_state yet
+		cpu_thread::suspend_all(&spu, {}, []
+		{
+			jit_runtime::collect();
+		});
+	}
+
 	// Diagnostic
 	if (g_cfg.core.spu_block_size == spu_block_size_type::giga)
 	{
@@ -4393,100 +4631,74 @@ void spu_recompiler_base::dump(const spu_program& result, std::string& out)
 	out += '\n';
 }
 
-struct spu_llvm_worker
+// SPU LLVM compilation request
+struct spu_llvm_task
 {
-	lf_queue<std::pair<u64, const spu_program*>> registered;
+	u64 hash = 0;
+	spu_item* item = nullptr;
 
-	void operator()()
-	{
-		// SPU LLVM Recompiler instance
-		const auto compiler = spu_recompiler_base::make_llvm_recompiler();
-		compiler->init();
+	// Registration time
+	u64 stamp = 0;
+};
 
-		// Fake LS
-		std::vector<be_t<u32>> ls(0x10000);
+struct spu_llvm_worker
+{
+	// Local queue filled by the dispatcher in priority order (idle workers steal from the back)
+	std::deque<spu_llvm_task> queue;
+	shared_mutex mutex;
 
-		for (auto slice = registered.pop_all();; [&]
-		{
-			if (slice)
-			{
-				slice.pop_front();
-			}
+	// Number of queued and in-progress tasks
+	atomic_t<u32> load = 0;
 
-			if (slice || thread_ctrl::state() == thread_state::aborting)
-			{
-				return;
-			}
+	// Incremented when a task is pushed
+	atomic_t<u32> signal = 0;
 
-			thread_ctrl::wait_on(utils::bless<atomic_t<u32>>(&registered)[1], 0);
-			slice = registered.pop_all();
-		}())
+	void push(const spu_llvm_task& task)
+	{
 		{
-			auto* prog = slice.get();
-
-			if (thread_ctrl::state() == thread_state::aborting)
-			{
-				break;
-			}
-
-			if (!prog)
-			{
-				continue;
-			}
-
-			if (!prog->second)
-			{
-				break;
-			}
+			// Count the task before it can be popped, so that load never underflows
+			std::lock_guard lock(mutex);
+			queue.push_back(task);
+			load++;
+		}
 
-			const auto& func = *prog->second;
+		signal++;
+		signal.notify_one();
+	}
 
-			// Get data start
-			const u32 start = func.lower_bound;
-			const u32 size0 = ::size32(func.data);
+	bool pop(spu_llvm_task& task)
+	{
+		std::lock_guard lock(mutex);
 
-			// Initialize LS with function data only
-			for (u32 i = 0, pos = start; i < size0; i++, pos += 4)
-			{
-				ls[pos / 4] = std::bit_cast<be_t<u32>>(func.data[i]);
-			}
+		if (queue.empty())
+		{
+			return false;
+		}
 
-			// Call analyser
-			spu_program func2 = compiler->analyse(ls.data(), func.entry_point);
+		task = queue.front();
+		queue.pop_front();
+		return true;
+	}
 
-			if (func2 != func)
-			{
-				spu_log.error("[0x%05x] SPU Analyser failed, %u vs %u", func2.entry_point, func2.data.size(), size0);
-			}
-			else if (const auto target = compiler->compile(std::move(func2)))
-			{
-				// Redirect old function (TODO: patch in multiple places)
-				const s64 rel = reinterpret_cast<u64>(target) - prog->first - 5;
+	bool steal(spu_llvm_worker& thief, spu_llvm_task& task)
+	{
+		std::lock_guard lock(mutex);
 
-				union
-				{
-					u8 bytes[8];
-					u64 result;
-				};
+		if (queue.empty())
+		{
+			return false;
+		}
 
-				bytes[0] = 0xe9; // jmp rel32
-				std::memcpy(bytes + 1, &rel, 4);
-				bytes[5] = 0x90;
-				bytes[6] = 0x90;
-				bytes[7] = 0x90;
+		task = queue.back();
+		queue.pop_back();
 
-				atomic_storage<u64>::release(*reinterpret_cast<u64*>(prog->first), result);
-			}
-			else
-			{
-				spu_log.fatal("[0x%05x] Compilation failed.", func.entry_point);
-				return;
-			}
-
-			// Clear fake LS
-			std::memset(ls.data() + start / 4, 0, 4 * (size0 - 1));
-		}
+		// Move the task between workers without a window where it's not counted
+		thief.load++;
+		load--;
+		return true;
 	}
+
+	void operator()();
 };
 
 // SPU LLVM recompiler thread context
@@ -4496,12 +4708,72 @@ struct spu_llvm
 	lf_queue<std::pair<const u64, spu_item*>> registered;
 	atomic_ptr<named_thread_group<spu_llvm_worker>> m_workers;
 
+	// Number of workers allowed to take new tasks
+	atomic_t<u32> m_active_workers = 1;
+
+	// Incremented when a worker finishes a task
+	atomic_t<u32> m_done = 0;
+
+	// Statistics
+	atomic_t<u64> m_compiled = 0;
+	atomic_t<u64> m_stolen = 0;
+	atomic_t<u64> m_latency_sum = 0; // From registration to installation (us)
+	atomic_t<u64> m_latency_max = 0;
+	atomic_t<u64> m_compile_time_sum = 0; // Compilation only (us)
+	atomic_t<u32> m_queue_depth = 0;
+	atomic_t<u32> m_queue_depth_max = 0;
+
 	spu_llvm()
 	{
 		// Dependency
 		g_fxo->init<spu_cache>();
 	}
 
+	// Take a task queued on another active worker
+	bool steal(spu_llvm_worker* thief, spu_llvm_task& task)
+	{
+		const auto workers = m_workers.load();
+
+		if (!workers)
+		{
+			return false;
+		}
+
+		const u32 active = std::min<u32>(m_active_workers, workers->size());
+
+		// Prefer the most loaded victim
+		spu_llvm_worker* victim = nullptr;
+		bool is_active = false;
+
+		for (u32 i = 0; i < workers->size(); i++)
+		{
+			spu_llvm_worker* w = workers->begin() + i;
+
+			if (w == thief)
+			{
+				// Workers above the active limit don't take new tasks
+				is_active = i < active;
+			}
+			else if (w->load > 1 && (!victim || w->load > victim->load))
+			{
+				victim = w;
+			}
+		}
+
+		if (!is_active)
+		{
+			return false;
+		}
+
+		if (victim && victim->steal(*thief, task))
+		{
+			m_stolen++;
+			return true;
+		}
+
+		return false;
+	}
+
 	void operator()()
 	{
 		if (g_cfg.core.spu_decoder != spu_decoder_type::llvm)
@@ -4509,12 +4781,29 @@ struct spu_llvm
 			return;
 		}
 
-		// To compile (hash -> item)
-		std::unordered_multimap<u64, spu_item*, value_hash<u64>> enqueued;
+		// Pending tasks (binary heap ordered by samples, then by registration order)
+		struct entry
+		{
+			u64 samples;
+			u64 seq;
+			spu_llvm_task task;
+		};
+
+		std::vector<entry> enqueued;
+
+		const auto entry_less = [](const entry& a, const entry& b)
+		{
+			return a.samples != b.samples ? a.samples < b.samples : a.seq > b.seq;
+		};
+
+		u64 seq = 0;
 
 		// Mini-profiler (hash -> number of occurrences)
 		std::unordered_map<u64, atomic_t<u64>, value_hash<u64>> samples;
 
+		// Incremented after each profiler pass
+		atomic_t<u64> prof_epoch = 0;
+
 		// For synchronization with profiler thread
 		stx::init_mutex prof_mutex;
 
@@ -4548,6 +4837,8 @@ struct spu_llvm
 							}
 						}
 					});
+
+					prof_epoch++;
 				}
 
 				// Sleep for a short period if enabled
@@ -4555,24 +4846,35 @@ struct spu_llvm
 			}
 		});
 
-		u32 worker_count = 1;
+		const u32 hc = utils::get_thread_count();
 
-		if (uint hc = utils::get_thread_count(); hc >= 12)
-		{
-			worker_count = hc - 10;
-		}
+		// Workers which are always allowed to run
+		const u32 base_count = hc >= 12 ? hc - 10 : 1;
 
-		u32 worker_index = 0;
+		// More workers are activated while host cores are idle (each one owns an LLVM context, so their number is limited)
+		const u32 worker_count = std::max<u32>(base_count, std::min<u32>(hc >= 4 ? hc - 2 : 1, base_count + c_max_extra_workers));
+
+		m_active_workers = base_count;
 
 		m_workers = make_single<named_thread_group<spu_llvm_worker>>("SPUW.", worker_count);
 		auto workers_ptr = m_workers.load();
 		auto& workers = *workers_ptr;
 
+		utils::cpu_stats cpu_stats;
+		cpu_stats.init_cpu_query();
+		std::vector<double> core_usage;
+
+		u64 last_epoch = 0;
+		u64 last_adapt = get_system_time();
+
 		while (thread_ctrl::state() != thread_state::aborting)
 		{
+			const u32 done = m_done;
+
 			for (const auto& pair : registered.pop_all())
 			{
-				enqueued.emplace(pair);
+				enqueued.emplace_back(entry{0, seq++, spu_llvm_task{pair.first, pair.second, get_system_time()}});
+				std::push_heap(enqueued.begin(), enqueued.end(), entry_less);
 
 				// Interrupt and kick profiler thread
 				const auto lock = prof_mutex.init_always([&]{});
@@ -4581,40 +4883,91 @@ struct spu_llvm
 				samples.emplace(pair.first, 0);
 			}
 
-			if (enqueued.empty())
+			if (const u64 epoch = prof_epoch; epoch != last_epoch && !enqueued.empty())
 			{
-				// Interrupt profiler thread and put it to sleep
-				static_cast<void>(prof_mutex.reset());
-				thread_ctrl::wait_on(utils::bless<atomic_t<u32>>(&registered)[1], 0);
-				continue;
+				// Refresh priorities (sample counts only grow, so the heap is rebuilt once per profiler pass)
+				last_epoch = epoch;
+
+				for (auto& e : enqueued)
+				{
+					e.samples = ::at32(std::as_const(samples), e.task.hash);
+				}
+
+				std::make_heap(enqueued.begin(), enqueued.end(), entry_less);
+			}
+
+			if (const u64 now = get_system_time(); now - last_adapt >= 250'000)
+			{
+				// Adjust the number of workers taking new tasks to the amount of idle host cores
+				last_adapt = now;
+
+				double total_usage = 0.;
+				cpu_stats.get_per_core_usage(core_usage, total_usage);
+
+				u32 busy = 0;
+
+				for (u32 i = 0; i < worker_count; i++)
+				{
+					busy += (workers.begin() + i)->load ? 1 : 0;
+				}
+
+				const u32 idle_cores = static_cast<u32>(std::max(100. - total_usage, 0.) * hc / 100.);
+
+				// Keep one idle core as headroom
+				m_active_workers = std::clamp<u32>(busy + (idle_cores ? idle_cores - 1 : 0), base_count, worker_count);
 			}
 
-			// Find the most used enqueued item
-			u64 sample_max = 0;
-			auto found_it  = enqueued.begin();
+			// Hand out the hottest tasks, keeping at most one queued task per active worker
+			const u32 active = m_active_workers;
 
-			for (auto it = enqueued.begin(), end = enqueued.end(); it != end; ++it)
+			while (!enqueued.empty())
 			{
-				const u64 cur = ::at32(std::as_const(samples), it->first);
+				spu_llvm_worker* target = nullptr;
 
-				if (cur > sample_max)
+				for (u32 i = 0; i < active; i++)
 				{
-					sample_max = cur;
-					found_it = it;
+					spu_llvm_worker* w = workers.begin() + i;
+
+					if (!target || w->load < target->load)
+					{
+						target = w;
+					}
+				}
+
+				if (target->load >= 2)
+				{
+					break;
 				}
+
+				std::pop_heap(enqueued.begin(), enqueued.end(), entry_less);
+				target->push(enqueued.back().task);
+				enqueued.pop_back();
 			}
 
-			// Start compiling
-			const spu_program& func = found_it->second->data;
+			u32 depth = ::size32(enqueued);
 
-			// Old function pointer (pre-recompiled)
-			const spu_function_t _old = found_it->second->compiled;
+			for (u32 i = 0; i < worker_count; i++)
+			{
+				depth += (workers.begin() + i)->load;
+			}
 
-			// Remove item from the queue
-			enqueued.erase(found_it);
+			m_queue_depth = depth;
+			m_queue_depth_max.fetch_op([&](u32& v) { v = std::max(v, depth); });
 
-			// Push the workload
-			(workers.begin() + (worker_index++ % worker_count))->registered.push(reinterpret_cast<u64>(_old), &func);
+			if (enqueued.empty())
+			{
+				// Interrupt profiler thread and put it to sleep
+				static_cast<void>(prof_mutex.reset());
+				thread_ctrl::wait_on(utils::bless<atomic_t<u32>>(&registered)[1], 0);
+				continue;
+			}
+
+			// Wait for new blocks, a finished task or the next profiler pass
+			thread_ctrl::wait_on_custom<2>([&](atomic_wait::list<4>& list)
+			{
+				list.template set<0>(utils::bless<atomic_t<u32>>(&registered)[1], 0);
+				list.template set<1>(m_done, done);
+			}, 20'000);
 		}
 
 		static_cast<void>(prof_mutex.init_always([&]{ samples.clear(); }));
@@ -4625,6 +4978,12 @@ struct spu_llvm
 		{
 			(workers.begin() + i)->operator=(thread_state::aborting);
 		}
+
+		if (const u64 compiled = m_compiled)
+		{
+			spu_log.notice("SPU LLVM: Compiled %u programs with %u workers (stolen=%u, avg compile=%uus, avg time-to-install=%uus, max=%uus, max queue depth=%u)",
+				compiled, worker_count, m_stolen, m_compile_time_sum / compiled, m_latency_sum / compiled, m_latency_max, m_queue_depth_max);
+		}
 	}
 
 	spu_llvm& operator=(thread_state)
@@ -4640,11 +4999,112 @@ struct spu_llvm
 		return *this;
 	}
 
+	// Maximum number of workers above the base count
+	static constexpr u32 c_max_extra_workers = 4;
+
 	static constexpr auto thread_name = "SPU LLVM"sv;
 };
 
 using spu_llvm_thread = named_thread<spu_llvm>;
 
+void spu_llvm_worker::operator()()
+{
+	// SPU LLVM Recompiler instance (created on the first task, workers which never run don't hold an LLVM context)
+	std::unique_ptr<spu_recompiler_base> compiler;
+
+	// Fake LS
+	std::vector<be_t<u32>> ls;
+
+	auto& llvm = g_fxo->get<spu_llvm_thread>();
+
+	while (thread_ctrl::state() != thread_state::aborting)
+	{
+		const u32 old_signal = signal;
+
+		spu_llvm_task task;
+
+		if (!pop(task))
+		{
+			if (!llvm.steal(this, task))
+			{
+				thread_ctrl::wait_on(signal, old_signal);
+				continue;
+			}
+		}
+
+		if (!compiler)
+		{
+			compiler = spu_recompiler_base::make_llvm_recompiler();
+			compiler->init();
+			ls.resize(0x10000);
+		}
+
+		const u64 start_time = get_system_time();
+
+		const spu_program& func = task.item->data;
+
+		// Old function pointer (pre-recompiled)
+		const u64 _old = reinterpret_cast<u64>(+task.item->compiled);
+
+		// Get data start
+		const u32 start = func.lower_bound;
+		const u32 size0 = ::size32(func.data);
+
+		// Initialize LS with function data only
+		for (u32 i = 0, pos = start; i < size0; i++, pos += 4)
+		{
+			ls[pos / 4] = std::bit_cast<be_t<u32>>(func.data[i]);
+		}
+
+		// Call analyser
+		spu_program func2 = compiler->analyse(ls.data(), func.entry_point);
+
+		if (func2 != func)
+		{
+			spu_log.error("[0x%05x] SPU Analyser failed, %u vs %u", func2.entry_point, func2.data.size(), size0);
+		}
+		else if (const auto target = compiler->compile(std::move(func2)))
+		{
+			// Redirect old function (TODO: patch in multiple places)
+			const s64 rel = reinterpret_cast<u64>(target) - _old - 5;
+
+			union
+			{
+				u8 bytes[8];
+				u64 result;
+			};
+
+			bytes[0] = 0xe9; // jmp rel32
+			std::memcpy(bytes + 1, &rel, 4);
+			bytes[5] = 0x90;
+			bytes[6] = 0x90;
+			bytes[7] = 0x90;
+
+			atomic_storage<u64>::release(*reinterpret_cast<u64*>(_old), result);
+
+			const u64 end_time = get_system_time();
+			const u64 latency = end_time - task.stamp;
+
+			llvm.m_compiled++;
+			llvm.m_compile_time_sum += end_time - start_time;
+			llvm.m_latency_sum += latency;
+			llvm.m_latency_max.fetch_op([&](u64& v) { v = std::max(v, latency); });
+		}
+		else
+		{
+			spu_log.fatal("[0x%05x] Compilation failed.", func.entry_point);
+			return;
+		}
+
+		// Clear fake LS
+		std::memset(ls.data() + start / 4, 0, 4 * (size0 - 1));
+
+		load--;
+		llvm.m_done++;
+		llvm.m_done.notify_one();
+	}
+}
+
 struct spu_fast : public spu_recompiler_base
 {
 	virtual void init() override
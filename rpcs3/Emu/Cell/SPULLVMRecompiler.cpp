@@ -1168,6 +1168,7 @@ public:
 		_module->setTargetTriple(jit_compiler::triple2());
 		_module->setDataLayout(m_jit.get_engine().getTargetMachine()->createDataLayout());
 		m_module = _module.get();
+		init_debug_info("spu");
 
 		// Initialize IR Builder
 		IRBuilder<> irb(m_context);
@@ -1594,6 +1595,8 @@ public:
 					else
 						m_next_op = func.data[(m_pos - start) / 4 + 1];
 
+					set_guest_address(m_pos);
+
 					// Execute recompiler function (TODO)
 					(this->*decode(op))({op});
 				}
@@ -2016,8 +2019,11 @@ public:
 		for (auto& f : *m_module)
 		{
 			replace_intrinsics(f);
+			finalize_debug_info(f);
 		}
 
+		finalize_debug_info();
+
 		for (const auto& func : m_functions)
 		{
 			const auto f = func.second.fn ? func.second.fn : func.second.chunk;
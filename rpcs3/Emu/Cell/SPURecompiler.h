@@ -12,29 +12,59 @@
 // Helper class
 class spu_cache
 {
-	fs::file m_file;
+	// Record archive (see SPUCommonRecompiler.cpp)
+	struct state_t;
+
+	std::unique_ptr<state_t> m_state;
 
 public:
-	spu_cache() = default;
+	spu_cache();
 
 	spu_cache(const std::string& loc);
 
-	spu_cache(spu_cache&&) noexcept = default;
+	spu_cache(spu_cache&&) noexcept;
 
-	spu_cache& operator=(spu_cache&&) noexcept = default;
+	spu_cache& operator=(spu_cache&&) noexcept;
 
 	~spu_cache();
 
-	operator bool() const
-	{
-		return m_file.operator bool();
-	}
+	operator bool() const;
+
+	// Get the number of unique records found when the file was opened
+	usz load();
+
+	// Get the number of loaded records
+	usz size() const;
+
+	// Get loaded record (thread-safe), returns empty program if the checksum doesn't match
+	struct spu_program get(usz index, u64* hash = nullptr) const;
+
+	// Release the file view (loaded records become unavailable)
+	void unmap();
 
-	std::deque<struct spu_program> get();
+	// Check whether the program is already stored
+	bool contains(u64 hash, u32 addr) const;
 
 	void add(const struct spu_program& func);
 
-	static void initialize();
+	// Append the index if records were added since it was last written
+	bool seal();
+
+	// Rewrite v1 or v2 cache file as a deduplicated v2 file with an up-to-date index (dst must differ from src)
+	static bool compact(const std::string& src, const std::string& dst);
+
+	static void initialize(bool build_existing_cache = true);
+
+	struct precompile_data_t
+	{
+		u32 vaddr;
+		std::basic_string<u32> inst_data;
+		std::vector<u32> funcs;
+	};
+
+	bool collect_funcs_to_precompile = true;
+
+	lf_queue<precompile_data_t> precompile_funcs;
 };
 
 struct spu_program
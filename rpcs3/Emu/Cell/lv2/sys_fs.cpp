@@ -12,6 +12,7 @@
 #include "Emu/vfs_config.h"
 #include "Emu/IdManager.h"
 #include "Emu/system_utils.hpp"
+#include "Emu/perf_meter.hpp"
 #include "Emu/Cell/lv2/sys_process.h"
 
 #include <filesystem>
@@ -123,6 +124,44 @@ bool verify_mself(const fs::file& mself_file)
 	return true;
 }
 
+lv2_fs_stat_cache::state lv2_fs_stat_cache::get(std::string_view path, fs::stat_t& info)
+{
+	reader_lock lock(mutex);
+
+	const auto found = map.find(path);
+
+	if (found == map.end())
+	{
+		return state::miss;
+	}
+
+	if (!found->second)
+	{
+		return state::noent;
+	}
+
+	info = *found->second;
+	return state::ok;
+}
+
+void lv2_fs_stat_cache::set(std::string_view path, const fs::stat_t* info)
+{
+	std::lock_guard lock(mutex);
+
+	if (map.size() >= max_entries)
+	{
+		map.clear();
+	}
+
+	map.insert_or_assign(std::string(path), info ? std::optional<fs::stat_t>(*info) : std::nullopt);
+}
+
+void lv2_fs_stat_cache::clear()
+{
+	std::lock_guard lock(mutex);
+	map.clear();
+}
+
 lv2_fs_mount_info_map::lv2_fs_mount_info_map()
 {
 	for (auto mp = &g_mp_sys_dev_root; mp; mp = mp->next) // Scan and keep track of pre-mounted devices
@@ -618,7 +657,7 @@ struct lv2_file::file_view : fs::file_base
 
 	u64 read_at(u64 offset, void* buffer, u64 size) override
 	{
-		return m_file->file.read_at(offset, buffer, size);
+		return m_file->file.read_at(m_off + offset, buffer, size);
 	}
 
 	u64 write(const void*, u64) override
@@ -977,6 +1016,8 @@ lv2_file::open_result_t lv2_file::open(std::string_view vpath, s32 flags, s32 mo
 
 error_code sys_fs_open(ppu_thread& ppu, vm::cptr<char> path, s32 flags, vm::ptr<u32> fd, s32 mode, vm::cptr<void> arg, u64 size)
 {
+	perf_meter<"FS_OPEN"_u64> perf0;
+
 	ppu.state += cpu_flag::wait;
 	lv2_obj::sleep(ppu);
 
@@ -1026,6 +1067,8 @@ error_code sys_fs_open(ppu_thread& ppu, vm::cptr<char> path, s32 flags, vm::ptr<
 
 error_code sys_fs_read(ppu_thread& ppu, u32 fd, vm::ptr<void> buf, u64 nbytes, vm::ptr<u64> nread)
 {
+	perf_meter<"FS_READ"_u64> perf0;
+
 	ppu.state += cpu_flag::wait;
 	lv2_obj::sleep(ppu);
 
@@ -1095,6 +1138,8 @@ error_code sys_fs_read(ppu_thread& ppu, u32 fd, vm::ptr<void> buf, u64 nbytes, v
 
 error_code sys_fs_write(ppu_thread& ppu, u32 fd, vm::cptr<void> buf, u64 nbytes, vm::ptr<u64> nwrite)
 {
+	perf_meter<"FS_WRITE"_u64> perf0;
+
 	ppu.state += cpu_flag::wait;
 	lv2_obj::sleep(ppu);
 
@@ -1255,6 +1300,8 @@ error_code sys_fs_close(ppu_thread& ppu, u32 fd)
 
 error_code sys_fs_opendir(ppu_thread& ppu, vm::cptr<char> path, vm::ptr<u32> fd)
 {
+	perf_meter<"FS_ODIR"_u64> perf0;
+
 	ppu.state += cpu_flag::wait;
 	lv2_obj::sleep(ppu);
 
@@ -1447,6 +1494,8 @@ error_code sys_fs_closedir(ppu_thread& ppu, u32 fd)
 
 error_code sys_fs_stat(ppu_thread& ppu, vm::cptr<char> path, vm::ptr<CellFsStat> sb)
 {
+	perf_meter<"FS_STAT"_u64> perf0;
+
 	ppu.state += cpu_flag::wait;
 	lv2_obj::sleep(ppu);
 
@@ -1483,50 +1532,73 @@ error_code sys_fs_stat(ppu_thread& ppu, vm::cptr<char> path, vm::ptr<CellFsStat>
 		return {sys_fs.warning, CELL_ENOTMOUNTED, path};
 	}
 
-	std::unique_lock lock(mp->mutex);
-
 	fs::stat_t info{};
 
-	if (!fs::get_stat(local_path, info))
+	// Files on read-only devices can't change during emulation
+	auto& stat_cache = g_fxo->get<lv2_fs_stat_cache>();
+	const auto cached = mp.read_only ? stat_cache.get(local_path, info) : lv2_fs_stat_cache::state::miss;
+
+	if (cached == lv2_fs_stat_cache::state::noent)
 	{
-		switch (auto error = fs::g_tls_error)
-		{
-		case fs::error::noent:
-		{
-			// Try to analyse split file (TODO)
-			u64 total_size = 0;
+		return {mp == &g_mp_sys_dev_hdd1 ? sys_fs.warning : sys_fs.error, CELL_ENOENT, path};
+	}
 
-			for (u32 i = 66601; i <= 66699; i++)
+	if (cached == lv2_fs_stat_cache::state::miss)
+	{
+		std::unique_lock lock(mp->mutex);
+
+		if (!fs::get_stat(local_path, info))
+		{
+			switch (auto error = fs::g_tls_error)
 			{
-				if (fs::get_stat(fmt::format("%s.%u", local_path, i), info) && !info.is_directory)
+			case fs::error::noent:
+			{
+				// Try to analyse split file (TODO)
+				u64 total_size = 0;
+
+				for (u32 i = 66601; i <= 66699; i++)
 				{
-					total_size += info.size;
+					if (fs::get_stat(fmt::format("%s.%u", local_path, i), info) && !info.is_directory)
+					{
+						total_size += info.size;
+					}
+					else
+					{
+						break;
+					}
 				}
-				else
+
+				// Use attributes from the first fragment (consistently with sys_fs_open+fstat)
+				if (fs::get_stat(local_path + ".66600", info) && !info.is_directory)
 				{
+					// Success
+					info.size += total_size;
 					break;
 				}
-			}
 
-			// Use attributes from the first fragment (consistently with sys_fs_open+fstat)
-			if (fs::get_stat(local_path + ".66600", info) && !info.is_directory)
+				if (mp.read_only)
+				{
+					stat_cache.set(local_path, nullptr);
+				}
+
+				return {mp == &g_mp_sys_dev_hdd1 ? sys_fs.warning : sys_fs.error, CELL_ENOENT, path};
+			}
+			default:
 			{
-				// Success
-				info.size += total_size;
-				break;
+				sys_fs.error("sys_fs_stat(): unknown error %s", error);
+				return {CELL_EIO, path};
+			}
 			}
-
-			return {mp == &g_mp_sys_dev_hdd1 ? sys_fs.warning : sys_fs.error, CELL_ENOENT, path};
 		}
-		default:
+
+		lock.unlock();
+
+		if (mp.read_only)
 		{
-			sys_fs.error("sys_fs_stat(): unknown error %s", error);
-			return {CELL_EIO, path};
-		}
+			stat_cache.set(local_path, &info);
 		}
 	}
 
-	lock.unlock();
 	ppu.check_state();
 
 	s32 mode = info.is_directory ? CELL_FS_S_IFDIR | 0777 : CELL_FS_S_IFREG | 0666;
@@ -7,6 +7,7 @@
 
 #include <string>
 #include <mutex>
+#include <optional>
 
 // Open Flags
 enum : s32
@@ -223,6 +224,28 @@ private:
 	std::unordered_map<std::string, lv2_fs_mount_info, fmt::string_hash, std::equal_to<>> map;
 };
 
+// Host metadata of files on read-only devices (cleared on mount/unmount)
+struct lv2_fs_stat_cache
+{
+	enum class state
+	{
+		miss,
+		noent,
+		ok,
+	};
+
+	static constexpr usz max_entries = 4096;
+
+	shared_mutex mutex;
+
+	// Host path -> stat (nullopt if the file doesn't exist)
+	std::unordered_map<std::string, std::optional<fs::stat_t>, fmt::string_hash, std::equal_to<>> map;
+
+	state get(std::string_view path, fs::stat_t& info);
+	void set(std::string_view path, const fs::stat_t* info);
+	void clear();
+};
+
 struct lv2_fs_object
 {
 	static constexpr u32 id_base = 3;
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "lv2_socket.h"
+#include "network_context.h"
 
 LOG_CHANNEL(sys_net);
 
@@ -67,6 +68,12 @@ void lv2_socket::poll_queue(std::shared_ptr<ppu_thread> ppu, bs_t<lv2_socket::po
 {
 	set_poll_event(event);
 	queue.emplace_back(std::move(ppu), poll_cb);
+
+	// Update the network thread's registration of native sockets
+	if (type == SYS_NET_SOCK_DGRAM || type == SYS_NET_SOCK_STREAM)
+	{
+		g_fxo->get<network_context>().wake_up();
+	}
 }
 
 s32 lv2_socket::clear_queue(ppu_thread* ppu)
@@ -592,6 +592,7 @@ s32 lv2_socket_p2ps::bind(const sys_net_sockaddr& addr)
 		if (!nc.list_p2p_ports.contains(p2p_port))
 		{
 			nc.list_p2p_ports.emplace(std::piecewise_construct, std::forward_as_tuple(p2p_port), std::forward_as_tuple(p2p_port));
+			nc.wake_up();
 		}
 
 		auto& pport = ::at32(nc.list_p2p_ports, p2p_port);
@@ -680,7 +681,10 @@ std::optional<s32> lv2_socket_p2ps::connect(const sys_net_sockaddr& addr)
 	{
 		std::lock_guard list_lock(nc.list_p2p_ports_mutex);
 		if (!nc.list_p2p_ports.contains(port))
+		{
 			nc.list_p2p_ports.emplace(std::piecewise_construct, std::forward_as_tuple(port), std::forward_as_tuple(port));
+			nc.wake_up();
+		}
 
 		auto& pport = ::at32(nc.list_p2p_ports, port);
 		real_socket = pport.p2p_socket;
@@ -6,6 +6,12 @@
 #include "Emu/system_config.h"
 #include "sys_net_helpers.h"
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
 LOG_CHANNEL(sys_net);
 
 // Used by RPCN to send signaling packets to RPCN server(for UDP hole punching)
@@ -85,14 +91,250 @@ namespace np
 network_thread::network_thread()
 {
 	np::init_np_handler_dependencies();
+
+#ifdef __linux__
+	ensure((epoll_fd = ::epoll_create1(EPOLL_CLOEXEC)) >= 0);
+	ensure((wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) >= 0);
+
+	::epoll_event evnt{EPOLLIN, {}};
+	evnt.data.u64 = umax;
+	ensure(::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &evnt) == 0);
+#endif
+}
+
+network_thread::~network_thread()
+{
+#ifdef __linux__
+	::close(epoll_fd);
+	::close(wake_fd);
+#endif
 }
 
 void network_thread::bind_sce_np_port()
 {
-	std::lock_guard list_lock(list_p2p_ports_mutex);
-	list_p2p_ports.emplace(std::piecewise_construct, std::forward_as_tuple(SCE_NP_PORT), std::forward_as_tuple(SCE_NP_PORT));
+	{
+		std::lock_guard list_lock(list_p2p_ports_mutex);
+		list_p2p_ports.emplace(std::piecewise_construct, std::forward_as_tuple(SCE_NP_PORT), std::forward_as_tuple(SCE_NP_PORT));
+	}
+
+	wake_up();
+}
+
+void network_thread::wake_up()
+{
+#ifdef __linux__
+	const u64 value = 1;
+	[[maybe_unused]] const auto nwritten = ::write(wake_fd, &value, sizeof(value));
+#endif
+}
+
+network_thread& network_thread::operator=(thread_state)
+{
+	wake_up();
+	return *this;
 }
 
+#ifdef __linux__
+void network_thread::operator()()
+{
+	std::vector<std::shared_ptr<lv2_socket>> socklist;
+	std::vector<u32> idlist;
+	socklist.reserve(lv2_socket::id_count);
+	idlist.reserve(lv2_socket::id_count);
+
+	s_to_awake.clear();
+
+	// Epoll data tags: lv2 socket id, P2P port with bit 32 set, or the wake up event
+	constexpr u64 p2p_tag = 1ull << 32;
+
+	struct registration
+	{
+		int fd;
+		u32 mask;
+	};
+
+	std::unordered_map<u32, registration> registered;
+	std::unordered_map<u32, registration> wanted;
+	std::unordered_map<u32, u32> revents;
+	std::set<u16> registered_p2p;
+
+	std::vector<::epoll_event> events(lv2_socket::id_count);
+
+	// Set when threads wait on sockets with timeouts which need to be checked periodically
+	bool timed = false;
+
+	u64 wakeups = 0;
+
+	while (thread_ctrl::state() != thread_state::aborting)
+	{
+		// Sleep until socket events or state changes (1ms timeout if waits can time out)
+		const int count = ::epoll_wait(epoll_fd, events.data(), ::size32(events), timed ? 1 : -1);
+
+		wakeups++;
+
+		if (count < 0 && errno != EINTR)
+		{
+			sys_net.error("Network thread: epoll_wait() failed (errno=%d)", errno);
+		}
+
+		revents.clear();
+
+		for (int i = 0; i < count; i++)
+		{
+			const u64 tag = events[i].data.u64;
+
+			if (tag == umax)
+			{
+				u64 value{};
+				[[maybe_unused]] const auto nread = ::read(wake_fd, &value, sizeof(value));
+				continue;
+			}
+
+			if (tag & p2p_tag)
+			{
+				// Check P2P sockets for incoming packets
+				std::lock_guard lock(list_p2p_ports_mutex);
+
+				if (auto found = list_p2p_ports.find(static_cast<u16>(tag)); found != list_p2p_ports.end())
+				{
+					while (found->second.recv_data())
+						;
+				}
+
+				continue;
+			}
+
+			revents[static_cast<u32>(tag)] = events[i].events;
+		}
+
+		// Register new P2P ports (they are never removed)
+		{
+			std::lock_guard lock(list_p2p_ports_mutex);
+
+			for (const auto& [port, p2p_port] : list_p2p_ports)
+			{
+				if (registered_p2p.emplace(port).second)
+				{
+					::epoll_event evnt{EPOLLIN, {}};
+					evnt.data.u64 = p2p_tag | port;
+
+					if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, p2p_port.p2p_socket, &evnt) != 0)
+					{
+						sys_net.error("[P2P] Failed to register P2P port %d (errno=%d)", port, errno);
+					}
+				}
+			}
+		}
+
+		std::lock_guard lock(s_nw_mutex);
+
+		// Obtain all native active sockets
+		idm::select<lv2_socket>([&](u32 id, lv2_socket& s)
+			{
+				if (s.get_type() == SYS_NET_SOCK_DGRAM || s.get_type() == SYS_NET_SOCK_STREAM)
+				{
+					socklist.emplace_back(idm::get_unlocked<lv2_socket>(id));
+					idlist.emplace_back(id);
+				}
+			});
+
+		for (usz i = 0; i < socklist.size(); i++)
+		{
+			::pollfd native_pfd{};
+			native_pfd.fd = socklist[i]->get_socket();
+
+			if (auto found = revents.find(idlist[i]); found != revents.end())
+			{
+				native_pfd.revents =
+					(found->second & EPOLLIN ? POLLIN : 0) |
+					(found->second & EPOLLOUT ? POLLOUT : 0) |
+					(found->second & EPOLLERR ? POLLERR : 0) |
+					(found->second & EPOLLHUP ? POLLHUP : 0);
+			}
+
+			socklist[i]->handle_events(native_pfd);
+		}
+
+		s_to_awake.erase(std::unique(s_to_awake.begin(), s_to_awake.end()), s_to_awake.end());
+
+		for (ppu_thread* ppu : s_to_awake)
+		{
+			network_clear_queue(*ppu);
+			lv2_obj::append(ppu);
+		}
+
+		if (!s_to_awake.empty())
+		{
+			lv2_obj::awake_all();
+		}
+
+		s_to_awake.clear();
+
+		// Update epoll registrations from the events selected for polling
+		timed = false;
+		wanted.clear();
+
+		for (usz i = 0; i < socklist.size(); i++)
+		{
+			const auto& sock = socklist[i];
+			const auto sock_events = sock->get_events();
+
+			if (sock->get_queue_size() && (sock->so_rcvtimeo || sock->so_sendtimeo))
+			{
+				timed = true;
+			}
+
+			if (sock_events)
+			{
+				wanted[idlist[i]] = {sock->get_socket(), ::narrow<u32>(
+					(sock_events & lv2_socket::poll_t::read ? EPOLLIN : 0) |
+					(sock_events & lv2_socket::poll_t::write ? EPOLLOUT : 0))};
+			}
+		}
+
+		// Remove first: descriptors of closed sockets may have been reused by new ones
+		for (auto it = registered.begin(); it != registered.end();)
+		{
+			if (auto found = wanted.find(it->first); found == wanted.end() || found->second.fd != it->second.fd)
+			{
+				// Fails harmlessly if the socket has already been closed
+				::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+				it = registered.erase(it);
+				continue;
+			}
+
+			it++;
+		}
+
+		for (const auto& [id, reg] : wanted)
+		{
+			const auto found = registered.find(id);
+
+			if (found != registered.end() && found->second.mask == reg.mask)
+			{
+				continue;
+			}
+
+			::epoll_event evnt{reg.mask, {}};
+			evnt.data.u64 = id;
+
+			if (::epoll_ctl(epoll_fd, found == registered.end() ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, reg.fd, &evnt) != 0)
+			{
+				sys_net.error("Network thread: failed to register socket %d (errno=%d)", id, errno);
+				continue;
+			}
+
+			registered[id] = reg;
+		}
+
+		// Don't keep sockets alive outside of the lock
+		socklist.clear();
+		idlist.clear();
+	}
+
+	sys_net.notice("Network thread: %u wakeups", wakeups);
+}
+#else
 void network_thread::operator()()
 {
 	std::vector<std::shared_ptr<lv2_socket>> socklist;
@@ -213,3 +455,4 @@ void network_thread::operator()()
 		}
 	}
 }
+#endif
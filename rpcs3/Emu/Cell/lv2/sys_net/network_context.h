@@ -15,11 +15,22 @@ struct network_thread
 	shared_mutex list_p2p_ports_mutex;
 	std::map<u16, nt_p2p_port> list_p2p_ports{};
 
+#ifdef __linux__
+	// Persistent registration of native sockets and P2P ports
+	int epoll_fd = -1;
+
+	// Wakes up the thread on socket state changes
+	int wake_fd = -1;
+#endif
+
 	static constexpr auto thread_name = "Network Thread";
 
 	network_thread();
+	~network_thread();
 	void bind_sce_np_port();
+	void wake_up();
 	void operator()();
+	network_thread& operator=(thread_state);
 };
 
 using network_context = named_thread<network_thread>;
@@ -1372,6 +1372,7 @@ rsxaudio_backend_thread::emu_audio_cfg rsxaudio_backend_thread::get_emu_cfg()
 		.buffering_enabled = static_cast<bool>(g_cfg.audio.enable_buffering),
 		.convert_to_s16 = static_cast<bool>(g_cfg.audio.convert_to_s16),
 		.enable_time_stretching = static_cast<bool>(g_cfg.audio.enable_time_stretching),
+		.time_stretching_engine = g_cfg.audio.time_stretching_engine,
 		.dump_to_file = static_cast<bool>(g_cfg.audio.dump_to_file),
 		.channels = out_ch_cnt,
 		.renderer = g_cfg.audio.renderer,
@@ -1499,7 +1500,7 @@ void rsxaudio_backend_thread::operator()()
 
 			if (emu_cfg.enable_time_stretching)
 			{
-				resampler.set_params(backend_current_cfg.cfg.ch_cnt, backend_current_cfg.cfg.freq);
+				resampler.set_params(backend_current_cfg.cfg.ch_cnt, backend_current_cfg.cfg.freq, emu_cfg.time_stretching_engine);
 				resampler.set_tempo(RESAMPLER_MAX_FREQ_VAL);
 			}
 
@@ -475,6 +475,7 @@ private:
 		bool buffering_enabled = false;
 		bool convert_to_s16 = false;
 		bool enable_time_stretching = false;
+		audio_resampler_engine time_stretching_engine = audio_resampler_engine::soundtouch;
 		bool dump_to_file = false;
 		AudioChannelCnt channels = AudioChannelCnt::STEREO;
 		audio_renderer renderer = audio_renderer::null;
@@ -7,18 +7,23 @@
 #include "Utilities/mutex.h"
 #include "Utilities/Thread.h"
 #include "Utilities/address_range.h"
+#include "Utilities/File.h"
 #include "Utilities/JIT.h"
 #include "Emu/CPU/CPUThread.h"
 #include "Emu/RSX/RSXThread.h"
 #include "Emu/Cell/SPURecompiler.h"
 #include "Emu/perf_meter.hpp"
+#include "Emu/system_config.h"
 #include <deque>
 #include <span>
+#include <unordered_map>
+
+#include "xxhash.h"
 
 #include "util/vm.hpp"
 #include "util/asm.hpp"
 #include "util/simd.hpp"
-#include "util/serialization.hpp"
+#include "util/serialization_ext.hpp"
 
 LOG_CHANNEL(vm_log, "VM");
 
@@ -1700,12 +1705,562 @@ namespace vm
 		ar.breathe();
 	}
 
+	// Incremental savestate state
+	struct snapshot_page
+	{
+		u64 hash;
+		u32 file; // Index of the file containing the page data
+		u64 pos; // Uncompressed offset of the page data in the file
+	};
+
+	struct snapshot_tracker
+	{
+		std::string dir; // Directory of the savestate and the files it references
+		std::vector<std::string> files; // Referenced files, the last entry is the savestate itself
+		std::unordered_map<u64, snapshot_page> pages; // Page locations of the last loaded or saved savestate
+		std::vector<std::pair<u64, u64>> ranges; // Page key ranges [begin, end) stored by the last loaded or saved savestate
+
+		// Preallocated blocks with write tracking started at the last load or save (address -> block id)
+		std::unordered_map<u32, u64> tracked;
+
+		// Current vm::save/vm::load operation
+		bool active = false;
+		std::string load_path;
+		std::string save_dir;
+		std::string save_name;
+		std::string save_path;
+		std::string rename_source; // New name of the previous savestate if it is replaced by the new one
+		std::vector<std::string> save_files;
+		std::unordered_map<u64, snapshot_page> save_pages;
+		std::vector<std::pair<u64, u64>> save_ranges;
+		bool block_tracked = false; // Writes of the block being saved were collected
+		usz save_untouched = 0; // Pages referenced without reading them
+
+		// Loaded pages: page key, memory, location
+		std::vector<std::tuple<u64, u8*, snapshot_page>> load_pages;
+		u32 load_self = 0;
+	};
+
+	static snapshot_tracker g_snapshot;
+
+	// Pages written since write tracking was started for incremental savestates
+	static atomic_t<u64> g_snapshot_written[0x100000 / 64]{};
+
+	enum : u8
+	{
+		snapshot_page_zero = 0,
+		snapshot_page_inline = 1,
+		snapshot_page_ref = 2,
+	};
+
+	// Limit the amount of files a savestate may depend on
+	constexpr usz c_max_snapshot_chain = 8;
+
+	static std::pair<std::string, std::string> snapshot_split_path(std::string_view path)
+	{
+		const usz name_pos = path.find_last_of(fs::delim) + 1;
+		return {std::string(path.substr(0, name_pos)), std::string(path.substr(name_pos))};
+	}
+
+	static std::string snapshot_normalize_dir(std::string_view dir)
+	{
+		// Collapse repeated delimiters for comparison
+		std::string result;
+
+		for (char c : dir)
+		{
+			const bool is_delim = c == '/' || c == '\\';
+
+			if (is_delim && !result.empty() && result.back() == '/')
+			{
+				continue;
+			}
+
+			result += is_delim ? '/' : c;
+		}
+
+		return result;
+	}
+
+	void snapshot_mark_written(u32 addr, u32 size)
+	{
+		for (u64 page = addr / 4096; page < (u64{addr} + size + 4095) / 4096 && page < 0x100000; page++)
+		{
+			g_snapshot_written[page / 64] |= 1ull << (page % 64);
+		}
+	}
+
+	static bool snapshot_test_written(u64 page_key)
+	{
+		const u64 page = page_key / 4096;
+		return !!(g_snapshot_written[page / 64] & (1ull << (page % 64)));
+	}
+
+	// Start tracking writes to preallocated blocks after loading, so that the next savestate only has to read the written pages
+	// Both views are tracked: guest code writes through vm::base, while SPU DMA, RSX and HLE write through the super pointer
+	static void snapshot_track_writes()
+	{
+		g_snapshot.tracked.clear();
+
+		if (!g_cfg.savestate.incremental || g_cfg.savestate.suspend_emu || !utils::memory_track_writes_supported())
+		{
+			return;
+		}
+
+		for (const auto& block : g_locations)
+		{
+			if (!block || !(block->flags & preallocated))
+			{
+				continue;
+			}
+
+			for (u64 page = block->addr / 4096; page < (u64{block->addr} + block->size) / 4096; page++)
+			{
+				g_snapshot_written[page / 64] &= ~(1ull << (page % 64));
+			}
+
+			if (utils::memory_track_writes(g_base_addr + block->addr, block->size) && utils::memory_track_writes(g_sudo_addr + block->addr, block->size))
+			{
+				g_snapshot.tracked.emplace(block->addr, block->is_valid());
+			}
+		}
+	}
+
+	// Mark the pages written since tracking started, returns false if they can't be known
+	static bool snapshot_collect_writes(const block_t& block)
+	{
+		const auto found = g_snapshot.tracked.find(block.addr);
+
+		if (found == g_snapshot.tracked.end() || found->second != block.is_valid())
+		{
+			// Not tracked or mapped again since then
+			return false;
+		}
+
+		std::vector<std::pair<u64, u64>> written;
+
+		for (u8* view : {g_base_addr, g_sudo_addr})
+		{
+			if (!utils::memory_collect_writes(view + block.addr, block.size, written))
+			{
+				return false;
+			}
+
+			for (const auto& [begin, end] : written)
+			{
+				snapshot_mark_written(static_cast<u32>(begin - reinterpret_cast<u64>(view)), static_cast<u32>(end - begin));
+			}
+		}
+
+		return true;
+	}
+
+	// Page-granular memory serialization used by incremental savestates
+	// Page key is the guest address of the page (with a tag for shared memory) which is stable between savestates
+	static void serialize_memory_pages(utils::serial& ar, u8* ptr, usz size, u64 key)
+	{
+		ensure((size % 4096) == 0);
+
+		std::vector<u8> states(size / 4096);
+
+		if (ar.is_writing())
+		{
+			std::vector<u64> hashes(states.size());
+
+			// Pages which weren't written since the previous savestate are still what it stored (zero if it had the range but not the page)
+			const bool use_tracking = key < (1ull << 32) && g_snapshot.block_tracked;
+			const bool covered = use_tracking && std::any_of(g_snapshot.ranges.begin(), g_snapshot.ranges.end(), [&](const std::pair<u64, u64>& r)
+			{
+				return r.first <= key && key + size <= r.second;
+			});
+
+			g_snapshot.save_ranges.emplace_back(key, key + size);
+
+			for (usz i = 0; i < states.size(); i++)
+			{
+				const u8* page = ptr + i * 4096;
+
+				if (use_tracking && !snapshot_test_written(key + i * 4096))
+				{
+					const auto found = g_snapshot.pages.find(key + i * 4096);
+
+					if (found != g_snapshot.pages.end() && found->second.file < g_snapshot.save_files.size())
+					{
+						states[i] = snapshot_page_ref;
+						hashes[i] = found->second.hash;
+						g_snapshot.save_untouched++;
+						continue;
+					}
+
+					if (covered)
+					{
+						states[i] = snapshot_page_zero;
+						g_snapshot.save_untouched++;
+						continue;
+					}
+				}
+
+				bool is_zero = true;
+
+				for (usz j = 0; j < 4096; j += 128)
+				{
+					if (!check_cache_line_zero(page + j))
+					{
+						is_zero = false;
+						break;
+					}
+				}
+
+				if (is_zero)
+				{
+					states[i] = snapshot_page_zero;
+					continue;
+				}
+
+				hashes[i] = XXH64(page, 4096, 0);
+
+				const auto found = g_snapshot.pages.find(key + i * 4096);
+
+				if (found != g_snapshot.pages.end() && found->second.hash == hashes[i] && found->second.file < g_snapshot.save_files.size())
+				{
+					// Unchanged since the previous savestate
+					states[i] = snapshot_page_ref;
+				}
+				else
+				{
+					states[i] = snapshot_page_inline;
+				}
+			}
+
+			ar(std::span<u8>(states.data(), states.size()));
+			ar.breathe();
+
+			const u32 self = ::size32(g_snapshot.save_files);
+
+			for (usz i = 0; i < states.size(); i++)
+			{
+				const u64 page_key = key + i * 4096;
+
+				if (states[i] == snapshot_page_inline)
+				{
+					const u64 pos = ar.pos;
+					ar(std::span<u8>(ptr + i * 4096, 4096));
+					g_snapshot.save_pages[page_key] = {hashes[i], self, pos};
+				}
+				else if (states[i] == snapshot_page_ref)
+				{
+					snapshot_page page = ::at32(g_snapshot.pages, page_key);
+					ar(page.file, page.pos);
+					g_snapshot.save_pages[page_key] = page;
+				}
+
+				if (i % 1024 == 0)
+				{
+					ar.breathe();
+				}
+			}
+		}
+		else
+		{
+			ar(std::span<u8>(states.data(), states.size()));
+
+			g_snapshot.ranges.emplace_back(key, key + size);
+
+			for (usz i = 0; i < states.size(); i++)
+			{
+				const u64 page_key = key + i * 4096;
+
+				switch (states[i])
+				{
+				case snapshot_page_zero:
+				{
+					break;
+				}
+				case snapshot_page_inline:
+				{
+					const u64 pos = ar.pos;
+					ar(std::span<u8>(ptr + i * 4096, 4096));
+					g_snapshot.load_pages.emplace_back(page_key, ptr + i * 4096, snapshot_page{0, g_snapshot.load_self, pos});
+					break;
+				}
+				case snapshot_page_ref:
+				{
+					const u32 file = ar.pop<u32>();
+					const u64 pos = ar.pop<u64>();
+
+					if (file >= g_snapshot.load_self)
+					{
+						fmt::throw_exception("Invalid VM incremental page reference: file=%u, pos=0x%x, ar=%s", file, pos, ar);
+					}
+
+					g_snapshot.load_pages.emplace_back(page_key, ptr + i * 4096, snapshot_page{0, file, pos});
+					break;
+				}
+				default:
+				{
+					fmt::throw_exception("Invalid VM incremental page state: %u, ar=%s", states[i], ar);
+				}
+				}
+
+				if (i % 1024 == 0)
+				{
+					ar.breathe();
+				}
+			}
+		}
+
+		ar.breathe();
+	}
+
+	static void serialize_memory(utils::serial& ar, u8* ptr, usz size, u64 key)
+	{
+		if (g_snapshot.active)
+		{
+			serialize_memory_pages(ar, ptr, size, key);
+		}
+		else
+		{
+			serialize_memory_bytes(ar, ptr, size);
+		}
+	}
+
+	// Read referenced pages from the previous savestates
+	static void snapshot_resolve_references()
+	{
+		std::vector<std::vector<std::pair<u64, u8*>>> refs(g_snapshot.files.size());
+
+		for (const auto& [key, ptr, page] : g_snapshot.load_pages)
+		{
+			if (page.file != g_snapshot.load_self)
+			{
+				refs[page.file].emplace_back(page.pos, ptr);
+			}
+		}
+
+		for (usz i = 0; i < refs.size(); i++)
+		{
+			if (refs[i].empty())
+			{
+				continue;
+			}
+
+			const std::string path = g_snapshot.dir + g_snapshot.files[i];
+
+			fs::file file(path);
+
+			if (!file)
+			{
+				fmt::throw_exception("Failed to open the savestate referenced by incremental savestate: '%s' (%s)", path, fs::g_tls_error);
+			}
+
+			utils::serial src;
+			src.set_reading_state();
+
+			if (file.size() >= 8 && file.read<u64>() == "RPCS3SAV"_u64)
+			{
+				src.m_file_handler = make_uncompressed_serialization_file_handler(std::move(file));
+			}
+			else
+			{
+				src.m_file_handler = make_compressed_serialization_file_handler(std::move(file));
+			}
+
+			// Read in file order (allows reading compressed streams)
+			std::sort(refs[i].begin(), refs[i].end(), FN(x.first < y.first));
+
+			for (const auto& [pos, ptr] : refs[i])
+			{
+				if (pos < src.pos)
+				{
+					// Duplicate reference
+					src.pos = pos;
+				}
+				else
+				{
+					src.seek_pos(pos, true);
+					src.breathe(true);
+				}
+
+				src(std::span<u8>(ptr, 4096));
+			}
+
+			vm_log.notice("Loaded %u pages from referenced savestate '%s'", refs[i].size(), path);
+		}
+	}
+
+	void snapshot_set_source(const std::string& path)
+	{
+		g_snapshot = {};
+		g_snapshot.load_path = path;
+	}
+
+	void snapshot_prepare_save(const std::string& path)
+	{
+		auto& s = g_snapshot;
+
+		s.active = g_cfg.savestate.incremental && !g_cfg.savestate.suspend_emu;
+		s.save_path = path;
+		s.rename_source.clear();
+		s.save_files.clear();
+		s.save_pages.clear();
+		s.save_ranges.clear();
+		s.save_untouched = 0;
+		std::tie(s.save_dir, s.save_name) = snapshot_split_path(path);
+
+		if (!s.active || s.pages.empty() || s.files.empty() || s.files.size() >= c_max_snapshot_chain || snapshot_normalize_dir(s.dir) != snapshot_normalize_dir(s.save_dir))
+		{
+			// Save a complete state
+			return;
+		}
+
+		for (const std::string& name : s.files)
+		{
+			if (!fs::is_file(s.dir + name))
+			{
+				vm_log.warning("Savestate '%s' is missing, saving a complete state.", s.dir + name);
+				return;
+			}
+		}
+
+		s.save_files = s.files;
+
+		if (s.files.back() == s.save_name)
+		{
+			// The previous savestate is about to be replaced, it is going to be preserved under a different name
+			for (u32 i = 1;; i++)
+			{
+				std::string name = fmt::format("%s.%u", s.save_name, i);
+
+				if (!fs::exists(s.dir + name) && std::find(s.files.begin(), s.files.end(), name) == s.files.end())
+				{
+					s.save_files.back() = name;
+					s.rename_source = std::move(name);
+					break;
+				}
+			}
+		}
+	}
+
+	// Remove savestates preserved as <name>.<n> for incremental savestates, except the ones which are still referenced
+	static void snapshot_remove_chain(const std::string& dir, const std::string& name, const std::vector<std::string>& keep)
+	{
+		const std::string chain_prefix = name + '.';
+
+		for (const auto& entry : fs::dir(dir))
+		{
+			if (entry.is_directory || !entry.name.starts_with(chain_prefix) || std::find(keep.begin(), keep.end(), entry.name) != keep.end())
+			{
+				continue;
+			}
+
+			const std::string_view suffix = std::string_view(entry.name).substr(chain_prefix.size());
+
+			if (suffix.empty() || !std::all_of(suffix.begin(), suffix.end(), [](char c) { return c >= '0' && c <= '9'; }))
+			{
+				continue;
+			}
+
+			if (fs::remove_file(dir + entry.name))
+			{
+				vm_log.notice("Removed unreferenced savestate '%s'", dir + entry.name);
+			}
+		}
+	}
+
+	bool snapshot_commit(fs::pending_file& file)
+	{
+		auto& s = g_snapshot;
+
+		if (!s.active)
+		{
+			const std::string dir = std::move(s.save_dir);
+			const std::string name = std::move(s.save_name);
+
+			s = {};
+
+			if (!file.commit())
+			{
+				return false;
+			}
+
+			// A complete state doesn't need the files preserved for the previous ones
+			snapshot_remove_chain(dir, name, {});
+			return true;
+		}
+
+		s.active = false;
+
+		if (!s.rename_source.empty() && !fs::rename(s.dir + s.files.back(), s.dir + s.rename_source, false))
+		{
+			vm_log.error("Failed to preserve previous savestate '%s' (%s)", s.dir + s.files.back(), fs::g_tls_error);
+			s.tracked.clear();
+			return false;
+		}
+
+		if (!file.commit())
+		{
+			if (!s.rename_source.empty())
+			{
+				fs::rename(s.dir + s.rename_source, s.dir + s.files.back(), false);
+			}
+
+			// Collected writes were reset against the state which failed to be saved
+			s.tracked.clear();
+			return false;
+		}
+
+		// The new savestate becomes the source of the next one
+		s.dir = s.save_dir;
+		s.files = std::move(s.save_files);
+		s.files.push_back(s.save_name);
+		s.pages = std::move(s.save_pages);
+		s.ranges = std::move(s.save_ranges);
+
+		std::vector<u32> used(s.files.size());
+
+		for (const auto& [key, page] : s.pages)
+		{
+			used[page.file]++;
+		}
+
+		// Remove preserved savestates which are no longer referenced (including leftovers of older chains)
+		std::vector<std::string> keep;
+
+		for (usz i = 0; i + 1 < s.files.size(); i++)
+		{
+			if (used[i])
+			{
+				keep.push_back(s.files[i]);
+			}
+		}
+
+		snapshot_remove_chain(s.dir, s.save_name, keep);
+
+		usz total = 0;
+
+		for (usz i = 0; i < s.files.size(); i++)
+		{
+			total += used[i];
+
+			if (i + 1 < s.files.size())
+			{
+				vm_log.notice("Incremental savestate references %u pages of '%s'", used[i], s.files[i]);
+			}
+		}
+
+		vm_log.success("Saved incremental savestate: %u pages stored, %u referenced (%u not read)", used.back(), total - used.back(), s.save_untouched);
+		return true;
+	}
+
 	void block_t::save(utils::serial& ar, std::map<utils::shm*, usz>& shared)
 	{
 		auto& m_map = (m.*block_map)();
 
 		ar(addr, size, flags);
 
+		// Unwritten pages can only be referenced if the previous savestate is still available
+		g_snapshot.block_tracked = g_snapshot.active && !g_snapshot.save_files.empty() && snapshot_collect_writes(*this);
+
 		for (const auto& [addr, shm] : m_map)
 		{
 			// Assume first page flags represent all the map
@@ -1728,7 +2283,7 @@ namespace vm
 
 				// Save raw binary image
 				const u32 guard_size = flags & stack_guarded ? 0x1000 : 0;
-				serialize_memory_bytes(ar, vm::get_super_ptr<u8>(addr + guard_size), shm.first - guard_size * 2);
+				serialize_memory(ar, vm::get_super_ptr<u8>(addr + guard_size), shm.first - guard_size * 2, addr + guard_size);
 			}
 			else
 			{
@@ -1739,6 +2294,8 @@ namespace vm
 
 		// Terminator
 		ar(u8{0});
+
+		g_snapshot.block_tracked = false;
 	}
 
 	block_t::block_t(utils::serial& ar, std::vector<std::shared_ptr<utils::shm>>& shared)
@@ -1803,7 +2360,7 @@ namespace vm
 			{
 				// Load binary image
 				const u32 guard_size = flags & stack_guarded ? 0x1000 : 0;
-				serialize_memory_bytes(ar, vm::get_super_ptr<u8>(addr0 + guard_size), size0 - guard_size * 2);
+				serialize_memory(ar, vm::get_super_ptr<u8>(addr0 + guard_size), size0 - guard_size * 2, addr0 + guard_size);
 			}
 		}
 	}
@@ -2255,6 +2812,14 @@ namespace vm
 			shared_map.emplace(p.first, &p - shared.data());
 		}
 
+		ar(static_cast<u8>(g_snapshot.active));
+
+		if (g_snapshot.active)
+		{
+			// Files which may be referenced by the following memory pages
+			ar(g_snapshot.save_files);
+		}
+
 		// TODO: proper serialization of std::map
 		ar(static_cast<usz>(shared_map.size()));
 
@@ -2264,7 +2829,14 @@ namespace vm
 			ar(shm->flags());
 
 			ar(shm->size());
-			serialize_memory_bytes(ar, vm::get_super_ptr<u8>(addr), shm->size());
+
+			if (g_snapshot.active)
+			{
+				// Sample address serves as page key of shared memory
+				ar(addr);
+			}
+
+			serialize_memory(ar, vm::get_super_ptr<u8>(addr), shm->size(), (1ull << 32) + addr);
 		}
 
 		// TODO: Serialize std::vector direcly
@@ -2288,6 +2860,27 @@ namespace vm
 	{
 		std::vector<std::shared_ptr<utils::shm>> shared;
 
+		g_snapshot.active = GET_SERIALIZATION_VERSION(global_version) >= 17 && ar.pop<u8>() != 0;
+		g_snapshot.files.clear();
+		g_snapshot.pages.clear();
+		g_snapshot.ranges.clear();
+		g_snapshot.load_pages.clear();
+
+		if (g_snapshot.active)
+		{
+			if (g_snapshot.load_path.empty())
+			{
+				fmt::throw_exception("Incremental savestate loaded without a known path, ar=%s", ar);
+			}
+
+			std::string load_name;
+			std::tie(g_snapshot.dir, load_name) = snapshot_split_path(g_snapshot.load_path);
+
+			g_snapshot.files = ar.pop<std::vector<std::string>>();
+			g_snapshot.load_self = ::size32(g_snapshot.files);
+			g_snapshot.files.push_back(std::move(load_name));
+		}
+
 		const usz shared_size = ar.pop<usz>();
 
 		if (!shared_size || ar.get_size(umax) / 4096 < shared_size)
@@ -2303,11 +2896,12 @@ namespace vm
 
 			const u32 flags = ar.pop<u32>();
 			const u64 size = ar.pop<u64>();
+			const u32 key_addr = g_snapshot.active ? ar.pop<u32>() : 0;
 			shm = std::make_shared<utils::shm>(size, flags);
 
 			// Load binary image
 			// elad335: I'm not proud about it as well.. (ideal situation is to not call map_self())
-			serialize_memory_bytes(ar, shm->map_self(), shm->size());
+			serialize_memory(ar, shm->map_self(), shm->size(), (1ull << 32) + key_addr);
 		}
 
 		for (auto& block : g_locations)
@@ -2327,6 +2921,22 @@ namespace vm
 				loc = std::make_shared<block_t>(ar, shared);
 			}
 		}
+
+		if (g_snapshot.active)
+		{
+			snapshot_resolve_references();
+
+			// Remember page locations so the next savestate can reference them
+			for (const auto& [key, ptr, page] : g_snapshot.load_pages)
+			{
+				g_snapshot.pages.emplace(key, snapshot_page{XXH64(ptr, 4096, 0), page.file, page.pos});
+			}
+
+			g_snapshot.load_pages = {};
+			g_snapshot.active = false;
+
+			snapshot_track_writes();
+		}
 	}
 
 	u32 get_shm_addr(const std::shared_ptr<utils::shm>& shared)
@@ -15,6 +15,11 @@ namespace utils
 	class address_range;
 }
 
+namespace fs
+{
+	struct pending_file;
+}
+
 namespace vm
 {
 	extern u8* const g_base_addr;
@@ -314,6 +319,19 @@ namespace vm
 	void load(utils::serial& ar);
 	void save(utils::serial& ar);
 
+	// Incremental savestates: memory pages unchanged since the previous savestate are stored as references to the file containing them
+	// Set path of the savestate which is about to be loaded (empty if not booting a savestate)
+	void snapshot_set_source(const std::string& path);
+
+	// Prepare saving the savestate to the specified path (decides whether vm::save may reference previous files)
+	void snapshot_prepare_save(const std::string& path);
+
+	// Commit the written savestate, preserving the previous file if it is referenced and removing unreferenced ones
+	bool snapshot_commit(fs::pending_file& file);
+
+	// Report guest memory writes which were collected (and reset) by another user of utils::memory_collect_writes
+	void snapshot_mark_written(u32 addr, u32 size);
+
 	// Returns sample address for shared memory, 0 on failure (wraps block_t::get_shm_addr)
 	u32 get_shm_addr(const std::shared_ptr<utils::shm>& shared);
 
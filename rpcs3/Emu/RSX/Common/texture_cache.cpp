@@ -1,12 +1,111 @@
 #include "stdafx.h"
 #include "texture_cache_utils.h"
 #include "Utilities/address_range.h"
+#include "Emu/perf_meter.hpp"
 #include "util/fnv_hash.hpp"
 
 namespace rsx
 {
 	constexpr u32 min_lockable_data_size = 4096; // Increasing this value has worse results even on systems with pages > 4k
 
+	dirty_page_tracker& dirty_page_tracker::get()
+	{
+		static dirty_page_tracker s_tracker;
+		return s_tracker;
+	}
+
+	bool dirty_page_tracker::is_enabled()
+	{
+		if (!g_cfg.video.texture_cache_dirty_tracking)
+		{
+			return false;
+		}
+
+		static const bool s_supported = []()
+		{
+			const bool result = utils::memory_track_writes_supported();
+
+			if (!result)
+			{
+				rsx_log.warning("Dirty page tracking is not supported by the host, texture cache will use page faults.");
+			}
+
+			return result;
+		}();
+
+		return s_supported;
+	}
+
+	void dirty_page_tracker::collect(const address_range& range)
+	{
+		if (!utils::memory_collect_writes(vm::base(range.start), range.length(), m_written))
+		{
+			// Assume the worst
+			const u64 base = reinterpret_cast<u64>(vm::base(range.start));
+			m_written.assign(1, {base, base + range.length()});
+		}
+
+		if (m_written.empty())
+		{
+			return;
+		}
+
+		const u64 epoch = ++m_epoch;
+		const u64 base = reinterpret_cast<u64>(vm::base(0));
+
+		for (const auto& [begin, end] : m_written)
+		{
+			// Tracking was reset for these pages, incremental savestates need to know about them as well
+			vm::snapshot_mark_written(static_cast<u32>(begin - base), static_cast<u32>(end - begin));
+
+			for (u64 page = (begin - base) / 4096; page < (end - base + 4095) / 4096 && page < 0x100000; page++)
+			{
+				m_page_epoch[page] = epoch;
+			}
+		}
+	}
+
+	u64 dirty_page_tracker::protect(const address_range& range)
+	{
+		perf_meter<"TEXTRKWP"_u64> perf0;
+
+		std::lock_guard lock(m_mutex);
+
+		if (!m_page_epoch)
+		{
+			m_page_epoch = std::make_unique<u64[]>(0x100000);
+		}
+
+		// Stamp pending writes before resetting the pages, other sections may still depend on them
+		collect(range);
+
+		if (!utils::memory_track_writes(vm::base(range.start), range.length()))
+		{
+			return umax;
+		}
+
+		return m_epoch;
+	}
+
+	bool dirty_page_tracker::test(const address_range& range, u64 epoch)
+	{
+		perf_meter<"TEXTRKCK"_u64> perf0;
+
+		std::lock_guard lock(m_mutex);
+
+		collect(range);
+
+		for (u32 page = range.start / 4096; page <= range.end / 4096; page++)
+		{
+			if (m_page_epoch[page] > epoch)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
 	void buffered_section::init_lockable_range(const address_range& range)
 	{
 		locked_range = range.to_page_range();
@@ -34,6 +133,11 @@ namespace rsx
 			protection_strat = section_protection_strategy::hash;
 			mem_hash = 0;
 		}
+		else if (dirty_page_tracker::is_enabled())
+		{
+			protection_strat = section_protection_strategy::track;
+			track_epoch = 0;
+		}
 	}
 
 	void buffered_section::invalidate_range()
@@ -68,11 +172,22 @@ namespace rsx
 			protection_strat = section_protection_strategy::lock;
 		}
 
+		if (protection_strat == section_protection_strategy::track && new_prot != utils::protection::rw)
+		{
+			track_epoch = dirty_page_tracker::get().protect(locked_range);
+
+			if (track_epoch == umax)
+			{
+				// Fallback to page protection
+				protection_strat = section_protection_strategy::lock;
+			}
+		}
+
 		if (protection_strat == section_protection_strategy::lock)
 		{
 			rsx::memory_protect(locked_range, new_prot);
 		}
-		else if (new_prot != utils::protection::rw)
+		else if (protection_strat == section_protection_strategy::hash && new_prot != utils::protection::rw)
 		{
 			mem_hash = fast_hash_internal();
 		}
@@ -213,6 +328,11 @@ namespace rsx
 			return true;
 		}
 
+		if (protection_strat == section_protection_strategy::track)
+		{
+			return dirty_page_tracker::get().test(locked_range, track_epoch);
+		}
+
 		return (fast_hash_internal() == mem_hash);
 	}
 }
@@ -3464,6 +3464,7 @@ namespace rsx
 				{
 					return tex.get_context() == context &&
 						tex.is_locked() &&
+						(!tex.is_tracked() || tex.sync()) &&
 						test_range.inside(tex.get_section_range());
 				}
 			}
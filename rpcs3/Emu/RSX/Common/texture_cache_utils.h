@@ -22,7 +22,8 @@ namespace rsx
 	enum section_protection_strategy
 	{
 		lock,
-		hash
+		hash,
+		track
 	};
 
 	static inline void memory_protect(const address_range& range, utils::protection prot)
@@ -37,6 +38,30 @@ namespace rsx
 #endif
 	}
 
+	/**
+	 * Polled detection of CPU writes without page faults (section_protection_strategy::track)
+	 * Written pages are collected from the kernel and stamped with an epoch, so sections sharing pages don't miss each other's writes
+	 */
+	class dirty_page_tracker
+	{
+		shared_mutex m_mutex;
+		u64 m_epoch = 0;
+		std::unique_ptr<u64[]> m_page_epoch;
+		std::vector<std::pair<u64, u64>> m_written;
+
+		void collect(const address_range& range);
+
+	public:
+		static dirty_page_tracker& get();
+		static bool is_enabled();
+
+		// Start tracking the range, returns current epoch or umax on failure
+		u64 protect(const address_range& range);
+
+		// Returns false if the range was written after the epoch
+		bool test(const address_range& range, u64 epoch);
+	};
+
 	/**
 	 * List structure used in Ranged Storage Blocks
 	 * List of Arrays
@@ -615,14 +640,20 @@ namespace rsx
 
 		void trim_sections()
 		{
+			// Tracked sections never fault, so CPU writes collected since the last frame are applied here
+			// Lookups validate the sections they return, this catches the remaining users of locked sections
+			const bool sync_tracked = dirty_page_tracker::is_enabled();
+
 			for (auto it = m_in_use.begin(); it != m_in_use.end(); it++)
 			{
 				auto* block = *it;
-				if (block->get_locked_count() > 256)
+				const bool trim = block->get_locked_count() > 256;
+
+				if (trim || sync_tracked)
 				{
 					for (auto& tex : *block)
 					{
-						if (tex.is_locked() && !tex.is_locked(true))
+						if (tex.is_locked() && !tex.is_locked(true) && (trim || tex.is_tracked()))
 						{
 							tex.sync_protection();
 						}
@@ -888,6 +919,7 @@ namespace rsx
 
 		section_protection_strategy protection_strat = section_protection_strategy::lock;
 		u64 mem_hash = 0;
+		u64 track_epoch = 0;
 
 		bool locked = false;
 		void init_lockable_range(const address_range& range);
@@ -914,6 +946,12 @@ namespace rsx
 
 		bool is_locked(bool actual_page_flags = false) const;
 
+		// Protected by dirty page tracking, CPU writes are only noticed by sync()
+		bool is_tracked() const
+		{
+			return locked && protection_strat == section_protection_strategy::track;
+		}
+
 		/**
 		 * Overlapping checks
 		 */
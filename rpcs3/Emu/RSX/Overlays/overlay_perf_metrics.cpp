@@ -4,6 +4,7 @@
 #include "Emu/RSX/RSXThread.h"
 #include "Emu/Cell/SPUThread.h"
 #include "Emu/Cell/PPUThread.h"
+#include "Emu/Audio/audio_resampler.h"
 
 #include <algorithm>
 #include <utility>
@@ -239,7 +240,7 @@ namespace rsx
 			case detail_level::minimal: [[fallthrough]];
 			case detail_level::low: m_titles.set_text(""); break;
 			case detail_level::medium: m_titles.set_text(fmt::format("\n\n%s", title1_medium)); break;
-			case detail_level::high: m_titles.set_text(fmt::format("\n\n%s\n\n\n\n\n\n%s", title1_high, title2)); break;
+			case detail_level::high: m_titles.set_text(fmt::format("\n\n%s\n\n\n\n\n\n\n%s", title1_high, title2)); break;
 			}
 			m_titles.auto_resize();
 			m_titles.refresh();
@@ -477,6 +478,12 @@ namespace rsx
 
 						m_total_threads = utils::cpu_stats::get_current_thread_count();
 
+						// Time spent in audio resamplers relative to the update interval (one host core = 100%)
+						const u64 audio_busy_ns = g_audio_resampler_stats.busy_ns;
+						m_audio_usage = std::clamp(static_cast<f32>((audio_busy_ns - m_audio_busy_ns) / (elapsed_update * 10'000.)), 0.f, 100.f);
+						m_audio_busy_ns = audio_busy_ns;
+						m_audio_latency = g_audio_resampler_stats.latency_us / 1000.f;
+
 						[[fallthrough]];
 					}
 					case detail_level::medium:
@@ -565,10 +572,12 @@ namespace rsx
 					                         " PPU   : %04.1f %% (%2u)\n"
 					                         " SPU   : %04.1f %% (%2u)\n"
 					                         " RSX   : %04.1f %% ( 1)\n"
-					                         " Total : %04.1f %% (%2u)\n\n"
+					                         " Total : %04.1f %% (%2u)\n"
+					                         " Audio : %04.1f %% (%.1fms)\n\n"
 					                         "%s\n"
 					                         " RSX   : %02u %%",
-					    m_fps, m_frametime, std::string(title1_high.size(), ' '), m_ppu_usage, m_ppus, m_spu_usage, m_spus, m_rsx_usage, m_cpu_usage, m_total_threads, std::string(title2.size(), ' '), m_rsx_load);
+					    m_fps, m_frametime, std::string(title1_high.size(), ' '), m_ppu_usage, m_ppus, m_spu_usage, m_spus, m_rsx_usage, m_cpu_usage, m_total_threads,
+					    m_audio_usage, m_audio_latency, std::string(title2.size(), ' '), m_rsx_load);
 					break;
 				}
 				}
@@ -78,6 +78,10 @@ namespace rsx
 			f32 m_rsx_usage{0};
 			u32 m_rsx_load{0};
 
+			u64 m_audio_busy_ns{0};
+			f32 m_audio_usage{0};
+			f32 m_audio_latency{0}; // in ms
+
 			void reset_transform(label& elm) const;
 			void reset_transforms();
 			void reset_body();
@@ -0,0 +1,94 @@
+#include "stdafx.h"
+#include "rsx_cache.h"
+
+namespace
+{
+	constexpr record_archive::format c_pipeline_cache_format
+	{
+		.magic = "RPCS3RSX"_u64,
+		.version = 1,
+		.record_tag = "RSXR"_u32,
+		.index_tag = "RSXI"_u32,
+		.max_record_size = 0x100000, // Sanity limit (largest programs are a few KiB)
+	};
+}
+
+namespace rsx
+{
+	pipeline_cache_archive::pipeline_cache_archive()
+		: m_archive("Pipeline cache", c_pipeline_cache_format)
+	{
+	}
+
+	bool pipeline_cache_archive::open(const std::string& path)
+	{
+		m_pipelines.clear();
+
+		if (!m_archive.open(path))
+		{
+			return false;
+		}
+
+		for (usz i = 0, count = m_archive.loaded_count(); i < count; i++)
+		{
+			if (m_archive.get_info(i).type == static_cast<u32>(record_type::pipeline))
+			{
+				m_pipelines.push_back(i);
+			}
+		}
+
+		rsx_log.notice("Pipeline cache: Found %u pipeline objects in %s", m_pipelines.size(), path);
+		return true;
+	}
+
+	void pipeline_cache_archive::close()
+	{
+		m_archive.close();
+		m_pipelines = {};
+	}
+
+	void pipeline_cache_archive::unmap()
+	{
+		m_archive.unmap();
+		m_pipelines = {};
+	}
+
+	bool pipeline_cache_archive::seal()
+	{
+		return m_archive.seal();
+	}
+
+	std::span<const u8> pipeline_cache_archive::get_pipeline(usz index)
+	{
+		if (index >= m_pipelines.size())
+		{
+			return {};
+		}
+
+		return m_archive.get(m_pipelines[index]);
+	}
+
+	void pipeline_cache_archive::invalidate_pipeline(usz index)
+	{
+		if (index < m_pipelines.size())
+		{
+			const auto info = m_archive.get_info(m_pipelines[index]);
+			m_archive.invalidate(info.type, info.key);
+		}
+	}
+
+	std::span<const u8> pipeline_cache_archive::find(record_type type, u64 key)
+	{
+		return m_archive.find(static_cast<u32>(type), key);
+	}
+
+	bool pipeline_cache_archive::contains(record_type type, u64 key) const
+	{
+		return m_archive.contains(static_cast<u32>(type), key);
+	}
+
+	bool pipeline_cache_archive::append(record_type type, u64 key, const void* data, usz size)
+	{
+		return m_archive.append(static_cast<u32>(type), key, data, size);
+	}
+}
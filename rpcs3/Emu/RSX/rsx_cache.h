@@ -2,6 +2,7 @@
 #include "Utilities/File.h"
 #include "Utilities/lockless.h"
 #include "Utilities/Thread.h"
+#include "Utilities/record_archive.h"
 #include "Common/bitfield.hpp"
 #include "Common/unordered_map.hpp"
 #include "Emu/System.h"
@@ -11,12 +12,74 @@
 #include "Overlays/Shaders/shader_loading_dialog.h"
 
 #include <chrono>
+#include <span>
 
 #include "util/sysinfo.hpp"
 #include "util/fnv_hash.hpp"
 
 namespace rsx
 {
+	// Single-file append-only store for the pipeline cache (see record_archive)
+	// Records are raw programs keyed by their hash and pipeline descriptions keyed by get_pipeline_key()
+	class pipeline_cache_archive
+	{
+	public:
+		enum class record_type : u32
+		{
+			vertex_program = 1,
+			fragment_program = 2,
+			pipeline = 3,
+		};
+
+		pipeline_cache_archive();
+		pipeline_cache_archive(const pipeline_cache_archive&) = delete;
+		pipeline_cache_archive& operator=(const pipeline_cache_archive&) = delete;
+
+		// Open or create the archive and map its contents
+		bool open(const std::string& path);
+
+		// Write the index and close the file
+		void close();
+
+		// Release the mapped view (lookups return nothing until the next open())
+		void unmap();
+
+		// Write an index covering all records if needed
+		bool seal();
+
+		explicit operator bool() const
+		{
+			return !!m_archive;
+		}
+
+		// Number of pipeline records in the mapped view
+		usz pipeline_count() const
+		{
+			return m_pipelines.size();
+		}
+
+		// Get the payload of a pipeline record from the mapped view (checksum verified, empty on failure)
+		// A corrupted record is dropped from the index, so that the next append() writes it again
+		std::span<const u8> get_pipeline(usz index);
+
+		// Drop a pipeline record which can't be used (e.g. not binary compatible)
+		void invalidate_pipeline(usz index);
+
+		// Find a raw program in the mapped view (checksum verified, empty on failure)
+		std::span<const u8> find(record_type type, u64 key);
+
+		bool contains(record_type type, u64 key) const;
+
+		// Append a record unless one with the same type and key already exists
+		bool append(record_type type, u64 key, const void* data, usz size);
+
+	private:
+		record_archive m_archive;
+
+		// Indices of pipeline records among the loaded records (file order), only modified by open() and unmap()
+		std::vector<usz> m_pipelines;
+	};
+
 	template <typename pipeline_storage_type, typename backend_storage>
 	class shaders_cache
 	{
@@ -63,13 +126,14 @@ namespace rsx
 
 		backend_storage& m_storage;
 
+		pipeline_cache_archive m_archive;
+
 		static std::string get_message(u32 index, u32 processed, u32 entry_count)
 		{
 			return fmt::format("%s pipeline object %u of %u", index == 0 ? "Loading" : "Compiling", processed, entry_count);
 		}
 
-		void load_shaders(uint nb_workers, unpacked_type& unpacked, std::string& directory_path, std::vector<fs::dir_entry>& entries, u32 entry_count,
-		    shader_loading_dialog* dlg)
+		void load_shaders(uint nb_workers, unpacked_type& unpacked, u32 entry_count, shader_loading_dialog* dlg)
 		{
 			atomic_t<u32> processed(0);
 
@@ -79,31 +143,28 @@ namespace rsx
 				// Processed is incremented before work starts in order to avoid two workers working on the same shader
 				while (((pos = processed++) < stop_at) && !Emu.IsStopped())
 				{
-					fs::dir_entry tmp = entries[pos];
-
-					const auto filename = directory_path + "/" + tmp.name;
-					fs::file f(filename);
+					const auto record = m_archive.get_pipeline(pos);
 
-					if (!f)
+					if (record.size() != sizeof(pipeline_data))
 					{
-						// Unexpected error, but avoid crash
-						continue;
-					}
+						// Corrupted records are dropped by the archive, drop incompatible ones too so that the next store() writes them again
+						if (!record.empty())
+						{
+							m_archive.invalidate_pipeline(pos);
+						}
 
-					if (f.size() != sizeof(pipeline_data))
-					{
-						rsx_log.error("Removing cached pipeline object %s since it's not binary compatible with the current shader cache", tmp.name.c_str());
-						fs::remove_file(filename);
 						continue;
 					}
 
 					pipeline_data pdata{};
-					f.read(&pdata, f.size());
+					std::memcpy(&pdata, record.data(), sizeof(pipeline_data));
 
 					auto entry = unpack(pdata);
 
 					if (std::get<1>(entry).data.empty() || !std::get<2>(entry).ucode_length)
 					{
+						// Missing or corrupted program, let the next store() write the pipeline again
+						m_archive.invalidate_pipeline(pos);
 						continue;
 					}
 
@@ -118,6 +179,101 @@ namespace rsx
 			await_workers(nb_workers, 0, shader_load_worker, processed, entry_count, dlg);
 		}
 
+		static u64 get_state_hash(const pipeline_data& data)
+		{
+			u64 state_hash = 0;
+			state_hash ^= rpcs3::hash_base<u32>(data.vp_ctrl0);
+			state_hash ^= rpcs3::hash_base<u32>(data.vp_ctrl1);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_ctrl);
+			state_hash ^= rpcs3::hash_base<u32>(data.vp_texture_dimensions);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_texture_dimensions);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_texcoord_control);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_height);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_pixel_layout);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_lighting_flags);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_shadow_textures);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_redirected_textures);
+			state_hash ^= rpcs3::hash_base<u16>(data.vp_multisampled_textures);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_multisampled_textures);
+			return state_hash;
+		}
+
+		// Same identity as the legacy "%llX+%llX+%llX+%llX.bin" file name
+		static u64 get_pipeline_key(const pipeline_data& data)
+		{
+			u64 key = rpcs3::fnv_seed;
+			key = rpcs3::hash64(key, data.vertex_program_hash);
+			key = rpcs3::hash64(key, data.fragment_program_hash);
+			key = rpcs3::hash64(key, data.pipeline_storage_hash);
+			key = rpcs3::hash64(key, get_state_hash(data));
+			return key;
+		}
+
+		// One-time import of the legacy one-file-per-pipeline layout
+		void import_legacy(const std::string& directory_path)
+		{
+			fs::dir root(directory_path);
+
+			if (!root)
+			{
+				return;
+			}
+
+			usz imported = 0;
+			usz skipped = 0;
+
+			for (auto&& tmp : root)
+			{
+				if (tmp.is_directory)
+					continue;
+
+				if (tmp.size != sizeof(pipeline_data))
+				{
+					skipped++;
+					continue;
+				}
+
+				pipeline_data pdata{};
+
+				if (fs::file f(directory_path + "/" + tmp.name); !f || !f.read(pdata))
+				{
+					skipped++;
+					continue;
+				}
+
+				std::vector<u8> vp, fp;
+
+				if (fs::file f(fmt::format("%s/raw/%llX.vp", root_path, pdata.vertex_program_hash)); f)
+				{
+					vp = f.to_vector<u8>();
+				}
+
+				if (fs::file f(fmt::format("%s/raw/%llX.fp", root_path, pdata.fragment_program_hash)); f)
+				{
+					fp = f.to_vector<u8>();
+				}
+
+				if (vp.empty() || fp.empty() || vp.size() % sizeof(u32))
+				{
+					skipped++;
+					continue;
+				}
+
+				m_archive.append(pipeline_cache_archive::record_type::vertex_program, pdata.vertex_program_hash, vp.data(), vp.size());
+				m_archive.append(pipeline_cache_archive::record_type::fragment_program, pdata.fragment_program_hash, fp.data(), fp.size());
+
+				if (m_archive.append(pipeline_cache_archive::record_type::pipeline, get_pipeline_key(pdata), &pdata, sizeof(pdata)))
+				{
+					imported++;
+				}
+			}
+
+			if (imported || skipped)
+			{
+				rsx_log.notice("shaders_cache: Imported %u pipeline objects from %s (%u skipped)", imported, directory_path, skipped);
+			}
+		}
+
 		template <typename... Args>
 		void compile_shaders(uint nb_workers, unpacked_type& unpacked, u32 entry_count, shader_loading_dialog* dlg, Args&&... args)
 		{
@@ -219,33 +375,37 @@ namespace rsx
 				return;
 			}
 
-			std::string directory_path = root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix;
+			const std::string class_path = root_path + "/pipelines/" + pipeline_class_name;
+			const std::string archive_path = class_path + "/" + version_prefix + ".pack";
 
-			fs::dir root = fs::dir(directory_path);
+			fs::create_path(class_path);
 
-			if (!root)
+			const bool is_new = !fs::is_file(archive_path);
+
+			if (!m_archive.open(archive_path))
 			{
-				fs::create_path(directory_path);
-				fs::create_path(root_path + "/raw");
+				rsx_log.error("shaders_cache: Failed to open %s (%s)", archive_path, fs::g_tls_error);
 				return;
 			}
 
-			std::vector<fs::dir_entry> entries;
-
-			for (auto&& tmp : root)
+			if (is_new)
 			{
-				if (tmp.is_directory)
-					continue;
+				import_legacy(class_path + "/" + version_prefix);
 
-				entries.push_back(tmp);
+				// Remap with the imported records
+				if (!m_archive.seal() || !m_archive.open(archive_path))
+				{
+					return;
+				}
 			}
 
-			u32 entry_count = ::size32(entries);
+			u32 entry_count = ::narrow<u32>(m_archive.pipeline_count());
 
 			if (!entry_count)
+			{
+				m_archive.unmap();
 				return;
-
-			root.rewind();
+			}
 
 			// Progress dialog
 			std::unique_ptr<shader_loading_dialog> fallback_dlg;
@@ -265,7 +425,10 @@ namespace rsx
 			unpacked_type unpacked;
 			uint nb_workers = g_cfg.video.renderer == video_renderer::vulkan ? utils::get_thread_count() : 1;
 
-			load_shaders(nb_workers, unpacked, directory_path, entries, entry_count, dlg);
+			load_shaders(nb_workers, unpacked, entry_count, dlg);
+
+			// Raw programs have been copied out, the view is no longer needed
+			m_archive.unmap();
 
 			// Account for any invalid entries
 			entry_count = unpacked.size();
@@ -278,7 +441,7 @@ namespace rsx
 
 		void store(const pipeline_storage_type &pipeline, const RSXVertexProgram &vp, const RSXFragmentProgram &fp)
 		{
-			if (root_path.empty())
+			if (root_path.empty() || !m_archive)
 			{
 				return;
 			}
@@ -291,58 +454,49 @@ namespace rsx
 
 			pipeline_data data = pack(pipeline, vp, fp);
 
-			std::string fp_name = root_path + "/raw/" + fmt::format("%llX.fp", data.fragment_program_hash);
-			std::string vp_name = root_path + "/raw/" + fmt::format("%llX.vp", data.vertex_program_hash);
+			const u64 key = get_pipeline_key(data);
 
-			// Writeback to cache either if file does not exist or it is invalid (unexpected size)
-			// Note: fs::write_file is not atomic, if the process is terminated in the middle an empty file is created
-			if (fs::stat_t s{}; !fs::get_stat(fp_name, s) || s.size != fp.ucode_length)
+			if (m_archive.contains(pipeline_cache_archive::record_type::pipeline, key))
 			{
-				fs::write_file(fp_name, fs::rewrite, fp.get_data(), fp.ucode_length);
+				return;
 			}
 
-			if (fs::stat_t s{}; !fs::get_stat(vp_name, s) || s.size != vp.data.size() * sizeof(u32))
+			// Raw programs are deduplicated by the archive, they must precede the pipeline record referencing them
+			if (!m_archive.append(pipeline_cache_archive::record_type::vertex_program, data.vertex_program_hash, vp.data.data(), vp.data.size() * sizeof(u32)) &&
+				!m_archive.contains(pipeline_cache_archive::record_type::vertex_program, data.vertex_program_hash))
 			{
-				fs::write_file(vp_name, fs::rewrite, vp.data);
+				return;
 			}
 
-			u64 state_hash = 0;
-			state_hash ^= rpcs3::hash_base<u32>(data.vp_ctrl0);
-			state_hash ^= rpcs3::hash_base<u32>(data.vp_ctrl1);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_ctrl);
-			state_hash ^= rpcs3::hash_base<u32>(data.vp_texture_dimensions);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_texture_dimensions);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_texcoord_control);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_height);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_pixel_layout);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_lighting_flags);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_shadow_textures);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_redirected_textures);
-			state_hash ^= rpcs3::hash_base<u16>(data.vp_multisampled_textures);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_multisampled_textures);
+			if (!m_archive.append(pipeline_cache_archive::record_type::fragment_program, data.fragment_program_hash, fp.get_data(), fp.ucode_length) &&
+				!m_archive.contains(pipeline_cache_archive::record_type::fragment_program, data.fragment_program_hash))
+			{
+				return;
+			}
 
-			const std::string pipeline_file_name = fmt::format("%llX+%llX+%llX+%llX.bin", data.vertex_program_hash, data.fragment_program_hash, data.pipeline_storage_hash, state_hash);
-			const std::string pipeline_path = root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix + "/" + pipeline_file_name;
-			fs::write_file(pipeline_path, fs::rewrite, &data, sizeof(data));
+			m_archive.append(pipeline_cache_archive::record_type::pipeline, key, &data, sizeof(data));
 		}
 
-		RSXVertexProgram load_vp_raw(u64 program_hash) const
+		RSXVertexProgram load_vp_raw(u64 program_hash)
 		{
 			RSXVertexProgram vp = {};
 
-			fs::file f(fmt::format("%s/raw/%llX.vp", root_path, program_hash));
-			if (f) f.read(vp.data, f.size() / sizeof(u32));
+			if (const auto raw = m_archive.find(pipeline_cache_archive::record_type::vertex_program, program_hash); !raw.empty())
+			{
+				vp.data.resize(raw.size() / sizeof(u32));
+				std::memcpy(vp.data.data(), raw.data(), vp.data.size() * sizeof(u32));
+			}
 
 			return vp;
 		}
 
 		RSXFragmentProgram load_fp_raw(u64 program_hash)
 		{
-			fs::file f(fmt::format("%s/raw/%llX.fp", root_path, program_hash));
+			const auto raw = m_archive.find(pipeline_cache_archive::record_type::fragment_program, program_hash);
 
 			RSXFragmentProgram fp = {};
 
-			const u32 size = fp.ucode_length = f ? ::size32(f) : 0;
+			const u32 size = fp.ucode_length = ::size32(raw);
 
 			if (!size)
 			{
@@ -351,7 +505,7 @@ namespace rsx
 
 			auto buf = std::make_unique<u8[]>(size);
 			fp.data = buf.get();
-			f.read(buf.get(), size);
+			std::memcpy(buf.get(), raw.data(), size);
 			fragment_program_data[fragment_program_data.push_begin()] = std::move(buf);
 			return fp;
 		}
@@ -626,6 +626,18 @@ void Emulator::Init()
 				sys_log.success("Removed save data backup: %s%s", save_path, entry.name);
 			}
 		}
+		else if (entry.is_directory && entry.name.starts_with(".deleting_"))
+		{
+			// Finish interrupted deletion
+			if (!fs::remove_all(save_path + entry.name))
+			{
+				sys_log.error("Failed to remove deleted save data: %s%s (%s)", save_path, entry.name, fs::g_tls_error);
+			}
+			else
+			{
+				sys_log.success("Removed deleted save data: %s%s", save_path, entry.name);
+			}
+		}
 	}
 
 	// Limit cache size
@@ -953,6 +965,9 @@ game_boot_result Emulator::Load(const std::string& title_id, bool is_disc_patch,
 		}
 	}
 
+	// Pages of incremental savestates are referenced relatively to the savestate path
+	vm::snapshot_set_source(m_ar ? m_path : std::string{});
+
 	if (!title_id.empty())
 	{
 		m_title_id = title_id;
@@ -2674,6 +2689,7 @@ void Emulator::Resume()
 	}
 
 	perf_stat_base::report();
+	jit_runtime::report_code_stats();
 
 	auto on_select = [](u32, cpu_thread& cpu)
 	{
@@ -3044,7 +3060,9 @@ void Emulator::Kill(bool allow_autoexit, bool savestate, savestate_stage* save_s
 			}
 
 			to_ar = std::make_unique<utils::serial>();
-			to_ar->m_file_handler = make_compressed_serialization_file_handler(file.file);
+			to_ar->m_file_handler = make_block_compressed_serialization_file_handler(file.file, static_cast<u32>(g_cfg.savestate.compression_level.get()));
+
+			vm::snapshot_prepare_save(path);
 
 			signal_system_cache_can_stay();
 			break;
@@ -3216,7 +3234,7 @@ void Emulator::Kill(bool allow_autoexit, bool savestate, savestate_stage* save_s
 
 			fs::stat_t file_stat{};
 
-			if (!file.commit() || !fs::get_stat(path, file_stat))
+			if (!vm::snapshot_commit(file) || !fs::get_stat(path, file_stat))
 			{
 				sys_log.error("Failed to write savestate to file! (path='%s', %s)", path, fs::g_tls_error);
 				savestate = false;
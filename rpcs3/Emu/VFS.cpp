@@ -31,6 +31,24 @@ struct vfs_manager
 
 	// VFS root
 	vfs_directory root{};
+
+	// Resolved paths: vpath -> (host path, processed vpath), cleared on mount/unmount
+	shared_mutex cache_mutex{};
+	std::unordered_map<std::string, std::pair<std::string, std::string>, fmt::string_hash, std::equal_to<>> path_cache{};
+
+	static constexpr usz max_cached_paths = 8192;
+
+	void clear_cache()
+	{
+		std::lock_guard lock(cache_mutex);
+		path_cache.clear();
+
+		// Host metadata may depend on mount flags as well
+		if (auto stat_cache = g_fxo->try_get<lv2_fs_stat_cache>())
+		{
+			stat_cache->clear();
+		}
+	}
 };
 
 bool vfs::mount(std::string_view vpath, std::string_view path, bool is_dir)
@@ -79,6 +97,8 @@ bool vfs::mount(std::string_view vpath, std::string_view path, bool is_dir)
 			if (path == "/") // Special
 				list.back()->path = "/";
 
+			table.clear_cache();
+
 			vfs_log.notice("Mounted path \"%s\" to \"%s\"", vpath_backup, list.back()->path);
 			return true;
 		}
@@ -188,15 +208,13 @@ bool vfs::unmount(std::string_view vpath)
 	};
 	unmount_children(table.root, 0);
 
+	table.clear_cache();
+
 	return true;
 }
 
-std::string vfs::get(std::string_view vpath, std::vector<std::string>* out_dir, std::string* out_path)
+static std::string vfs_get_uncached(const vfs_manager& table, std::string_view vpath, std::vector<std::string>* out_dir, std::string* out_path)
 {
-	auto& table = g_fxo->get<vfs_manager>();
-
-	reader_lock lock(table.mutex);
-
 	// Resulting path fragments: decoded ones
 	std::vector<std::string_view> result;
 	result.reserve(vpath.size() / 2);
@@ -365,6 +383,57 @@ std::string vfs::get(std::string_view vpath, std::vector<std::string>* out_dir,
 	return std::string{result_base} + fmt::merge(escaped, "/");
 }
 
+std::string vfs::get(std::string_view vpath, std::vector<std::string>* out_dir, std::string* out_path)
+{
+	auto& table = g_fxo->get<vfs_manager>();
+
+	reader_lock lock(table.mutex);
+
+	if (out_dir)
+	{
+		// Listing mounted directories is rare, don't cache it
+		return vfs_get_uncached(table, vpath, out_dir, out_path);
+	}
+
+	{
+		reader_lock cache_lock(table.cache_mutex);
+
+		if (const auto found = table.path_cache.find(vpath); found != table.path_cache.end())
+		{
+			if (out_path)
+			{
+				*out_path = found->second.second;
+			}
+
+			return found->second.first;
+		}
+	}
+
+	std::string processed;
+	std::string result = vfs_get_uncached(table, vpath, nullptr, &processed);
+
+	if (processed.empty())
+	{
+		// Early return (e.g. relative or empty path) which leaves out_path unchanged, cheap enough not to be cached
+		return result;
+	}
+
+	if (out_path)
+	{
+		*out_path = processed;
+	}
+
+	std::lock_guard cache_lock(table.cache_mutex);
+
+	if (table.path_cache.size() >= vfs_manager::max_cached_paths)
+	{
+		table.path_cache.clear();
+	}
+
+	table.path_cache.emplace(vpath, std::make_pair(result, std::move(processed)));
+	return result;
+}
+
 using char2 = char8_t;
 
 std::string vfs::retrieve(std::string_view path, const vfs_directory* node, std::vector<std::string_view>* mount_path)
@@ -532,6 +532,21 @@ void fmt_class_string<audio_provider>::format(std::string& out, u64 arg)
 	});
 }
 
+template <>
+void fmt_class_string<audio_resampler_engine>::format(std::string& out, u64 arg)
+{
+	format_enum(out, arg, [](audio_resampler_engine value)
+	{
+		switch (value)
+		{
+		case audio_resampler_engine::soundtouch: return "SoundTouch";
+		case audio_resampler_engine::polyphase: return "Polyphase";
+		}
+
+		return unknown;
+	});
+}
+
 template <>
 void fmt_class_string<audio_avport>::format(std::string& out, u64 arg)
 {
@@ -66,6 +66,12 @@ enum class audio_provider
 	rsxaudio
 };
 
+enum class audio_resampler_engine
+{
+	soundtouch,
+	polyphase,
+};
+
 enum class audio_avport
 {
 	hdmi_0,
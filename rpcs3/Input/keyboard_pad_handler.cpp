@@ -375,6 +375,9 @@ void keyboard_pad_handler::processKeyEvent(QKeyEvent* event, bool pressed)
 			handle_key();
 		break;
 	case Qt::Key_P:
+		if (event->modifiers() != Qt::ControlModifier && event->modifiers() != Qt::AltModifier)
+			handle_key();
+		break;
 	case Qt::Key_S:
 	case Qt::Key_R:
 	case Qt::Key_E:
@@ -2,8 +2,20 @@
 
 #include "Crypto/sha1.h"
 #include "Crypto/key_vault.h"
+#include "Crypto/unself.h"
+#include "Emu/VFS.h"
+#include "Emu/vfs_config.h"
+#include "Utilities/Thread.h"
+#include "util/serialization.hpp"
+#include "util/sysinfo.hpp"
 
 #include "PUP.h"
+#include "TAR.h"
+
+#include <chrono>
+#include <span>
+
+LOG_CHANNEL(pup_log, "PUP");
 
 pup_object::pup_object(fs::file&& file) : m_file(std::move(file))
 {
@@ -113,3 +125,244 @@ pup_error pup_object::validate_hashes()
 
 	return pup_error::ok;
 }
+
+std::vector<std::string> pup_get_dev_flash_packages(tar_object& update_files)
+{
+	// Select specfic entries from the main TAR which are prefixed with "dev_flash_"
+	// Those entries are TAR as well, their packed files are what is installed in /dev_flash
+	auto update_filenames = update_files.get_filenames();
+
+	update_filenames.erase(std::remove_if(
+		update_filenames.begin(), update_filenames.end(), [](const std::string& s) { return s.find("dev_flash_") == umax; }),
+		update_filenames.end());
+
+	return update_filenames;
+}
+
+pup_install_error pup_install_dev_flash(tar_object& update_files, const std::vector<std::string>& packages, atomic_t<u32>& progress, std::string* failed_package)
+{
+	// Per-stage statistics (time is summed over all workers)
+	atomic_t<u64> read_ns = 0, read_bytes = 0;
+	atomic_t<u64> decrypt_ns = 0, decrypt_bytes = 0;
+	atomic_t<u64> extract_ns = 0, extract_bytes = 0;
+
+	// Protects update_files (scanning the TAR is not thread-safe) and the result
+	shared_mutex mutex;
+	pup_install_error result = pup_install_error::ok;
+
+	const auto fail = [&](pup_install_error error, const std::string& name)
+	{
+		std::lock_guard lock(mutex);
+
+		if (result == pup_install_error::ok)
+		{
+			result = error;
+
+			if (failed_package)
+			{
+				*failed_package = name;
+			}
+		}
+
+		// Stop other workers
+		progress = u32{umax};
+	};
+
+	const auto elapsed_ns = [](std::chrono::steady_clock::time_point& start)
+	{
+		const auto now = std::chrono::steady_clock::now();
+		const u64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+		start = now;
+		return ns;
+	};
+
+	// Every worker holds one compressed package and its decompressed TAR in memory
+	const u32 thread_count = std::min<u32>(::size32(packages), std::max<u32>(utils::get_thread_count() / 2, 1));
+
+	const auto install_start = std::chrono::steady_clock::now();
+
+	atomic_t<usz> next = 0;
+
+	named_thread_group workers("Firmware Installer "sv, thread_count, [&]()
+	{
+		for (usz index = next++; index < packages.size() && progress != umax; index = next++)
+		{
+			const std::string& name = packages[index];
+
+			auto start = std::chrono::steady_clock::now();
+
+			fs::file package_f;
+			{
+				std::lock_guard lock(mutex);
+
+				if (const auto data = update_files.get_file(name))
+				{
+					std::vector<u8> buffer(data->get_size() - data->pos);
+
+					if (data->try_read(std::span<u8>(buffer)) == 0)
+					{
+						package_f = fs::make_stream(std::move(buffer));
+					}
+				}
+			}
+
+			if (!package_f)
+			{
+				pup_log.error("Failed to read firmware package %s", name);
+				fail(pup_install_error::decrypt, name);
+				return;
+			}
+
+			read_bytes += package_f.size();
+			read_ns += elapsed_ns(start);
+
+			std::vector<fs::file> package_files;
+			{
+				SCEDecrypter self_dec(package_f);
+				self_dec.LoadHeaders();
+				self_dec.LoadMetadata(SCEPKG_ERK, SCEPKG_RIV);
+				self_dec.DecryptData();
+
+				package_files = self_dec.MakeFile();
+			}
+
+			// Only the decompressed TAR is kept while extracting
+			package_f.close();
+
+			if (package_files.size() < 3)
+			{
+				pup_log.error("Failed to decrypt firmware package %s", name);
+				fail(pup_install_error::decrypt, name);
+				return;
+			}
+
+			decrypt_bytes += package_files[2].size();
+			decrypt_ns += elapsed_ns(start);
+
+			tar_object dev_flash_tar(package_files[2]);
+
+			if (!dev_flash_tar.extract())
+			{
+				pup_log.error("Failed to extract firmware package %s", name);
+				fail(pup_install_error::extract, name);
+				return;
+			}
+
+			extract_bytes += package_files[2].size();
+			extract_ns += elapsed_ns(start);
+
+			if (!progress.try_inc(::size32(packages)))
+			{
+				// Installation was cancelled
+				return;
+			}
+		}
+	});
+
+	workers.join();
+
+	if (result == pup_install_error::ok && progress != packages.size())
+	{
+		result = pup_install_error::cancelled;
+	}
+
+	const auto mib_per_sec = [](u64 bytes, u64 ns)
+	{
+		return ns ? bytes * 1e9 / ns / (1024 * 1024) : 0.;
+	};
+
+	pup_log.notice("Firmware packages: %u/%u installed in %.3fs using %u threads (read: %.1f MiB/s, decrypt: %.1f MiB/s, extract: %.1f MiB/s)",
+		std::min<u32>(progress, ::size32(packages)), packages.size(), std::chrono::duration<f64>(std::chrono::steady_clock::now() - install_start).count(), thread_count,
+		mib_per_sec(read_bytes, read_ns), mib_per_sec(decrypt_bytes, decrypt_ns), mib_per_sec(extract_bytes, extract_ns));
+
+	return result;
+}
+
+pup_firmware::pup_firmware(fs::file&& file)
+	: pup(std::move(file))
+{
+	if (error = static_cast<pup_error>(pup); error != pup_error::ok)
+	{
+		return;
+	}
+
+	update_files_file = pup.get_file(0x300);
+
+	if (!update_files_file)
+	{
+		error = pup_error::update_files;
+		return;
+	}
+
+	update_files = std::make_unique<tar_object>(update_files_file);
+
+	// In regular installation we select specfic entries from the main TAR which are prefixed with "dev_flash_"
+	// Those entries are TAR as well, we extract their packed files from them and that's what installed in /dev_flash
+	packages = pup_get_dev_flash_packages(*update_files);
+
+	if (packages.empty())
+	{
+		error = pup_error::dev_flash_packages;
+		return;
+	}
+
+	if (fs::file version_file = pup.get_file(0x100))
+	{
+		version = version_file.to_string();
+	}
+
+	if (const usz version_pos = version.find('\n'); version_pos != umax)
+	{
+		version.erase(version_pos);
+	}
+
+	if (version.empty())
+	{
+		error = pup_error::version;
+	}
+}
+
+pup_firmware::~pup_firmware() = default;
+
+std::string pup_install_firmware(const std::string& path)
+{
+	pup_firmware fw(fs::file{path});
+
+	switch (fw.error)
+	{
+	case pup_error::ok: break;
+	case pup_error::update_files:
+	{
+		pup_log.error("Failed to install firmware: couldn't find installation packages database.");
+		return {};
+	}
+	case pup_error::dev_flash_packages:
+	{
+		pup_log.error("Failed to install firmware: no dev_flash_* packages were found.");
+		return {};
+	}
+	case pup_error::version:
+	{
+		pup_log.error("Failed to install firmware: no version data was found.");
+		return {};
+	}
+	default:
+	{
+		pup_log.error("Failed to install firmware: invalid PUP file '%s' (error=%u) %s", path, static_cast<u32>(fw.error), fw.pup.get_formatted_error());
+		return {};
+	}
+	}
+
+	// Used by tar_object::extract() as destination directory
+	vfs::mount("/dev_flash", g_cfg_vfs.get_dev_flash());
+
+	atomic_t<u32> progress = 0;
+
+	if (pup_install_dev_flash(*fw.update_files, fw.packages, progress) != pup_install_error::ok)
+	{
+		return {};
+	}
+
+	pup_log.success("Successfully installed PS3 firmware version %s.", fw.version);
+	return fw.version;
+}
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "util/types.hpp"
+#include "util/atomic.hpp"
 #include "../../Utilities/File.h"
 
+#include <memory>
 #include <vector>
 
+class tar_object;
+
 struct PUPHeader
 {
 	le_t<u64> magic;
@@ -42,6 +46,11 @@ enum class pup_error : u32
 	expected_size,
 	file_entries,
 	hash_mismatch,
+
+	// Firmware contents (pup_firmware)
+	update_files, // Installation packages database (entry 0x300) is missing
+	dev_flash_packages, // No dev_flash_* packages in the database
+	version, // Version data (entry 0x100) is missing
 };
 
 class pup_object
@@ -64,3 +73,41 @@ public:
 
 	fs::file get_file(u64 entry_id) const;
 };
+
+// Firmware package installation error
+enum class pup_install_error : u32
+{
+	ok,
+
+	cancelled,
+	decrypt, // Package could not be decrypted or decompressed
+	extract, // TAR contents could not be written to /dev_flash
+};
+
+// Get the names of dev_flash_* packages in the update files TAR (PUP entry 0x300)
+std::vector<std::string> pup_get_dev_flash_packages(tar_object& update_files);
+
+// Validated firmware file contents, shared by the installers
+struct pup_firmware
+{
+	pup_object pup;
+	pup_error error{};
+
+	fs::file update_files_file{};
+	std::unique_ptr<tar_object> update_files{}; // Set unless error is a PUP error or pup_error::update_files
+	std::vector<std::string> packages{};
+	std::string version{};
+
+	// Validate the PUP and read the installation packages database, dev_flash_* package list and firmware version
+	pup_firmware(fs::file&& file);
+	~pup_firmware();
+};
+
+// Install dev_flash_* packages into /dev_flash (which must be mounted)
+// Packages are decrypted and extracted concurrently, progress is incremented for each installed package
+// Setting progress to umax cancels the installation, failed_package receives the name of the failing package
+pup_install_error pup_install_dev_flash(tar_object& update_files, const std::vector<std::string>& packages, atomic_t<u32>& progress, std::string* failed_package = nullptr);
+
+// Install firmware from a PUP file without user interaction (for command-line usage)
+// Returns the installed firmware version or an empty string on failure
+std::string pup_install_firmware(const std::string& path);
@@ -29,6 +29,7 @@
 #include "Utilities/sema.h"
 #include "Utilities/date_time.h"
 #include "Crypto/decrypt_binaries.h"
+#include "Loader/PUP.h"
 #ifdef _WIN32
 #include "module_verifier.hpp"
 #include "util/dyn_lib.hpp"
@@ -70,6 +71,7 @@ DYNAMIC_IMPORT("ntdll.dll", NtSetTimerResolution, NTSTATUS(ULONG DesiredResoluti
 #include "rpcs3_version.h"
 #include "Emu/System.h"
 #include "Emu/system_utils.hpp"
+#include "Emu/Cell/SPURecompiler.h"
 #include <thread>
 #include <charconv>
 
@@ -281,6 +283,7 @@ struct fatal_error_listener final : logs::listener
 // Arguments that force a headless application (need to be checked in create_application)
 constexpr auto arg_headless     = "headless";
 constexpr auto arg_decrypt      = "decrypt";
+constexpr auto arg_compact_spu  = "compact-spu-cache";
 constexpr auto arg_commit_db    = "get-commit-db";
 
 // Arguments that can be used with a gui application
@@ -306,6 +309,7 @@ constexpr auto arg_timer        = "high-res-timer";
 constexpr auto arg_verbose_curl = "verbose-curl";
 constexpr auto arg_any_location = "allow-any-location";
 constexpr auto arg_codecs       = "codecs";
+constexpr auto arg_binary_log   = "binary-log";
 
 int find_arg(std::string arg, int& argc, char* argv[])
 {
@@ -320,6 +324,7 @@ QCoreApplication* create_application(int& argc, char* argv[])
 {
 	if (find_arg(arg_headless, argc, argv) != -1 ||
 		find_arg(arg_decrypt, argc, argv) != -1 ||
+		find_arg(arg_compact_spu, argc, argv) != -1 ||
 		find_arg(arg_commit_db, argc, argv) != -1)
 	{
 		return new headless_application(argc, argv);
@@ -537,7 +542,8 @@ int main(int argc, char** argv)
 		}
 
 		// Limit log size to ~25% of free space
-		log_file = logs::make_file_listener(fs::get_cache_dir() + "RPCS3.log", stats.avail_free / 4);
+		// Optionally format notice and trace messages on the log writer thread
+		log_file = logs::make_file_listener(fs::get_cache_dir() + "RPCS3.log", stats.avail_free / 4, find_arg(arg_binary_log, argc, argv) != -1);
 	}
 
 	static std::unique_ptr<logs::listener> fatal_listener = std::make_unique<fatal_error_listener>();
@@ -657,12 +663,14 @@ int main(int argc, char** argv)
 	parser.addOption(config_option);
 	const QCommandLineOption input_config_option(arg_input_config, "Forces the emulator to use this input config file for CLI-booted game.", "name", "");
 	parser.addOption(input_config_option);
-	const QCommandLineOption installfw_option(arg_installfw, "Forces the emulator to install this firmware file.", "path", "");
+	const QCommandLineOption installfw_option(arg_installfw, "Forces the emulator to install this firmware file. In headless mode the firmware cache is not created, modules are compiled when they are first loaded.", "path", "");
 	parser.addOption(installfw_option);
 	const QCommandLineOption installpkg_option(arg_installpkg, "Forces the emulator to install this pkg file.", "path", "");
 	parser.addOption(installpkg_option);
 	const QCommandLineOption decrypt_option(arg_decrypt, "Decrypt PS3 binaries.", "path(s)", "");
 	parser.addOption(decrypt_option);
+	const QCommandLineOption compact_spu_option(arg_compact_spu, "Deduplicate SPU cache files and convert them to the current format.", "path(s)", "");
+	parser.addOption(compact_spu_option);
 	const QCommandLineOption user_id_option(arg_user_id, "Start RPCS3 as this user.", "user id", "");
 	parser.addOption(user_id_option);
 	const QCommandLineOption savestate_option(arg_savestate, "Path for directly loading a savestate.", "path", "");
@@ -675,6 +683,7 @@ int main(int argc, char** argv)
 	parser.addOption(QCommandLineOption(arg_commit_db, "Update commits.lst cache. Optional arguments: <path> <sha>"));
 	parser.addOption(QCommandLineOption(arg_timer, "Enable high resolution timer for better performance (windows)", "enabled", "1"));
 	parser.addOption(QCommandLineOption(arg_verbose_curl, "Enable verbose curl logging."));
+	parser.addOption(QCommandLineOption(arg_binary_log, "Format notice and trace log messages on the log writer thread."));
 	parser.addOption(QCommandLineOption(arg_any_location, "Allow RPCS3 to be run from any location. Dangerous"));
 	const QCommandLineOption codec_option(arg_codecs, "List ffmpeg codecs");
 	parser.addOption(codec_option);
@@ -1172,6 +1181,46 @@ int main(int argc, char** argv)
 		return 0;
 	}
 
+	if (parser.isSet(arg_compact_spu))
+	{
+#ifdef _WIN32
+		if (AttachConsole(ATTACH_PARENT_PROCESS) || AllocConsole())
+		{
+			[[maybe_unused]] const auto con_out = freopen("CONOUT$", "w", stdout);
+		}
+#endif
+
+		int result = 0;
+
+		for (const QString& file : parser.values(compact_spu_option))
+		{
+			const std::string src = QFileInfo(file).absoluteFilePath().toStdString();
+			std::string dst = src;
+
+			// Legacy files are migrated next to the original
+			if (const usz pos = dst.rfind("-v1-tane.dat"); pos != umax)
+			{
+				dst.replace(pos, 4, "-v2-");
+			}
+
+			if (!fs::is_file(src) || !spu_cache::compact(src, dst))
+			{
+				std::cout << "Failed to compact SPU cache: " << src << std::endl;
+				result = 1;
+				continue;
+			}
+
+			if (dst != src)
+			{
+				fs::remove_file(src);
+			}
+
+			std::cout << "Compacted SPU cache: " << dst << std::endl;
+		}
+
+		return result;
+	}
+
 	// Force install firmware or pkg first if specified through command-line
 	if (parser.isSet(arg_installfw) || parser.isSet(arg_installpkg))
 	{
@@ -1202,6 +1251,26 @@ int main(int argc, char** argv)
 				report_fatal_error("Cannot perform installation. No main window found!");
 			}
 		}
+		else if (parser.isSet(arg_installfw) && !parser.isSet(arg_installpkg))
+		{
+			// Firmware installation does not need any user interaction
+			// Unlike the GUI, the firmware cache is not created here: modules are compiled on demand when a game loads them
+			const std::string version = pup_install_firmware(QFileInfo(parser.value(installfw_option)).absoluteFilePath().toStdString());
+
+			// Unmount
+			Emu.Init();
+
+			if (version.empty())
+			{
+				report_fatal_error("Firmware installation failed! Check the log for details.");
+			}
+
+			std::cout << "Installed firmware version " << version << std::endl;
+
+			// Nothing else to do in headless mode
+			Emu.Quit(true);
+			return 0;
+		}
 		else
 		{
 			report_fatal_error("Cannot perform installation in headless mode!");
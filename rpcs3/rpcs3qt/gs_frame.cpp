@@ -10,6 +10,7 @@
 #include "Emu/system_config.h"
 #include "Emu/system_progress.hpp"
 #include "Emu/IdManager.h"
+#include "Emu/CPU/CPUThread.h"
 #include "Emu/Cell/Modules/cellScreenshot.h"
 #include "Emu/Cell/Modules/cellVideoOut.h"
 #include "Emu/Cell/Modules/cellAudio.h"
@@ -256,6 +257,8 @@ void gs_frame::keyPressEvent(QKeyEvent *keyEvent)
 	{
 		if (keyEvent->modifiers() == Qt::ControlModifier)
 			handle_shortcut(gui::shortcuts::shortcut::gw_pause_play, {});
+		else if (keyEvent->modifiers() == Qt::AltModifier)
+			handle_shortcut(gui::shortcuts::shortcut::gw_toggle_profiler, {});
 		break;
 	}
 	case Qt::Key_S:
@@ -410,6 +413,14 @@ void gs_frame::handle_shortcut(gui::shortcuts::shortcut shortcut_key, const QKey
 		gui_log.warning("%s boost mode", g_disable_frame_limit.load() ? "Enabled" : "Disabled");
 		break;
 	}
+	case gui::shortcuts::shortcut::gw_toggle_profiler:
+	{
+		if (!m_disable_kb_hotkeys && !Emu.IsStopped())
+		{
+			gui_log.warning("%s profiler capture session", cpu_thread::toggle_profiler() ? "Started" : "Stopped");
+		}
+		break;
+	}
 	default:
 	{
 		break;
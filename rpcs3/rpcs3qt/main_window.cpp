@@ -1376,9 +1376,10 @@ void main_window::HandlePupInstallation(const QString& file_path, const QString&
 		return;
 	}
 
-	pup_object pup(std::move(pup_f));
+	pup_firmware fw(std::move(pup_f));
+	const pup_object& pup = fw.pup;
 
-	switch (pup.operator pup_error())
+	switch (fw.error)
 	{
 	case pup_error::header_read:
 	{
@@ -1419,19 +1420,29 @@ void main_window::HandlePupInstallation(const QString& file_path, const QString&
 		critical(tr("Firmware installation failed: The provided file's contents are corrupted."));
 		return;
 	}
-	case pup_error::ok: break;
-	}
-
-	fs::file update_files_f = pup.get_file(0x300);
-
-	if (!update_files_f)
+	case pup_error::update_files:
 	{
 		gui_log.error("Error while installing firmware: Couldn't find installation packages database.");
 		critical(tr("Firmware installation failed: The provided file's contents are corrupted."));
 		return;
 	}
+	case pup_error::dev_flash_packages:
+	case pup_error::version:
+	{
+		// Not needed for extraction
+		if (!dir_path.isEmpty())
+		{
+			break;
+		}
+
+		gui_log.error("Error while installing firmware: %s", fw.error == pup_error::version ? "No version data was found." : "No dev_flash_* packages were found.");
+		critical(tr("Firmware installation failed: The provided file's contents are corrupted."));
+		return;
+	}
+	case pup_error::ok: break;
+	}
 
-	tar_object update_files(update_files_f);
+	tar_object& update_files = *fw.update_files;
 
 	if (!dir_path.isEmpty())
 	{
@@ -1454,43 +1465,11 @@ void main_window::HandlePupInstallation(const QString& file_path, const QString&
 		return;
 	}
 
-	// In regular installation we select specfic entries from the main TAR which are prefixed with "dev_flash_"
-	// Those entries are TAR as well, we extract their packed files from them and that's what installed in /dev_flash
-
-	auto update_filenames = update_files.get_filenames();
-
-	update_filenames.erase(std::remove_if(
-		update_filenames.begin(), update_filenames.end(), [](const std::string& s) { return s.find("dev_flash_") == umax; }),
-		update_filenames.end());
-
-	if (update_filenames.empty())
-	{
-		gui_log.error("Error while installing firmware: No dev_flash_* packages were found.");
-		critical(tr("Firmware installation failed: The provided file's contents are corrupted."));
-		return;
-	}
+	const std::vector<std::string>& update_filenames = fw.packages;
+	const std::string& version_string = fw.version;
 
 	static constexpr std::string_view cur_version = "4.90";
 
-	std::string version_string;
-
-	if (fs::file version = pup.get_file(0x100))
-	{
-		version_string = version.to_string();
-	}
-
-	if (const usz version_pos = version_string.find('\n'); version_pos != umax)
-	{
-		version_string.erase(version_pos);
-	}
-
-	if (version_string.empty())
-	{
-		gui_log.error("Error while installing firmware: No version data was found.");
-		critical(tr("Firmware installation failed: The provided file's contents are corrupted."));
-		return;
-	}
-
 	if (version_string < cur_version &&
 		QMessageBox::question(this, tr("RPCS3 Firmware Installer"), tr("Old firmware detected.\nThe newest firmware version is %1 and you are trying to install version %2\nContinue installation?").arg(QString::fromUtf8(cur_version.data(), ::size32(cur_version)), qstr(version_string)),
 			QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes) == QMessageBox::No)
@@ -1525,41 +1504,27 @@ void main_window::HandlePupInstallation(const QString& file_path, const QString&
 		// Run asynchronously
 		named_thread worker("Firmware Installer", [&]
 		{
-			for (const auto& update_filename : update_filenames)
-			{
-				fs::file update_file = update_files.get_file(update_filename);
-
-				SCEDecrypter self_dec(update_file);
-				self_dec.LoadHeaders();
-				self_dec.LoadMetadata(SCEPKG_ERK, SCEPKG_RIV);
-				self_dec.DecryptData();
-
-				auto dev_flash_tar_f = self_dec.MakeFile();
-				if (dev_flash_tar_f.size() < 3)
-				{
-					gui_log.error("Error while installing firmware: PUP contents are invalid.");
-					critical(tr("Firmware installation failed: Firmware could not be decompressed"));
-					progress = -1;
-					return;
-				}
-
-				tar_object dev_flash_tar(dev_flash_tar_f[2]);
-				if (!dev_flash_tar.extract())
-				{
-					gui_log.error("Error while installing firmware: TAR contents are invalid. (package=%s)", update_filename);
-					critical(tr("The firmware contents could not be extracted."
-						"\nThis is very likely caused by external interference from a faulty anti-virus software."
-						"\nPlease add RPCS3 to your anti-virus\' whitelist or use better anti-virus software."));
+			std::string failed_package;
 
-					progress = -1;
-					return;
-				}
-
-				if (!progress.try_inc(::narrow<uint>(update_filenames.size())))
-				{
-					// Installation was cancelled
-					return;
-				}
+			switch (pup_install_dev_flash(update_files, update_filenames, progress, &failed_package))
+			{
+			case pup_install_error::decrypt:
+			{
+				gui_log.error("Error while installing firmware: PUP contents are invalid. (package=%s)", failed_package);
+				critical(tr("Firmware installation failed: Firmware could not be decompressed"));
+				break;
+			}
+			case pup_install_error::extract:
+			{
+				gui_log.error("Error while installing firmware: TAR contents are invalid. (package=%s)", failed_package);
+				critical(tr("The firmware contents could not be extracted."
+					"\nThis is very likely caused by external interference from a faulty anti-virus software."
+					"\nPlease add RPCS3 to your anti-virus\' whitelist or use better anti-virus software."));
+				break;
+			}
+			case pup_install_error::ok:
+			case pup_install_error::cancelled:
+				break;
 			}
 		});
 
@@ -1581,7 +1546,7 @@ void main_window::HandlePupInstallation(const QString& file_path, const QString&
 		worker();
 	}
 
-	update_files_f.close();
+	fw.update_files_file.close();
 
 	if (progress == update_filenames.size())
 	{
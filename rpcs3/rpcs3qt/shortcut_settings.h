@@ -36,6 +36,7 @@ namespace gui
 			gw_restart,
 			gw_rsx_capture,
 			gw_frame_limit,
+			gw_toggle_profiler,
 
 			count
 		};
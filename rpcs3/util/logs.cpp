@@ -78,6 +78,21 @@ namespace logs
 	constexpr u64 s_log_size = 32 * 1024 * 1024;
 	static_assert(s_log_size * s_log_size > s_log_size && (s_log_size & (s_log_size - 1)) == 0); // Assert on an overflowing value
 
+	// Binary log mode entry header (followed by raw text or by u64 arguments and prefix characters)
+	struct deferred_entry
+	{
+		u32 size; // Full entry size
+		u32 argc; // Argument count, -1 for raw text
+		u64 stamp;
+		const message* msg;
+		const char* fmt;
+		const fmt_type_info* sup;
+		u64 prefix_size;
+	};
+
+	// Raw text entry contains only the first two fields
+	constexpr usz s_text_entry_size = offsetof(deferred_entry, stamp);
+
 	class file_writer
 	{
 		std::thread m_writer{};
@@ -94,17 +109,52 @@ namespace logs
 
 		uchar m_zout[65536]{};
 
+		// Binary log mode state (only accessed in flush)
+		const bool m_deferred;
+		u64 m_written{0};
+		std::string m_lines;
+		std::string m_text;
+		std::string m_prefix;
+		std::vector<u64> m_args;
+
+		struct fragment
+		{
+			const void* data;
+			usz size;
+		};
+
 		// Write buffered logs immediately
 		bool flush(u64 bufv);
 
+		// Decode binary log entries and write them out as text
+		bool flush_deferred(u64 read_pos, u64 avail);
+
+		// Write data to both log files
+		void write_out(const uchar* data, usz size);
+
+		// Copy data from the ringbuffer
+		void read_ring(u64 pos, void* dst, usz size) const;
+
+		// Append data fragments as a single entry
+		void push(std::initializer_list<fragment> data);
+
 	public:
-		file_writer(const std::string& name, u64 max_size);
+		file_writer(const std::string& name, u64 max_size, bool deferred);
 
 		virtual ~file_writer();
 
 		// Append raw data
 		void log(const char* text, usz size);
 
+		// Check if the ringbuffer is available
+		bool is_active() const
+		{
+			return !!m_fptr;
+		}
+
+		// Append message to be formatted in flush (binary log mode)
+		void log_deferred(const deferred_entry& entry, const u64* args, const std::string& prefix);
+
 		// Ensure written to disk
 		void sync();
 
@@ -114,9 +164,9 @@ namespace logs
 
 	struct file_listener final : file_writer, public listener
 	{
-		file_listener(const std::string& path, u64 max_size);
+		file_listener(const std::string& path, u64 max_size, bool deferred);
 
-		~file_listener() override = default;
+		~file_listener() override;
 
 		void log(u64 stamp, const message& msg, const std::string& prefix, const std::string& text) override;
 
@@ -196,6 +246,60 @@ namespace logs
 	// Must be set to true in main()
 	static atomic_t<bool> g_init{false};
 
+	// File writer accepting deferred messages (binary log mode)
+	static atomic_t<file_writer*> g_deferred{nullptr};
+
+	// Set while log writer dispatches deferred messages: file listener output is appended here
+	static thread_local std::string* g_tls_deferred_out = nullptr;
+
+	// Format log line for the text log
+	static void append_line(std::string& text, u64 stamp, const message& msg, const std::string& prefix, const std::string& _text)
+	{
+		// Workaround for first special messages to keep backward compatibility (no level and timestamp)
+		if (stamp)
+		{
+			// Used character: U+00B7 (Middle Dot)
+			switch (msg)
+			{
+			case level::always:  text += reinterpret_cast<const char*>(u8"·A "); break;
+			case level::fatal:   text += reinterpret_cast<const char*>(u8"·F "); break;
+			case level::error:   text += reinterpret_cast<const char*>(u8"·E "); break;
+			case level::todo:    text += reinterpret_cast<const char*>(u8"·U "); break;
+			case level::success: text += reinterpret_cast<const char*>(u8"·S "); break;
+			case level::warning: text += reinterpret_cast<const char*>(u8"·W "); break;
+			case level::notice:  text += reinterpret_cast<const char*>(u8"·! "); break;
+			case level::trace:   text += reinterpret_cast<const char*>(u8"·T "); break;
+			}
+
+			// Print µs timestamp
+			const u64 hours = stamp / 3600'000'000;
+			const u64 mins = (stamp % 3600'000'000) / 60'000'000;
+			const u64 secs = (stamp % 60'000'000) / 1'000'000;
+			const u64 frac = (stamp % 1'000'000);
+			fmt::append(text, "%u:%02u:%02u.%06u ", hours, mins, secs, frac);
+		}
+
+		if (!prefix.empty())
+		{
+			text += "{";
+			text += prefix;
+			text += "} ";
+		}
+
+		if (stamp && msg->name && '\0' != *msg->name)
+		{
+			text += msg->name;
+			text += msg == level::todo ? " TODO: " : ": ";
+		}
+		else if (msg == level::todo)
+		{
+			text += "TODO: ";
+		}
+
+		text += _text;
+		text += '\n';
+	}
+
 	void reset()
 	{
 		std::lock_guard lock(g_mutex);
@@ -390,23 +494,13 @@ logs::registerer::registerer(channel& _ch)
 
 void logs::message::broadcast(const char* fmt, const fmt_type_info* sup, ...) const
 {
-	// Get timestamp
-	const u64 stamp = get_stamp();
-
-	// Notify start operation
-	g_tls_log_control(fmt, 0);
-
-	// Get text, extract va_args
-	/*constinit thread_local*/ std::string text;
+	// Extract va_args
 	/*constinit thread_local*/ std::basic_string<u64> args;
 
-	static constexpr fmt_type_info empty_sup{};
-
 	usz args_count = 0;
 	for (auto v = sup; v && v->fmt_string; v++)
 		args_count++;
 
-	text.reserve(50000);
 	args.resize(args_count);
 
 	va_list c_args;
@@ -414,7 +508,25 @@ void logs::message::broadcast(const char* fmt, const fmt_type_info* sup, ...) co
 	for (u64& arg : args)
 		arg = va_arg(c_args, u64);
 	va_end(c_args);
-	fmt::raw_append(text, fmt, sup ? sup : &empty_sup, args.data());
+
+	broadcast_args(fmt, sup, args.data());
+}
+
+void logs::message::broadcast_args(const char* fmt, const fmt_type_info* sup, const u64* args) const
+{
+	// Get timestamp
+	const u64 stamp = get_stamp();
+
+	// Notify start operation
+	g_tls_log_control(fmt, 0);
+
+	// Get text
+	/*constinit thread_local*/ std::string text;
+
+	static constexpr fmt_type_info empty_sup{};
+
+	text.reserve(50000);
+	fmt::raw_append(text, fmt, sup ? sup : &empty_sup, args);
 	std::string prefix = g_tls_log_prefix();
 
 	// Get first (main) listener
@@ -448,8 +560,39 @@ void logs::message::broadcast(const char* fmt, const fmt_type_info* sup, ...) co
 	g_tls_log_control(fmt, -1);
 }
 
-logs::file_writer::file_writer(const std::string& name, u64 max_size)
+void logs::message::broadcast_deferred(const char* fmt, const fmt_type_info* sup, const u64* args, usz args_count) const
+{
+	file_writer* const writer = g_deferred;
+
+	if (!writer || !g_init) [[unlikely]]
+	{
+		broadcast_args(fmt, sup, args);
+		return;
+	}
+
+	// Notify start operation
+	g_tls_log_control(fmt, 0);
+
+	const std::string prefix = g_tls_log_prefix();
+
+	deferred_entry entry{};
+	entry.argc = static_cast<u32>(args_count);
+	entry.stamp = get_stamp();
+	entry.msg = this;
+	entry.fmt = fmt;
+	entry.sup = sup;
+	entry.prefix_size = prefix.size();
+
+	// Formatting and listener notification happen on the log writer thread
+	writer->log_deferred(entry, args, prefix);
+
+	// Notify end operation
+	g_tls_log_control(fmt, -1);
+}
+
+logs::file_writer::file_writer(const std::string& name, u64 max_size, bool deferred)
 	: m_max_size(max_size)
+	, m_deferred(deferred)
 {
 	if (!name.empty() && max_size)
 	{
@@ -572,6 +715,12 @@ bool logs::file_writer::flush(u64 bufv)
 	const u64 read_pos = m_out;
 	const u64 out_index = read_pos % s_log_size;
 	const u64 pushed = (bufv / s_log_size) % s_log_size;
+
+	if (m_deferred)
+	{
+		return flush_deferred(read_pos, (pushed + s_log_size - out_index) % s_log_size);
+	}
+
 	const u64 end = std::min<u64>(out_index <= pushed ? read_pos - out_index + pushed : ((read_pos + s_log_size) & ~(s_log_size - 1)), m_max_size);
 
 	if (end > read_pos)
@@ -579,47 +728,162 @@ bool logs::file_writer::flush(u64 bufv)
 		// Avoid writing too big fragments
 		const u64 size = std::min<u64>(end - read_pos, sizeof(m_zout) / 2);
 
-		// Write uncompressed
-		if (m_fout && m_fout.write(m_fptr.get() + out_index, size) != size)
+		write_out(m_fptr.get() + out_index, size);
+
+		m_out += size;
+		return true;
+	}
+
+	return false;
+}
+
+bool logs::file_writer::flush_deferred(u64 read_pos, u64 avail)
+{
+	static constexpr fmt_type_info empty_sup{};
+
+	m_lines.clear();
+
+	u64 done = 0;
+
+	// Avoid writing too big fragments (but always decode whole entries)
+	while (done < avail && m_lines.size() < sizeof(m_zout) / 2)
+	{
+		deferred_entry entry{};
+		read_ring(read_pos + done, &entry, s_text_entry_size);
+
+		if (entry.argc == umax)
 		{
-			m_fout.close();
+			// Already formatted text
+			const usz old_size = m_lines.size();
+			m_lines.resize(old_size + entry.size - s_text_entry_size);
+			read_ring(read_pos + done + s_text_entry_size, m_lines.data() + old_size, entry.size - s_text_entry_size);
+			done += entry.size;
+			continue;
 		}
 
-		// Write compressed
-		if (m_fout2)
+		read_ring(read_pos + done, &entry, sizeof(entry));
+
+		m_args.resize(entry.argc);
+		read_ring(read_pos + done + sizeof(entry), m_args.data(), entry.argc * sizeof(u64));
+
+		m_prefix.resize(entry.prefix_size);
+		read_ring(read_pos + done + sizeof(entry) + entry.argc * sizeof(u64), m_prefix.data(), entry.prefix_size);
+
+		done += entry.size;
+
+		m_text.clear();
+		fmt::raw_append(m_text, entry.fmt, entry.sup ? entry.sup : &empty_sup, m_args.data());
+
+		// Send message to all listeners, the file listener appends to m_lines
+		g_tls_deferred_out = &m_lines;
+
+		for (listener* lis = get_logger(); lis; lis = lis->m_next)
 		{
-			m_zs.avail_in = static_cast<uInt>(size);
-			m_zs.next_in  = m_fptr.get() + out_index;
+			lis->log(entry.stamp, *entry.msg, m_prefix, m_text);
+		}
 
-			do
-			{
-				m_zs.avail_out = sizeof(m_zout);
-				m_zs.next_out  = m_zout;
+		g_tls_deferred_out = nullptr;
+	}
 
-				if (deflate(&m_zs, Z_NO_FLUSH) == Z_STREAM_ERROR || m_fout2.write(m_zout, sizeof(m_zout) - m_zs.avail_out) != sizeof(m_zout) - m_zs.avail_out)
-				{
-					deflateEnd(&m_zs);
-					m_fout2.close();
-					break;
-				}
+	if (!done)
+	{
+		return false;
+	}
+
+	if (m_written < m_max_size)
+	{
+		const usz size = std::min<u64>(m_lines.size(), m_max_size - m_written);
+		write_out(reinterpret_cast<const uchar*>(m_lines.data()), size);
+		m_written += size;
+	}
+
+	m_out += done;
+	return true;
+}
+
+void logs::file_writer::write_out(const uchar* data, usz size)
+{
+	// Write uncompressed
+	if (m_fout && m_fout.write(data, size) != size)
+	{
+		m_fout.close();
+	}
+
+	// Write compressed
+	if (m_fout2)
+	{
+		m_zs.avail_in = static_cast<uInt>(size);
+		m_zs.next_in  = const_cast<uchar*>(data);
+
+		do
+		{
+			m_zs.avail_out = sizeof(m_zout);
+			m_zs.next_out  = m_zout;
+
+			if (deflate(&m_zs, Z_NO_FLUSH) == Z_STREAM_ERROR || m_fout2.write(m_zout, sizeof(m_zout) - m_zs.avail_out) != sizeof(m_zout) - m_zs.avail_out)
+			{
+				deflateEnd(&m_zs);
+				m_fout2.close();
+				break;
 			}
-			while (m_zs.avail_out == 0);
 		}
-
-		m_out += size;
-		return true;
+		while (m_zs.avail_out == 0);
 	}
+}
 
-	return false;
+void logs::file_writer::read_ring(u64 pos, void* dst, usz size) const
+{
+	const usz index = pos % s_log_size;
+
+	if (index + size > s_log_size)
+	{
+		const usz frag = s_log_size - index;
+		std::memcpy(dst, m_fptr.get() + index, frag);
+		std::memcpy(static_cast<uchar*>(dst) + frag, m_fptr.get(), size - frag);
+	}
+	else if (size)
+	{
+		std::memcpy(dst, m_fptr.get() + index, size);
+	}
 }
 
 void logs::file_writer::log(const char* text, usz size)
+{
+	if (m_deferred)
+	{
+		// Frame raw text
+		const u32 header[2]{static_cast<u32>(size + s_text_entry_size), umax};
+		static_assert(sizeof(header) == s_text_entry_size);
+
+		push({{header, sizeof(header)}, {text, size}});
+		return;
+	}
+
+	push({{text, size}});
+}
+
+void logs::file_writer::log_deferred(const deferred_entry& entry, const u64* args, const std::string& prefix)
+{
+	deferred_entry _entry = entry;
+	_entry.size = static_cast<u32>(sizeof(entry) + entry.argc * sizeof(u64) + prefix.size());
+
+	push({{&_entry, sizeof(_entry)}, {args, entry.argc * sizeof(u64)}, {prefix.data(), prefix.size()}});
+}
+
+void logs::file_writer::push(std::initializer_list<fragment> data)
 {
 	if (!m_fptr)
 	{
 		return;
 	}
 
+	usz size = 0;
+
+	for (const fragment& frag : data)
+	{
+		size += frag.size;
+	}
+
 	// TODO: write bigger fragment directly in blocking manner
 	while (size && size < s_log_size)
 	{
@@ -640,9 +904,9 @@ void logs::file_writer::log(const char* text, usz size)
 
 		if (!pos) [[unlikely]]
 		{
-			if (m_out >= m_max_size || (!m_fout && !m_fout2))
+			if (!m_deferred && (m_out >= m_max_size || (!m_fout && !m_fout2)))
 			{
-				// Logging is inactive
+				// Logging is inactive (binary log mode still needs to deliver messages to other listeners)
 				return;
 			}
 
@@ -665,15 +929,24 @@ void logs::file_writer::log(const char* text, usz size)
 			continue;
 		}
 
-		if (pos - m_fptr.get() + size > s_log_size)
-		{
-			const auto frag = s_log_size - (pos - m_fptr.get());
-			std::memcpy(pos, text, frag);
-			std::memcpy(m_fptr.get(), text + frag, size - frag);
-		}
-		else
+		usz index = pos - m_fptr.get();
+
+		for (const fragment& frag : data)
 		{
-			std::memcpy(pos, text, size);
+			const auto src = static_cast<const uchar*>(frag.data);
+
+			if (index + frag.size > s_log_size)
+			{
+				const auto part = s_log_size - index;
+				std::memcpy(m_fptr.get() + index, src, part);
+				std::memcpy(m_fptr.get(), src + part, frag.size - part);
+			}
+			else if (frag.size)
+			{
+				std::memcpy(m_fptr.get() + index, src, frag.size);
+			}
+
+			index = (index + frag.size) % s_log_size;
 		}
 
 		m_buf += (size * s_log_size) - size;
@@ -691,7 +964,7 @@ void logs::file_writer::sync()
 	// Wait for the writer thread
 	while ((m_out % s_log_size) * s_log_size != m_buf % (s_log_size * s_log_size))
 	{
-		if (m_out >= m_max_size)
+		if (!m_deferred && m_out >= m_max_size)
 		{
 			break;
 		}
@@ -761,71 +1034,47 @@ void logs::file_writer::close_prematurely()
 	}
 }
 
-logs::file_listener::file_listener(const std::string& path, u64 max_size)
-	: file_writer(path, max_size)
+logs::file_listener::file_listener(const std::string& path, u64 max_size, bool deferred)
+	: file_writer(path, max_size, deferred)
 	, listener()
 {
 	// Write UTF-8 BOM
 	file_writer::log("\xEF\xBB\xBF", 3);
 }
 
-void logs::file_listener::log(u64 stamp, const logs::message& msg, const std::string& prefix, const std::string& _text)
+logs::file_listener::~file_listener()
 {
-	/*constinit thread_local*/ std::string text;
-	text.reserve(50000);
-
-	// Used character: U+00B7 (Middle Dot)
-	switch (msg)
-	{
-	case level::always:  text = reinterpret_cast<const char*>(u8"·A "); break;
-	case level::fatal:   text = reinterpret_cast<const char*>(u8"·F "); break;
-	case level::error:   text = reinterpret_cast<const char*>(u8"·E "); break;
-	case level::todo:    text = reinterpret_cast<const char*>(u8"·U "); break;
-	case level::success: text = reinterpret_cast<const char*>(u8"·S "); break;
-	case level::warning: text = reinterpret_cast<const char*>(u8"·W "); break;
-	case level::notice:  text = reinterpret_cast<const char*>(u8"·! "); break;
-	case level::trace:   text = reinterpret_cast<const char*>(u8"·T "); break;
-	}
-
-	// Print µs timestamp
-	const u64 hours = stamp / 3600'000'000;
-	const u64 mins = (stamp % 3600'000'000) / 60'000'000;
-	const u64 secs = (stamp % 60'000'000) / 1'000'000;
-	const u64 frac = (stamp % 1'000'000);
-	fmt::append(text, "%u:%02u:%02u.%06u ", hours, mins, secs, frac);
-
-	if (stamp == 0)
-	{
-		// Workaround for first special messages to keep backward compatibility
-		text.clear();
-	}
+	// Stop accepting deferred messages
+	g_deferred.compare_and_swap(this, nullptr);
+}
 
-	if (!prefix.empty())
+void logs::file_listener::log(u64 stamp, const logs::message& msg, const std::string& prefix, const std::string& _text)
+{
+	if (std::string* out = g_tls_deferred_out)
 	{
-		text += "{";
-		text += prefix;
-		text += "} ";
+		// Called from the log writer thread with a deferred message
+		append_line(*out, stamp, msg, prefix, _text);
+		return;
 	}
 
-	if (stamp && msg->name && '\0' != *msg->name)
-	{
-		text += msg->name;
-		text += msg == level::todo ? " TODO: " : ": ";
-	}
-	else if (msg == level::todo)
-	{
-		text += "TODO: ";
-	}
+	/*constinit thread_local*/ std::string text;
+	text.reserve(50000);
 
-	text += _text;
-	text += '\n';
+	append_line(text, stamp, msg, prefix, _text);
 
 	file_writer::log(text.data(), text.size());
 }
 
-std::unique_ptr<logs::listener> logs::make_file_listener(const std::string& path, u64 max_size)
+std::unique_ptr<logs::listener> logs::make_file_listener(const std::string& path, u64 max_size, bool binary)
 {
-	std::unique_ptr<logs::listener> result = std::make_unique<logs::file_listener>(path, max_size);
+	auto listener = std::make_unique<logs::file_listener>(path, max_size, binary);
+
+	if (binary && listener->is_active())
+	{
+		g_deferred = listener.get();
+	}
+
+	std::unique_ptr<logs::listener> result = std::move(listener);
 
 	// Register file listener
 	result->add(result.get());
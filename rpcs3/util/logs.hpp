@@ -23,6 +23,15 @@ namespace logs
 	};
 
 	struct channel;
+	class listener;
+	class file_writer;
+
+	// Argument types which are fully captured by their u64 representation (formatting can be deferred)
+	template <typename T>
+	constexpr bool is_deferrable_v = (std::is_arithmetic_v<T> || std::is_enum_v<T>) && sizeof(T) <= 8;
+
+	template <typename T, bool Se, usz Align>
+	constexpr bool is_deferrable_v<se_t<T, Se, Align>> = is_deferrable_v<T>;
 
 	// Message information
 	struct message
@@ -55,6 +64,12 @@ namespace logs
 		// Send log message to global logger instance
 		void broadcast(const char*, const fmt_type_info*, ...) const;
 
+		// Format and send log message with unpacked arguments
+		void broadcast_args(const char*, const fmt_type_info*, const u64*) const;
+
+		// Copy log message arguments to the log writer thread for formatting if binary log mode is enabled
+		void broadcast_deferred(const char*, const fmt_type_info*, const u64*, usz) const;
+
 		friend struct channel;
 	};
 
@@ -72,6 +87,7 @@ namespace logs
 		atomic_t<listener*> m_next{};
 
 		friend struct message;
+		friend class file_writer;
 
 	public:
 		constexpr listener() = default;
@@ -147,6 +163,25 @@ namespace logs
 	{
 		if (operator bool()) [[unlikely]]
 		{
+			if constexpr ((is_deferrable_v<Args> && ...))
+			{
+				// Low severity messages may be formatted later on the log writer thread
+				if (*this > level::warning)
+				{
+					if constexpr (sizeof...(Args) > 0)
+					{
+						const u64 arg_array[]{u64{fmt_unveil<Args>::get(args)}...};
+						broadcast_deferred(fmt, fmt::type_info_v<Args...>, arg_array, sizeof...(Args));
+					}
+					else
+					{
+						broadcast_deferred(fmt, nullptr, nullptr, 0);
+					}
+
+					return;
+				}
+			}
+
 			if constexpr (sizeof...(Args) > 0)
 			{
 				broadcast(fmt, fmt::type_info_v<Args...>, u64{fmt_unveil<Args>::get(args)}...);
@@ -187,8 +222,8 @@ namespace logs
 		return alt ? alt : name;
 	}
 
-	// Called in main()
-	std::unique_ptr<logs::listener> make_file_listener(const std::string& path, u64 max_size);
+	// Called in main() (binary mode: notice and trace messages are formatted on the log writer thread)
+	std::unique_ptr<logs::listener> make_file_listener(const std::string& path, u64 max_size, bool binary = false);
 
 	// Called in main()
 	void set_init(std::initializer_list<stored_message>);
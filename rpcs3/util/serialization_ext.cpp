@@ -4,12 +4,18 @@
 #include "util/simd.hpp"
 #include "util/endian.hpp"
 
+#include "util/sysinfo.hpp"
+
 #include "Utilities/lockless.h"
+#include "Utilities/mutex.h"
 #include "Utilities/File.h"
 #include "Utilities/StrFmt.h"
 #include "serialization_ext.hpp"
 
 #include <zlib.h>
+#include <deque>
+#include <map>
+#include <optional>
 
 LOG_CHANNEL(sys_log, "SYS");
 
@@ -753,6 +759,885 @@ usz compressed_serialization_file_handler::get_size(const utils::serial& ar, usz
 	return std::max<usz>(utils::mul_saturate<usz>(m_file->size(), 6), memory_available);
 }
 
+namespace
+{
+	struct block_index_entry
+	{
+		le_t<u64> pos;
+		le_t<u32> compressed_size;
+		le_t<u32> size;
+	};
+
+	struct block_index_footer
+	{
+		le_t<u64> index_pos; // File offset of the index member
+		le_t<u64> total_size; // Total uncompressed size
+		le_t<u32> block_count;
+		le_t<u32> block_size;
+		le_t<u64> magic;
+	};
+
+	// The index is stored as a gzip member of stored (uncompressed) deflate blocks so the whole file remains a valid multi-member gzip
+	// Its payload ends with the footer, which can be found at a fixed offset from the end of the file
+	constexpr usz c_gzip_header_size = 10;
+	constexpr usz c_gzip_trailer_size = 8;
+	constexpr usz c_stored_block_max = 0xffff;
+
+	constexpr usz get_index_member_size(usz block_count)
+	{
+		const usz payload = block_count * sizeof(block_index_entry) + sizeof(block_index_footer);
+		return c_gzip_header_size + payload + (payload + c_stored_block_max - 1) / c_stored_block_max * 5 + c_gzip_trailer_size;
+	}
+
+	bool compress_gzip_member(const u8* data, usz size, std::vector<u8>& out, u32 level)
+	{
+		z_stream zs{};
+#ifndef _MSC_VER
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#endif
+		if (deflateInit2(&zs, static_cast<int>(level), Z_DEFLATED, 16 + 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		{
+			return false;
+		}
+#ifndef _MSC_VER
+#pragma GCC diagnostic pop
+#endif
+
+		out.resize(::deflateBound(&zs, adjust_for_uint(size)));
+
+		zs.avail_in = adjust_for_uint(size);
+		zs.next_in = data;
+		zs.avail_out = adjust_for_uint(out.size());
+		zs.next_out = out.data();
+
+		const int res = deflate(&zs, Z_FINISH);
+
+		out.resize(zs.total_out);
+		deflateEnd(&zs);
+		return res == Z_STREAM_END;
+	}
+}
+
+struct block_compressed_stream_data
+{
+	struct block_job
+	{
+		usz index = 0;
+		std::vector<u8> data;
+	};
+
+	struct block_result
+	{
+		usz index = 0;
+		usz size = 0; // Uncompressed size
+		std::vector<u8> data; // Empty on error
+	};
+
+	lf_queue<std::vector<u8>> m_queued_data_to_process;
+	lf_queue<block_result> m_queued_data_to_write;
+
+	// Blocks pending compression (consumed by multiple threads)
+	shared_mutex m_mutex;
+	std::deque<block_job> m_jobs;
+	bool m_jobs_closed = false;
+	atomic_t<u32> m_jobs_signal = 0;
+
+	// Total amount of blocks, known after all data has been dispatched
+	atomic_t<usz> m_block_count = umax;
+};
+
+block_compressed_serialization_file_handler::block_compressed_serialization_file_handler(fs::file&& file, u32 level, u32 threads) noexcept
+	: utils::serialization_file_handler()
+	, m_file_storage(std::make_unique<fs::file>(std::move(file)))
+	, m_file(m_file_storage.get())
+	, m_level(std::min<u32>(level, 9))
+	, m_threads(threads ? threads : std::max<u32>(utils::get_thread_count(), 2) - 1)
+{
+	m_read_inited = is_block_compressed(*m_file) && read_index();
+}
+
+block_compressed_serialization_file_handler::block_compressed_serialization_file_handler(const fs::file& file, u32 level, u32 threads) noexcept
+	: utils::serialization_file_handler()
+	, m_file_storage(nullptr)
+	, m_file(std::addressof(file))
+	, m_level(std::min<u32>(level, 9))
+	, m_threads(threads ? threads : std::max<u32>(utils::get_thread_count(), 2) - 1)
+{
+	m_read_inited = is_block_compressed(*m_file) && read_index();
+}
+
+block_compressed_serialization_file_handler::~block_compressed_serialization_file_handler() = default;
+
+bool block_compressed_serialization_file_handler::is_block_compressed(const fs::file& file)
+{
+	const u64 file_size = file ? file.size() : 0;
+
+	constexpr usz tail_size = sizeof(block_index_footer) + c_gzip_trailer_size;
+
+	if (file_size < get_index_member_size(0))
+	{
+		return false;
+	}
+
+	u8 tail[tail_size];
+
+	if (file.read_at(file_size - tail_size, tail, tail_size) != tail_size)
+	{
+		return false;
+	}
+
+	const auto footer = read_from_ptr<block_index_footer>(tail);
+
+	return footer.magic == c_magic && footer.index_pos <= file_size && file_size - footer.index_pos == get_index_member_size(footer.block_count);
+}
+
+bool block_compressed_serialization_file_handler::read_index()
+{
+	const u64 file_size = m_file->size();
+
+	constexpr usz tail_size = sizeof(block_index_footer) + c_gzip_trailer_size;
+
+	u8 tail[tail_size];
+	ensure(m_file->read_at(file_size - tail_size, tail, tail_size) == tail_size);
+
+	const auto footer = read_from_ptr<block_index_footer>(tail);
+
+	if (footer.block_size != c_block_size)
+	{
+		sys_log.error("Unsupported compressed block size (0x%x)", footer.block_size);
+		return false;
+	}
+
+	std::vector<u8> member(file_size - footer.index_pos);
+
+	if (m_file->read_at(footer.index_pos, member.data(), member.size()) != member.size())
+	{
+		return false;
+	}
+
+	// Unpack stored deflate blocks
+	std::vector<u8> payload;
+	payload.reserve(member.size());
+
+	for (usz pos = c_gzip_header_size; pos + 5 <= member.size() - c_gzip_trailer_size;)
+	{
+		const u8 header = member[pos];
+		const u16 len = read_from_ptr<le_t<u16>>(member, pos + 1);
+		const u16 nlen = read_from_ptr<le_t<u16>>(member, pos + 3);
+
+		if ((header & 6) != 0 || len != static_cast<u16>(~nlen) || pos + 5 + len > member.size() - c_gzip_trailer_size)
+		{
+			return false;
+		}
+
+		payload.insert(payload.end(), member.data() + pos + 5, member.data() + pos + 5 + len);
+		pos += 5 + len;
+
+		if (header & 1)
+		{
+			break;
+		}
+	}
+
+	const u32 crc = read_from_ptr<le_t<u32>>(member, member.size() - c_gzip_trailer_size);
+
+	if (payload.size() != footer.block_count * sizeof(block_index_entry) + sizeof(block_index_footer) || crc != static_cast<u32>(::crc32(0, payload.data(), adjust_for_uint(payload.size()))))
+	{
+		sys_log.error("Compressed block index is corrupted");
+		return false;
+	}
+
+	m_blocks.resize(footer.block_count);
+
+	usz total_size = 0;
+
+	for (usz i = 0; i < m_blocks.size(); i++)
+	{
+		const auto entry = read_from_ptr<block_index_entry>(payload, i * sizeof(block_index_entry));
+
+		// Every block except the last one has to be full
+		if (entry.size > c_block_size || (i + 1 < m_blocks.size() && entry.size != c_block_size) || entry.pos + entry.compressed_size > footer.index_pos)
+		{
+			sys_log.error("Compressed block index is corrupted (block=%u)", i);
+			m_blocks.clear();
+			return false;
+		}
+
+		m_blocks[i] = {entry.pos, entry.compressed_size, entry.size};
+		total_size += entry.size;
+	}
+
+	if (total_size != footer.total_size)
+	{
+		m_blocks.clear();
+		return false;
+	}
+
+	m_total_size = total_size;
+	return true;
+}
+
+void block_compressed_serialization_file_handler::write_index()
+{
+	std::vector<u8> payload(m_blocks.size() * sizeof(block_index_entry) + sizeof(block_index_footer));
+
+	for (usz i = 0; i < m_blocks.size(); i++)
+	{
+		block_index_entry entry{};
+		entry.pos = m_blocks[i].pos;
+		entry.compressed_size = m_blocks[i].compressed_size;
+		entry.size = m_blocks[i].size;
+		write_to_ptr<block_index_entry>(payload, i * sizeof(block_index_entry), entry);
+	}
+
+	block_index_footer footer{};
+	footer.index_pos = m_write_pos;
+	footer.total_size = m_total_size;
+	footer.block_count = ::narrow<u32>(m_blocks.size());
+	footer.block_size = c_block_size;
+	footer.magic = c_magic;
+	write_to_ptr<block_index_footer>(payload, payload.size() - sizeof(block_index_footer), footer);
+
+	std::vector<u8> member{0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+	member.reserve(get_index_member_size(m_blocks.size()));
+
+	for (usz pos = 0; pos < payload.size();)
+	{
+		const usz len = std::min<usz>(payload.size() - pos, c_stored_block_max);
+		const bool last = pos + len == payload.size();
+
+		member.push_back(last ? 1 : 0);
+		member.resize(member.size() + 4);
+		write_to_ptr<le_t<u16>>(member, member.size() - 4, static_cast<u16>(len));
+		write_to_ptr<le_t<u16>>(member, member.size() - 2, static_cast<u16>(~len));
+		member.insert(member.end(), payload.data() + pos, payload.data() + pos + len);
+		pos += len;
+	}
+
+	member.resize(member.size() + c_gzip_trailer_size);
+	write_to_ptr<le_t<u32>>(member, member.size() - 8, static_cast<u32>(::crc32(0, payload.data(), adjust_for_uint(payload.size()))));
+	write_to_ptr<le_t<u32>>(member, member.size() - 4, static_cast<u32>(payload.size()));
+
+	ensure(member.size() == get_index_member_size(m_blocks.size()));
+
+	if (m_file->write(member.data(), member.size()) != member.size())
+	{
+		m_errored = true;
+	}
+}
+
+void block_compressed_serialization_file_handler::initialize(utils::serial& ar)
+{
+	if (ar.is_writing())
+	{
+		if (m_write_inited)
+		{
+			return;
+		}
+
+		if (m_read_inited)
+		{
+			// Discard reading state
+			m_read_inited = false;
+			m_blocks.clear();
+			m_block_data = {};
+			m_cached_block = umax;
+		}
+
+		m_write_inited = true;
+		m_errored = false;
+		m_write_pos = m_file->pos();
+		m_total_size = 0;
+
+		if (!ar.expect_little_data())
+		{
+			m_stream = std::make_shared<block_compressed_stream_data>();
+			m_stream_data_prepare_thread = std::make_unique<named_thread<std::function<void()>>>("Compressed Data Prepare Thread"sv, [this]() { this->stream_data_prepare_thread_op(); });
+			m_compress_threads = std::make_unique<named_thread_group<std::function<void()>>>("Compressed Data Worker "sv, m_threads, [this]() { this->compress_thread_op(); });
+			m_file_writer_thread = std::make_unique<named_thread<std::function<void()>>>("Compressed File Writer Thread"sv, [this]() { this->file_writer_thread_op(); });
+		}
+	}
+	else if (!m_read_inited && !m_errored)
+	{
+		sys_log.error("Failed to read compressed block index (ar=%s)", ar);
+		m_errored = true;
+	}
+}
+
+bool block_compressed_serialization_file_handler::handle_file_op(utils::serial& ar, usz pos, usz size, const void* data)
+{
+	if (ar.is_writing())
+	{
+		initialize(ar);
+
+		if (m_errored)
+		{
+			return false;
+		}
+
+		if (data)
+		{
+			ensure(false);
+		}
+
+		// Writing not at the end is forbidden
+		ensure(ar.pos == ar.data_offset + ar.data.size());
+
+		if (ar.data.empty())
+		{
+			return true;
+		}
+
+		ar.seek_end();
+
+		if (!m_stream)
+		{
+			// Avoid multi-threading for small files
+			for (usz offset = 0; offset < ar.data.size();)
+			{
+				const usz to_copy = std::min<usz>(c_block_size - m_block_data.size(), ar.data.size() - offset);
+				m_block_data.insert(m_block_data.end(), ar.data.data() + offset, ar.data.data() + offset + to_copy);
+				offset += to_copy;
+
+				if (m_block_data.size() == c_block_size)
+				{
+					std::vector<u8> out;
+
+					if (!compress_gzip_member(m_block_data.data(), m_block_data.size(), out, m_level))
+					{
+						m_errored = true;
+						return false;
+					}
+
+					write_block(std::move(out), m_block_data.size());
+					m_block_data.clear();
+				}
+			}
+		}
+		else
+		{
+			while (true)
+			{
+				// Avoid flooding RAM, wait if there is too much pending memory
+				const usz new_value = m_pending_bytes.atomic_op([&](usz& v)
+				{
+					v &= ~pending_data_wait_bit;
+
+					if (v >= pending_compress_bytes_bound)
+					{
+						v |= pending_data_wait_bit;
+					}
+					else
+					{
+						// Overflow detector
+						ensure(~v - pending_data_wait_bit > ar.data.size());
+
+						v += ar.data.size();
+					}
+
+					return v;
+				});
+
+				if (new_value & pending_data_wait_bit)
+				{
+					m_pending_bytes.wait(new_value);
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			m_stream->m_queued_data_to_process.push(std::move(ar.data));
+		}
+
+		ar.data_offset = ar.pos;
+		ar.data.clear();
+
+		if (pos == umax && size == umax && *m_file)
+		{
+			// Request to flush the file to disk
+			m_file->sync();
+		}
+
+		return !m_errored;
+	}
+
+	initialize(ar);
+
+	if (m_errored)
+	{
+		return false;
+	}
+
+	if (!size)
+	{
+		return true;
+	}
+
+	if (pos == 0 && size == umax)
+	{
+		// Discard loaded data until pos if profitable
+		const usz limit = ar.data_offset + ar.data.size();
+
+		if (ar.pos > ar.data_offset && ar.pos < limit)
+		{
+			const usz may_discard_bytes = ar.pos - ar.data_offset;
+			const usz moved_byte_count_on_discard = limit - ar.pos;
+
+			// Cheeck profitability (check recycled memory and std::memmove costs)
+			if (may_discard_bytes >= 0x50'0000 || (may_discard_bytes >= 0x20'0000 && moved_byte_count_on_discard / may_discard_bytes < 3))
+			{
+				ar.data_offset += may_discard_bytes;
+				ar.data.erase(ar.data.begin(), ar.data.begin() + may_discard_bytes);
+
+				if (ar.data.capacity() >= 0x200'0000)
+				{
+					// Discard memory
+					ar.data.shrink_to_fit();
+				}
+			}
+
+			return true;
+		}
+
+		// Discard all loaded data
+		ar.data_offset = ar.pos;
+		ar.data.clear();
+
+		if (ar.data.capacity() >= 0x200'0000)
+		{
+			// Discard memory
+			ar.data.shrink_to_fit();
+		}
+
+		return true;
+	}
+
+	if (~pos < size - 1)
+	{
+		// Overflow
+		return false;
+	}
+
+	if (ar.data.empty())
+	{
+		// Relocate instead of over-fetch (random access is cheap with independent blocks)
+		ar.data_offset = pos;
+	}
+
+	const usz read_pre_buffer = ar.data.empty() ? 0 : utils::sub_saturate<usz>(ar.data_offset, pos);
+
+	if (read_pre_buffer)
+	{
+		// Read past data
+		ar.data.resize(ar.data.size() + read_pre_buffer);
+		std::memmove(ar.data.data() + read_pre_buffer, ar.data.data(), ar.data.size() - read_pre_buffer);
+
+		if (read_at(pos, ar.data.data(), read_pre_buffer) != read_pre_buffer)
+		{
+			return false;
+		}
+
+		ar.data_offset -= read_pre_buffer;
+	}
+
+	// Adjustment to prevent overflow
+	const usz subtrahend = ar.data.empty() ? 0 : 1;
+	const usz read_past_buffer = utils::sub_saturate<usz>(pos + (size - subtrahend), ar.data_offset + (ar.data.size() - subtrahend));
+	const usz read_limit = utils::sub_saturate<usz>(ar.m_max_data, ar.data_offset);
+
+	if (read_past_buffer)
+	{
+		// Read proceeding data
+		// Allowed to fail, if memory is truly needed an assert would take place later
+		const usz old_size = ar.data.size();
+
+		// Try to prefetch data by reading more than requested, rounded to block boundary to avoid decompressing blocks twice
+		const usz wanted = std::max<usz>({ ar.data.capacity(), ar.data.size() + read_past_buffer * 3 / 2, ar.expect_little_data() ? usz{4096} : c_block_size });
+		const usz aligned_end = utils::align<usz>(ar.data_offset + wanted, c_block_size);
+
+		ar.data.resize(std::min<usz>(read_limit, aligned_end - ar.data_offset));
+		ar.data.resize(read_at(old_size + ar.data_offset, ar.data.data() + old_size, ar.data.size() - old_size) + old_size);
+	}
+
+	return true;
+}
+
+bool block_compressed_serialization_file_handler::decompress_block(usz index, u8* out) const
+{
+	const block_entry& block = m_blocks[index];
+
+	std::vector<u8> in(block.compressed_size);
+
+	if (m_file->read_at(block.pos, in.data(), in.size()) != in.size())
+	{
+		return false;
+	}
+
+	z_stream zs{};
+#ifndef _MSC_VER
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#endif
+	if (inflateInit2(&zs, 16 + 15) != Z_OK)
+	{
+		return false;
+	}
+#ifndef _MSC_VER
+#pragma GCC diagnostic pop
+#endif
+
+	zs.avail_in = adjust_for_uint(in.size());
+	zs.next_in = in.data();
+	zs.avail_out = block.size;
+	zs.next_out = out;
+
+	const int res = inflate(&zs, Z_FINISH);
+	const bool ok = res == Z_STREAM_END && zs.total_out == block.size;
+
+	inflateEnd(&zs);
+	return ok;
+}
+
+usz block_compressed_serialization_file_handler::read_at(usz read_pos, void* data, usz size)
+{
+	if (m_errored || read_pos >= m_total_size)
+	{
+		return 0;
+	}
+
+	size = std::min<usz>(size, m_total_size - read_pos);
+
+	if (!size)
+	{
+		return 0;
+	}
+
+	u8* const out = static_cast<u8*>(data);
+	const usz read_end = read_pos + size;
+	const usz first = read_pos / c_block_size;
+	const usz last = (read_end - 1) / c_block_size;
+
+	// Copy partially requested block using the decompressed block cache
+	auto copy_partial = [&](usz index) -> bool
+	{
+		if (m_cached_block != index)
+		{
+			m_cached_block = umax;
+			m_block_data.resize(m_blocks[index].size);
+
+			if (!decompress_block(index, m_block_data.data()))
+			{
+				return false;
+			}
+
+			m_cached_block = index;
+		}
+
+		const usz block_start = index * c_block_size;
+		const usz start = std::max<usz>(read_pos, block_start);
+		const usz end = std::min<usz>(read_end, block_start + m_blocks[index].size);
+		std::memcpy(out + (start - read_pos), m_block_data.data() + (start - block_start), end - start);
+		return true;
+	};
+
+	auto is_full = [&](usz index)
+	{
+		return index * c_block_size >= read_pos && index * c_block_size + m_blocks[index].size <= read_end;
+	};
+
+	// Blocks which are requested completely are decompressed directly into the destination
+	const usz full_begin = is_full(first) ? first : first + 1;
+	const usz full_end = is_full(last) ? last + 1 : last;
+
+	bool ok = true;
+
+	if (full_begin < full_end)
+	{
+		const usz count = full_end - full_begin;
+
+		if (count >= 4 && m_threads > 1)
+		{
+			atomic_t<usz> next = full_begin;
+			atomic_t<bool> failed = false;
+
+			named_thread_group workers("Decompress Worker "sv, static_cast<u32>(std::min<usz>(count, m_threads)), [&]()
+			{
+				for (usz i = next++; i < full_end && !failed; i = next++)
+				{
+					if (!decompress_block(i, out + (i * c_block_size - read_pos)))
+					{
+						failed = true;
+					}
+				}
+			});
+
+			workers.join();
+			ok = !failed;
+		}
+		else
+		{
+			for (usz i = full_begin; ok && i < full_end; i++)
+			{
+				ok = decompress_block(i, out + (i * c_block_size - read_pos));
+			}
+		}
+	}
+
+	// Last block is processed after the first so it stays cached for the next sequential read
+	if (ok && !is_full(first))
+	{
+		ok = copy_partial(first);
+	}
+
+	if (ok && last != first && !is_full(last))
+	{
+		ok = copy_partial(last);
+	}
+
+	if (!ok)
+	{
+		m_errored = true;
+		sys_log.error("Failure of compressed data reading. (pos=0x%x, size=0x%x, blocks=%u..%u)", read_pos, size, first, last);
+		return 0;
+	}
+
+	return size;
+}
+
+void block_compressed_serialization_file_handler::write_block(std::vector<u8>&& data, usz size)
+{
+	if (m_file->write(data.data(), data.size()) != data.size())
+	{
+		m_errored = true;
+		return;
+	}
+
+	m_blocks.emplace_back(block_entry{m_write_pos, ::narrow<u32>(data.size()), ::narrow<u32>(size)});
+	m_write_pos += data.size();
+	m_total_size += size;
+	data = {};
+}
+
+void block_compressed_serialization_file_handler::stream_data_prepare_thread_op()
+{
+	block_compressed_stream_data& stream = *m_stream;
+
+	std::vector<u8> block;
+	usz index = 0;
+
+	auto dispatch = [&]()
+	{
+		{
+			std::lock_guard lock(stream.m_mutex);
+			stream.m_jobs.push_back({index++, std::exchange(block, {})});
+		}
+
+		stream.m_jobs_signal++;
+		stream.m_jobs_signal.notify_one();
+	};
+
+	while (true)
+	{
+		stream.m_queued_data_to_process.wait();
+
+		for (auto&& data : stream.m_queued_data_to_process.pop_all())
+		{
+			if (data.empty())
+			{
+				// Abort is requested, flush data and exit
+				if (!block.empty())
+				{
+					dispatch();
+				}
+
+				{
+					std::lock_guard lock(stream.m_mutex);
+					stream.m_jobs_closed = true;
+				}
+
+				stream.m_jobs_signal++;
+				stream.m_jobs_signal.notify_all();
+
+				// Wake the writer thread in case all blocks have already been written
+				stream.m_block_count = index;
+				stream.m_queued_data_to_write.push(block_compressed_stream_data::block_result{umax});
+				return;
+			}
+
+			// Split data into fixed-size blocks
+			for (usz offset = 0; offset < data.size();)
+			{
+				if (block.empty())
+				{
+					block.reserve(c_block_size);
+				}
+
+				const usz to_copy = std::min<usz>(c_block_size - block.size(), data.size() - offset);
+				block.insert(block.end(), data.data() + offset, data.data() + offset + to_copy);
+				offset += to_copy;
+
+				if (block.size() == c_block_size)
+				{
+					dispatch();
+				}
+			}
+		}
+	}
+}
+
+void block_compressed_serialization_file_handler::compress_thread_op()
+{
+	block_compressed_stream_data& stream = *m_stream;
+
+	while (true)
+	{
+		const u32 signal = stream.m_jobs_signal;
+
+		std::optional<block_compressed_stream_data::block_job> job;
+		{
+			std::lock_guard lock(stream.m_mutex);
+
+			if (!stream.m_jobs.empty())
+			{
+				job = std::move(stream.m_jobs.front());
+				stream.m_jobs.pop_front();
+			}
+			else if (stream.m_jobs_closed)
+			{
+				return;
+			}
+		}
+
+		if (!job)
+		{
+			stream.m_jobs_signal.wait(signal);
+			continue;
+		}
+
+		std::vector<u8> out;
+
+		if (!compress_gzip_member(job->data.data(), job->data.size(), out, m_level))
+		{
+			out.clear();
+		}
+
+		stream.m_queued_data_to_write.push(block_compressed_stream_data::block_result{job->index, job->data.size(), std::move(out)});
+	}
+}
+
+void block_compressed_serialization_file_handler::file_writer_thread_op()
+{
+	block_compressed_stream_data& stream = *m_stream;
+
+	// Blocks may complete out of order
+	std::map<usz, block_compressed_stream_data::block_result> pending;
+	usz next = 0;
+
+	while (true)
+	{
+		stream.m_queued_data_to_write.wait();
+
+		for (auto&& result : stream.m_queued_data_to_write.pop_all())
+		{
+			if (result.index != umax)
+			{
+				pending.emplace(result.index, std::move(result));
+			}
+		}
+
+		for (auto it = pending.begin(); it != pending.end() && it->first == next; it = pending.erase(it), next++)
+		{
+			const usz size = it->second.size;
+
+			if (it->second.data.empty())
+			{
+				m_errored = true;
+			}
+			else if (!m_errored)
+			{
+				write_block(std::move(it->second.data), size);
+			}
+
+			it->second.data = {}; // Deallocate before notification
+
+			const usz new_val = m_pending_bytes.sub_fetch(size);
+			const usz left = new_val & ~pending_data_wait_bit;
+
+			if (new_val & pending_data_wait_bit && left < pending_compress_bytes_bound)
+			{
+				m_pending_bytes.notify_all();
+			}
+		}
+
+		if (next == stream.m_block_count)
+		{
+			return;
+		}
+	}
+}
+
+void block_compressed_serialization_file_handler::finalize(utils::serial& ar)
+{
+	handle_file_op(ar, 0, umax, nullptr);
+
+	if (!m_write_inited)
+	{
+		m_block_data = {};
+		m_cached_block = umax;
+		return;
+	}
+
+	if (m_stream)
+	{
+		m_stream->m_queued_data_to_process.push(std::vector<u8>());
+
+		// Join here to avoid log messages in the destructor
+		(*m_stream_data_prepare_thread)();
+		m_compress_threads->join();
+		(*m_file_writer_thread)();
+
+		m_stream_data_prepare_thread.reset();
+		m_compress_threads.reset();
+		m_file_writer_thread.reset();
+		m_stream.reset();
+	}
+	else if (!m_block_data.empty() && !m_errored)
+	{
+		std::vector<u8> out;
+
+		if (compress_gzip_member(m_block_data.data(), m_block_data.size(), out, m_level))
+		{
+			write_block(std::move(out), m_block_data.size());
+		}
+		else
+		{
+			m_errored = true;
+		}
+	}
+
+	if (!m_errored)
+	{
+		write_index();
+	}
+
+	m_block_data = {};
+	m_write_inited = false;
+	ar.data = {}; // Deallocate and clear
+}
+
+usz block_compressed_serialization_file_handler::get_size(const utils::serial& ar, usz /*recommended*/) const
+{
+	if (ar.is_writing())
+	{
+		return m_file->size();
+	}
+
+	return std::max<usz>(m_total_size, ar.data_offset + ar.data.size());
+}
+
 bool null_serialization_file_handler::handle_file_op(utils::serial&, usz, usz, const void*)
 {
 	return true;
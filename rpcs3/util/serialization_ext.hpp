@@ -106,13 +106,97 @@ private:
 	void blocked_compressed_write(const std::vector<u8>& data);
 };
 
+struct block_compressed_stream_data;
+
+// Block-compressed file serialization handler
+// The file is a sequence of independent gzip members of fixed uncompressed size followed by a block index member
+// Allows parallel compression and decompression, and random access on reading
+struct block_compressed_serialization_file_handler : utils::serialization_file_handler
+{
+	static constexpr u64 c_magic = "RPCS3BLK"_u64;
+	static constexpr usz c_block_size = 0x10'0000;
+
+	explicit block_compressed_serialization_file_handler(fs::file&& file, u32 level = 6, u32 threads = 0) noexcept;
+	explicit block_compressed_serialization_file_handler(const fs::file& file, u32 level = 6, u32 threads = 0) noexcept;
+
+	block_compressed_serialization_file_handler(const block_compressed_serialization_file_handler&) = delete;
+
+	~block_compressed_serialization_file_handler() override;
+
+	// Handle file read and write requests
+	bool handle_file_op(utils::serial& ar, usz pos, usz size, const void* data) override;
+
+	// Get available memory or file size
+	usz get_size(const utils::serial& ar, usz recommended) const override;
+
+	bool is_valid() const override
+	{
+		return !m_errored;
+	}
+
+	void finalize(utils::serial& ar) override;
+
+	// Check if the file contains a valid block index (does not modify file position)
+	static bool is_block_compressed(const fs::file& file);
+
+private:
+	struct block_entry
+	{
+		u64 pos; // File offset of the gzip member
+		u32 compressed_size;
+		u32 size;
+	};
+
+	const std::unique_ptr<fs::file> m_file_storage;
+	const std::add_pointer_t<const fs::file> m_file;
+	const u32 m_level;
+	const u32 m_threads;
+	std::vector<block_entry> m_blocks;
+	usz m_total_size = 0;
+	usz m_write_pos = 0;
+	std::vector<u8> m_block_data; // Pending uncompressed block (writing) or last decompressed block (reading)
+	usz m_cached_block = umax;
+	atomic_t<usz> m_pending_bytes = 0;
+	bool m_write_inited = false;
+	bool m_read_inited = false;
+	atomic_t<bool> m_errored = false;
+	std::shared_ptr<block_compressed_stream_data> m_stream;
+	std::unique_ptr<named_thread<std::function<void()>>> m_stream_data_prepare_thread;
+	std::unique_ptr<named_thread_group<std::function<void()>>> m_compress_threads;
+	std::unique_ptr<named_thread<std::function<void()>>> m_file_writer_thread;
+
+	void initialize(utils::serial& ar);
+	bool read_index();
+	void write_index();
+	usz read_at(usz read_pos, void* data, usz size);
+	bool decompress_block(usz index, u8* out) const;
+	void write_block(std::vector<u8>&& data, usz size);
+	void stream_data_prepare_thread_op();
+	void compress_thread_op();
+	void file_writer_thread_op();
+};
+
+// Creates a handler suitable for reading a compressed file: detects block-compressed files, otherwise treats it as gzip stream
 template <typename File> requires (std::is_same_v<std::remove_cvref_t<File>, fs::file>)
-inline std::unique_ptr<compressed_serialization_file_handler> make_compressed_serialization_file_handler(File&& file)
+inline std::unique_ptr<utils::serialization_file_handler> make_compressed_serialization_file_handler(File&& file)
 {
 	ensure(file);
+
+	if (block_compressed_serialization_file_handler::is_block_compressed(file))
+	{
+		return std::make_unique<block_compressed_serialization_file_handler>(std::forward<File>(file));
+	}
+
 	return std::make_unique<compressed_serialization_file_handler>(std::forward<File>(file));
 }
 
+template <typename File> requires (std::is_same_v<std::remove_cvref_t<File>, fs::file>)
+inline std::unique_ptr<block_compressed_serialization_file_handler> make_block_compressed_serialization_file_handler(File&& file, u32 level, u32 threads = 0)
+{
+	ensure(file);
+	return std::make_unique<block_compressed_serialization_file_handler>(std::forward<File>(file), level, threads);
+}
+
 // Null file serialization handler
 struct null_serialization_file_handler : utils::serialization_file_handler
 {
@@ -4,6 +4,7 @@
 #include "util/atomic.hpp"
 
 #include <string>
+#include <vector>
 
 namespace utils
 {
@@ -60,6 +61,15 @@ namespace utils
 	// Map file descriptor
 	void* memory_map_fd(native_handle fd, usz size, protection prot);
 
+	// Check if writes can be tracked without access violations (Linux userfaultfd async write-protect)
+	bool memory_track_writes_supported();
+
+	// Start (or restart) write tracking for the pages, returns false on failure
+	bool memory_track_writes(void* pointer, usz size);
+
+	// Get written ranges [begin, end) of tracked pages and restart tracking for them, returns false on failure
+	bool memory_collect_writes(void* pointer, usz size, std::vector<std::pair<u64, u64>>& written);
+
 	// Shared memory handle
 	class shm
 	{
@@ -24,7 +24,9 @@
 
 #ifdef __linux__
 #include <sys/syscall.h>
+#include <sys/ioctl.h>
 #include <linux/memfd.h>
+#include <linux/userfaultfd.h>
 
 #ifdef __NR_memfd_create
 #elif __x86_64__
@@ -459,6 +461,190 @@ namespace utils
 #endif
 	}
 
+#ifdef __linux__
+	// Kernel interfaces for async write-protect tracking (Linux 6.7+), may be missing in older headers
+	namespace uffd_wp
+	{
+		constexpr int c_user_mode_only = 1;
+		constexpr u64 c_feature_wp_hugetlbfs_shmem = 1ull << 12;
+		constexpr u64 c_feature_wp_unpopulated = 1ull << 13;
+		constexpr u64 c_feature_wp_async = 1ull << 15;
+
+		struct page_region
+		{
+			u64 start;
+			u64 end;
+			u64 categories;
+		};
+
+		struct pm_scan_arg
+		{
+			u64 size;
+			u64 flags;
+			u64 start;
+			u64 end;
+			u64 walk_end;
+			u64 vec;
+			u64 vec_len;
+			u64 max_pages;
+			u64 category_inverted;
+			u64 category_mask;
+			u64 category_anyof_mask;
+			u64 return_mask;
+		};
+
+		constexpr u64 c_page_is_written = 1ull << 1;
+		constexpr u64 c_scan_wp_matching = 1ull << 0;
+		constexpr unsigned long c_pagemap_scan = _IOWR('f', 16, pm_scan_arg);
+
+		struct tracker
+		{
+			int uffd = -1;
+			int pagemap = -1;
+
+			tracker()
+			{
+				uffd = static_cast<int>(::syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK | c_user_mode_only));
+
+				if (uffd < 0)
+				{
+					return;
+				}
+
+				// Writes are resolved by the kernel without notifying the process, written pages are queried with PAGEMAP_SCAN
+				uffdio_api api{};
+				api.api = UFFD_API;
+				api.features = c_feature_wp_async | c_feature_wp_unpopulated | c_feature_wp_hugetlbfs_shmem;
+
+				if (::ioctl(uffd, UFFDIO_API, &api) == 0)
+				{
+					pagemap = ::open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+				}
+
+				if (pagemap < 0)
+				{
+					::close(uffd);
+					uffd = -1;
+				}
+			}
+
+			~tracker()
+			{
+				if (uffd >= 0)
+				{
+					::close(pagemap);
+					::close(uffd);
+				}
+			}
+		};
+
+		static tracker& get()
+		{
+			static tracker s_tracker;
+			return s_tracker;
+		}
+	}
+#endif
+
+	bool memory_track_writes_supported()
+	{
+#ifdef __linux__
+		return uffd_wp::get().uffd >= 0;
+#else
+		return false;
+#endif
+	}
+
+	bool memory_track_writes([[maybe_unused]] void* pointer, [[maybe_unused]] usz size)
+	{
+#ifdef __linux__
+		const auto& t = uffd_wp::get();
+
+		if (t.uffd < 0)
+		{
+			return false;
+		}
+
+		const u64 ptr64 = reinterpret_cast<u64>(pointer) & -c_page_size;
+		const u64 len = utils::align<u64>(size + (reinterpret_cast<u64>(pointer) - ptr64), c_page_size);
+
+		// Registration is dropped when the memory is remapped, so it's always renewed
+		uffdio_register reg{};
+		reg.range.start = ptr64;
+		reg.range.len = len;
+		reg.mode = UFFDIO_REGISTER_MODE_WP;
+
+		if (::ioctl(t.uffd, UFFDIO_REGISTER, &reg) != 0)
+		{
+			return false;
+		}
+
+		uffdio_writeprotect wp{};
+		wp.range.start = ptr64;
+		wp.range.len = len;
+		wp.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+
+		return ::ioctl(t.uffd, UFFDIO_WRITEPROTECT, &wp) == 0;
+#else
+		return false;
+#endif
+	}
+
+	bool memory_collect_writes([[maybe_unused]] void* pointer, [[maybe_unused]] usz size, std::vector<std::pair<u64, u64>>& written)
+	{
+		written.clear();
+
+#ifdef __linux__
+		const auto& t = uffd_wp::get();
+
+		if (t.pagemap < 0)
+		{
+			return false;
+		}
+
+		const u64 end = utils::align<u64>(reinterpret_cast<u64>(pointer) + size, c_page_size);
+
+		uffd_wp::page_region regions[32];
+
+		uffd_wp::pm_scan_arg arg{};
+		arg.size = sizeof(arg);
+		arg.flags = uffd_wp::c_scan_wp_matching;
+		arg.start = reinterpret_cast<u64>(pointer) & -c_page_size;
+		arg.end = end;
+		arg.vec = reinterpret_cast<u64>(+regions);
+		arg.vec_len = std::size(regions);
+		arg.category_mask = uffd_wp::c_page_is_written;
+		arg.return_mask = uffd_wp::c_page_is_written;
+
+		while (arg.start < end)
+		{
+			const int count = ::ioctl(t.pagemap, uffd_wp::c_pagemap_scan, &arg);
+
+			if (count < 0)
+			{
+				return false;
+			}
+
+			for (int i = 0; i < count; i++)
+			{
+				written.emplace_back(regions[i].start, regions[i].end);
+			}
+
+			if (static_cast<u64>(count) < arg.vec_len || arg.walk_end <= arg.start)
+			{
+				break;
+			}
+
+			// Continue if the output buffer was exhausted
+			arg.start = arg.walk_end;
+		}
+
+		return true;
+#else
+		return false;
+#endif
+	}
+
 	shm::shm(u64 size, u32 flags)
 		: m_flags(flags)
 		, m_size(utils::align(size, 0x10000))